@@ -18,6 +18,7 @@
  * - StorageError: Error handling class
  * - File: Abstract base class for file operations
  * - Folder: Abstract base class for folder operations
+ * - StoragePath: Compact path string used by File and Folder
  * - FileMode: Enum for file opening modes
  * - FilesystemType: Enum for filesystem types
  *
@@ -29,6 +30,7 @@
 
 #include "StorageCommon.h"
 #include "StorageError.h"
+#include "StoragePath.h"
 #include "StorageFile.h"
 #include "StorageFolder.h"
 
@@ -11,6 +11,7 @@
 #include <cstring>
 #include "StorageCommon.h"
 #include "StorageError.h"
+#include "StoragePath.h"
 
 // Forward declaration
 class Folder;
@@ -24,23 +25,13 @@ class Folder;
  */
 class File {
 public:
-    File() {
-        path_[0] = '\0';
-    }
+    File() {}
 
-    File(const char* path) {
-        if (path != nullptr) {
-            strncpy(path_, path, sizeof(path_) - 1);
-            path_[sizeof(path_) - 1] = '\0';
-        } else {
-            path_[0] = '\0';
-        }
-    }
+    File(const char* path) : path_(path) {}
 
-    File(const String& path) {
-        strncpy(path_, path.c_str(), sizeof(path_) - 1);
-        path_[sizeof(path_) - 1] = '\0';
-    }
+    File(const String& path) : path_(path.c_str()) {}
+
+    File(const char* directory, const char* name) : path_(directory, name) {}
 
     virtual ~File() {}
 
@@ -91,7 +82,7 @@ public:
     }
 
 protected:
-    char path_[STORAGE_MAX_PATH_LENGTH];
+    StoragePath path_;
 
     // Helper to set error if pointer is not null
     static void setErrorIfNotNull(StorageError* error, StorageErrorCode code, const char* message = nullptr) {
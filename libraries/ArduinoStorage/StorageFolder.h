@@ -12,6 +12,7 @@
 #include <vector>
 #include "StorageCommon.h"
 #include "StorageError.h"
+#include "StoragePath.h"
 #include "StorageFile.h"
 
 /**
@@ -23,23 +24,13 @@
  */
 class Folder {
 public:
-    Folder() {
-        path_[0] = '\0';
-    }
+    Folder() {}
 
-    Folder(const char* path) {
-        if (path != nullptr) {
-            strncpy(path_, path, sizeof(path_) - 1);
-            path_[sizeof(path_) - 1] = '\0';
-        } else {
-            path_[0] = '\0';
-        }
-    }
+    Folder(const char* path) : path_(path) {}
 
-    Folder(const String& path) {
-        strncpy(path_, path.c_str(), sizeof(path_) - 1);
-        path_[sizeof(path_) - 1] = '\0';
-    }
+    Folder(const String& path) : path_(path.c_str()) {}
+
+    Folder(const char* directory, const char* name) : path_(directory, name) {}
 
     virtual ~Folder() {}
 
@@ -76,7 +67,7 @@ public:
     }
 
 protected:
-    char path_[STORAGE_MAX_PATH_LENGTH];
+    StoragePath path_;
 
     // Helper to set error if pointer is not null
     static void setErrorIfNotNull(StorageError* error, StorageErrorCode code, const char* message = nullptr) {
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ARDUINO_STORAGE_PATH_H
+#define ARDUINO_STORAGE_PATH_H
+
+#include <Arduino.h>
+#include <cstring>
+#include "StorageCommon.h"
+
+/**
+ * @brief Compact owned path string used by File and Folder.
+ *
+ * Paths of up to INLINE_CAPACITY characters are stored inside the object;
+ * longer ones, up to STORAGE_MAX_PATH_LENGTH - 1 characters, are kept in
+ * an exact-size heap allocation. The object is 32 bytes on 32 bit targets,
+ * instead of a full STORAGE_MAX_PATH_LENGTH buffer, so File and Folder
+ * objects stay small and cheap to copy and move in containers.
+ *
+ * Converts implicitly to const char*, so it can be passed to C APIs
+ * directly.
+ */
+class StoragePath {
+public:
+    /// Longest path stored without a heap allocation
+    static constexpr size_t INLINE_CAPACITY = sizeof(void*) * 8 - 3;
+
+    StoragePath() : length_(0), heap_(false) {
+        local_[0] = '\0';
+    }
+
+    StoragePath(const char* path) : StoragePath() {
+        assign(path);
+    }
+
+    StoragePath(const char* directory, const char* name) : StoragePath() {
+        assign(directory, name);
+    }
+
+    StoragePath(const StoragePath& other) : StoragePath() {
+        assignLength(other.c_str(), other.length_);
+    }
+
+    StoragePath(StoragePath&& other) : length_(other.length_), heap_(other.heap_) {
+        memcpy(local_, other.local_, sizeof(local_));
+        other.length_ = 0;
+        other.heap_ = false;
+        other.local_[0] = '\0';
+    }
+
+    ~StoragePath() {
+        release();
+    }
+
+    StoragePath& operator=(const StoragePath& other) {
+        if (this != &other) {
+            assignLength(other.c_str(), other.length_);
+        }
+        return *this;
+    }
+
+    StoragePath& operator=(StoragePath&& other) {
+        if (this != &other) {
+            release();
+            length_ = other.length_;
+            heap_ = other.heap_;
+            memcpy(local_, other.local_, sizeof(local_));
+            other.length_ = 0;
+            other.heap_ = false;
+            other.local_[0] = '\0';
+        }
+        return *this;
+    }
+
+    StoragePath& operator=(const char* path) {
+        assign(path);
+        return *this;
+    }
+
+    /**
+     * @brief Replace the path. Longer paths are truncated to
+     * STORAGE_MAX_PATH_LENGTH - 1 characters.
+     * @return false if memory for a long path could not be allocated
+     */
+    bool assign(const char* path) {
+        if (path == nullptr) {
+            return assignLength("", 0);
+        }
+        return assignLength(path, strnlen(path, STORAGE_MAX_PATH_LENGTH - 1));
+    }
+
+    /**
+     * @brief Replace the path with directory/name, without a temporary buffer.
+     * @return false if memory for a long path could not be allocated
+     */
+    bool assign(const char* directory, const char* name) {
+        size_t directoryLength = directory ? strnlen(directory, STORAGE_MAX_PATH_LENGTH - 1) : 0;
+        size_t nameLength = name ? strnlen(name, STORAGE_MAX_PATH_LENGTH - 1) : 0;
+        size_t length = directoryLength + 1 + nameLength;
+        if (length > STORAGE_MAX_PATH_LENGTH - 1) {
+            length = STORAGE_MAX_PATH_LENGTH - 1;
+        }
+
+        char* buffer = reserve(length);
+        if (buffer == nullptr) {
+            return false;
+        }
+
+        // directory may alias this path, so copy it first
+        memmove(buffer, directory ? directory : "", directoryLength);
+        if (directoryLength < length) {
+            buffer[directoryLength] = '/';
+            memcpy(buffer + directoryLength + 1, name ? name : "", length - directoryLength - 1);
+        }
+        buffer[length] = '\0';
+        commit(buffer, length);
+        return true;
+    }
+
+    const char* c_str() const {
+        return heap_ ? heapBuffer() : local_;
+    }
+
+    operator const char*() const {
+        return c_str();
+    }
+
+    size_t length() const {
+        return length_;
+    }
+
+    bool empty() const {
+        return length_ == 0;
+    }
+
+private:
+    // Holds the path, or the heap pointer for long paths. Kept unaligned
+    // so the whole object packs into 8 pointers.
+    char local_[INLINE_CAPACITY + 1];
+    uint8_t length_;
+    bool heap_;
+
+    static_assert(STORAGE_MAX_PATH_LENGTH - 1 <= UINT8_MAX, "Path length must fit in length_");
+
+    bool assignLength(const char* path, size_t length) {
+        char* buffer = reserve(length);
+        if (buffer == nullptr) {
+            return false;
+        }
+        memmove(buffer, path, length);
+        buffer[length] = '\0';
+        commit(buffer, length);
+        return true;
+    }
+
+    // Returns where a path of length characters is written: the inline
+    // buffer, or a new allocation that commit() takes over
+    char* reserve(size_t length) {
+        if (length <= INLINE_CAPACITY) {
+            // The heap path being replaced may be the source, so stage the
+            // copy and let commit() move it inline
+            return heap_ ? new char[length + 1] : local_;
+        }
+        return new char[length + 1];
+    }
+
+    void commit(char* buffer, size_t length) {
+        if (buffer == local_) {
+            length_ = static_cast<uint8_t>(length);
+            return;
+        }
+
+        release();
+        if (length <= INLINE_CAPACITY) {
+            memcpy(local_, buffer, length + 1);
+            delete[] buffer;
+        } else {
+            memcpy(local_, &buffer, sizeof(buffer));
+            heap_ = true;
+        }
+        length_ = static_cast<uint8_t>(length);
+    }
+
+    char* heapBuffer() const {
+        char* buffer;
+        memcpy(&buffer, local_, sizeof(buffer));
+        return buffer;
+    }
+
+    void release() {
+        if (heap_) {
+            delete[] heapBuffer();
+            heap_ = false;
+            local_[0] = '\0';
+        }
+        length_ = 0;
+    }
+};
+
+#endif // ARDUINO_STORAGE_PATH_H
@@ -8,6 +8,12 @@ void matrixPlay(uint8_t *buf, uint32_t len);
 void matrixSetGrayscaleBits(uint8_t _max);
 void matrixGrayscaleWrite(uint8_t *buf);
 void matrixWrite(uint32_t *buf);
+typedef void (*matrixFrameCallback)(uint32_t frame, void *arg);
+int matrixPlayAsync(const uint8_t *buf, uint32_t len, uint32_t interval_ms, bool loop);
+int matrixPlaySequenceAsync(const uint32_t *frames, uint32_t count, bool loop);
+void matrixStop(void);
+bool matrixIsPlaying(void);
+void matrixSetFrameCallback(matrixFrameCallback callback, void *arg);
 };
 
 #if __has_include("ArduinoGraphics.h")
@@ -64,7 +70,7 @@ public:
 		matrixEnd();
 	}
 
-	// the irq routine supports 8 levels of grayscale (3 bits), but usually the
+	// the irq routine supports 32 levels of grayscale (5 bits), but usually the
 	// conversion tools to grayscale will convert to 256 levels (8 bits). Call
 	// this accorgingly to your source. The biggest value in the framebuffer
 	// should be 2^max_grayscale_bits - 1 (eg. 7 or 255)
@@ -81,6 +87,37 @@ public:
 		matrixPlay((uint8_t *)buf, len);
 	}
 
+	// Plays a video sequence in the background, one frame every interval_ms
+	// timed by the matrix itself, while the sketch keeps running. Videos
+	// queue up behind the one playing (up to 4); a looping one plays until
+	// another one is queued or stopPlayback() is called. Returns false if
+	// the queue is full. The buffer must stay valid while it plays.
+	bool playVideoAsync(const uint8_t *buf, uint32_t len, uint32_t interval_ms = 16,
+						bool loop = false) {
+		return matrixPlayAsync(buf, len, interval_ms, loop) == 0;
+	}
+
+	// Plays the loaded sequence in the background, like playSequence().
+	bool playSequenceAsync(bool loop = false) {
+		return matrixPlaySequenceAsync(_frames, _framesCount, loop) == 0;
+	}
+
+	// Stops background playback and empties the queue; the current frame
+	// stays on. Drawing anything also stops it.
+	void stopPlayback() {
+		matrixStop();
+	}
+
+	bool isPlaying() {
+		return matrixIsPlaying();
+	}
+
+	// Called with the index of each frame as it appears during background
+	// playback. WARNING: runs in the system work queue, keep it short.
+	void setFrameCallback(matrixFrameCallback callback, void *arg = nullptr) {
+		matrixSetFrameCallback(callback, arg);
+	}
+
 	// Draws a grayscale picture.
 	void draw(uint8_t *buf) {
 		matrixGrayscaleWrite(buf);
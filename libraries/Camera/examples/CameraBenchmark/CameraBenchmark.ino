@@ -0,0 +1,121 @@
+/*
+ * Camera Benchmark
+ *
+ * Measures the cycles per frame spent in the pixel conversions that
+ * grabFrame() applies (RGB565 byte swap and YUYV to grayscale), comparing
+ * the optimized kernels with plain per-pixel loops.
+ *
+ * Runs with any zephyr,camera device, including Zephyr's video_sw_generator
+ * on native_sim (set FRAME_WIDTH/FRAME_HEIGHT to a size it supports, e.g.
+ * 320x160).
+ *
+ * This example code is in the public domain.
+ */
+
+#include <zephyr/kernel.h>
+#include "camera.h"
+#include "camera_pixel.h"
+
+#define FRAME_WIDTH  320
+#define FRAME_HEIGHT 240
+#define ROUNDS       10
+
+Camera cam;
+uint8_t *gray;
+
+void fatal_error(const char *msg) {
+  Serial.println(msg);
+  pinMode(LED_BUILTIN, OUTPUT);
+  while (1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+  }
+}
+
+// Reference versions, one pixel per iteration
+void swap_scalar(uint8_t *buf, size_t len) {
+  uint16_t *pixels = (uint16_t *)buf;
+  for (size_t i = 0; i < len / 2; i++) {
+    pixels[i] = (pixels[i] << 8) | (pixels[i] >> 8);
+  }
+}
+
+void gray_scalar(uint8_t *dst, const uint8_t *src, size_t len) {
+  for (size_t i = 0; i < len / 2; i++) {
+    dst[i] = src[i * 2];
+  }
+}
+
+void report(const char *name, uint32_t cycles, size_t pixels) {
+  Serial.print(name);
+  Serial.print(cycles / ROUNDS);
+  Serial.print(" cycles/frame, ");
+  Serial.print((float)cycles / ROUNDS / pixels, 2);
+  Serial.println(" cycles/pixel");
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial);
+
+  if (!cam.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565)) {
+    fatal_error("Camera begin failed");
+  }
+
+  gray = (uint8_t *)malloc(FRAME_WIDTH * FRAME_HEIGHT);
+  if (gray == NULL) {
+    fatal_error("Out of memory");
+  }
+
+  Serial.print("Cycle counter: ");
+  Serial.print(sys_clock_hw_cycles_per_sec() / 1000000);
+  Serial.println(" MHz");
+}
+
+void loop() {
+  FrameBuffer fb;
+  if (!cam.grabFrame(fb)) {
+    return;
+  }
+
+  uint8_t *buf = fb.getBuffer();
+  size_t len = fb.getBufferSize();
+  size_t pixels = len / 2;
+  uint32_t start;
+  uint32_t scalar_swap = 0, fast_swap = 0, scalar_gray = 0, fast_gray = 0;
+
+  // The frame is used as test data; swapping an even number of times
+  // leaves it unchanged
+  for (int i = 0; i < ROUNDS; i++) {
+    start = k_cycle_get_32();
+    swap_scalar(buf, len);
+    scalar_swap += k_cycle_get_32() - start;
+
+    start = k_cycle_get_32();
+    camera_swap_bytes16(buf, len);
+    fast_swap += k_cycle_get_32() - start;
+
+    start = k_cycle_get_32();
+    gray_scalar(gray, buf, len);
+    scalar_gray += k_cycle_get_32() - start;
+
+    start = k_cycle_get_32();
+    camera_yuyv_to_gray(gray, buf, len);
+    fast_gray += k_cycle_get_32() - start;
+  }
+
+  cam.releaseFrame(fb);
+
+  Serial.print("\nFrame ");
+  Serial.print(FRAME_WIDTH);
+  Serial.print("x");
+  Serial.println(FRAME_HEIGHT);
+  report("  RGB565 swap, scalar: ", scalar_swap, pixels);
+  report("  RGB565 swap, kernel: ", fast_swap, pixels);
+  report("  YUYV->gray,  scalar: ", scalar_gray, pixels);
+  report("  YUYV->gray,  kernel: ", fast_gray, pixels);
+
+  delay(1000);
+}
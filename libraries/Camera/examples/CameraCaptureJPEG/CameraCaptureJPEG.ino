@@ -0,0 +1,64 @@
+/*
+ * Camera Capture JPEG
+ *
+ * Like CameraCaptureRawBytes, but sends each requested frame as a JPEG
+ * image: a 4-byte little-endian length followed by the JPEG data. The
+ * image is written to Serial in chunks while it is encoded, so no buffer
+ * for the compressed frame is needed.
+ *
+ * This example code is in the public domain.
+ */
+
+#include "camera.h"
+#include "jpeg_encoder.h"
+
+#define FRAME_WIDTH  320
+#define FRAME_HEIGHT 240
+#define QUALITY      75
+
+Camera cam;
+JPEGEncoder jpeg;
+
+void fatal_error(const char *msg) {
+  Serial.println(msg);
+  pinMode(LED_BUILTIN, OUTPUT);
+  while (1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+  }
+}
+
+bool countBytes(const uint8_t *data, size_t len, void *arg) {
+  return true;
+}
+
+bool writeSerial(const uint8_t *data, size_t len, void *arg) {
+  return Serial.write(data, len) == len;
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  if (!cam.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565)) {
+    fatal_error("Camera begin failed");
+  }
+
+  if (!jpeg.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565, QUALITY)) {
+    fatal_error("JPEG encoder begin failed");
+  }
+}
+
+void loop() {
+  FrameBuffer fb;
+  if (cam.grabFrame(fb)) {
+    if (Serial.read() == 1) {
+      // The length has to be sent first, so the frame is encoded twice:
+      // once to measure it and once to send it
+      uint32_t len = jpeg.encode(fb, countBytes);
+      Serial.write((uint8_t *)&len, sizeof(len));
+      jpeg.encode(fb, writeSerial);
+    }
+    cam.releaseFrame(fb);
+  }
+}
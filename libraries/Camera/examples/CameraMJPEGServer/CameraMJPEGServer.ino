@@ -0,0 +1,97 @@
+/*
+ * Camera MJPEG Server
+ *
+ * Streams the camera as MJPEG over HTTP. Open http://<board IP>/ in a
+ * browser or a video player (e.g. VLC) to watch it; up to
+ * MJPEG_SERVER_MAX_CLIENTS viewers can watch at the same time. The frame
+ * rate and bandwidth of every viewer are printed once a second.
+ *
+ * Enter the network name and password in arduino_secrets.h.
+ *
+ * This example code is in the public domain.
+ */
+
+#include <WiFi.h>
+#include "camera.h"
+#include "jpeg_encoder.h"
+#include "mjpeg_server.h"
+
+#include "arduino_secrets.h"
+
+#define FRAME_WIDTH  320
+#define FRAME_HEIGHT 240
+#define QUALITY      60
+
+char ssid[] = SECRET_SSID;
+char pass[] = SECRET_PASS;
+
+Camera cam;
+JPEGEncoder jpeg;
+MJPEGServer server(80);
+
+void fatal_error(const char *msg) {
+  Serial.println(msg);
+  pinMode(LED_BUILTIN, OUTPUT);
+  while (1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+  }
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial);
+
+  while (WiFi.begin(ssid, pass) != WL_CONNECTED) {
+    Serial.print("Connecting to ");
+    Serial.println(ssid);
+    delay(3000);
+  }
+
+  if (!cam.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565)) {
+    fatal_error("Camera begin failed");
+  }
+
+  if (!jpeg.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565, QUALITY)) {
+    fatal_error("JPEG encoder begin failed");
+  }
+
+  if (!server.begin(cam, jpeg)) {
+    fatal_error("Server begin failed");
+  }
+
+  Serial.print("Stream at http://");
+  Serial.print(WiFi.localIP());
+  Serial.println("/");
+}
+
+void loop() {
+  MJPEGServerStats stats;
+  server.getStats(stats);
+
+  Serial.print("Encoded ");
+  Serial.print(stats.fps, 1);
+  Serial.print(" fps, ");
+  Serial.print(stats.size);
+  Serial.println(" bytes per frame");
+
+  for (size_t i = 0; i < MJPEG_SERVER_MAX_CLIENTS; i++) {
+    MJPEGClientStats client;
+    if (!server.getClientStats(i, client) || !client.connected) {
+      continue;
+    }
+    Serial.print("  viewer ");
+    Serial.print(i);
+    Serial.print(": ");
+    Serial.print(client.fps, 1);
+    Serial.print(" fps, ");
+    Serial.print(client.bandwidth / 1024, 1);
+    Serial.print(" KB/s, ");
+    Serial.print(client.dropped);
+    Serial.println(" frames dropped");
+  }
+
+  delay(1000);
+}
@@ -0,0 +1,2 @@
+#define SECRET_SSID ""
+#define SECRET_PASS ""
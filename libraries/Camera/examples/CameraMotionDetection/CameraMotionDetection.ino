@@ -0,0 +1,69 @@
+/*
+ * Camera Motion Detection
+ *
+ * Captures grayscale frames and compares them with a background model
+ * in 8x8 pixel blocks. When something moves, the moving blocks are
+ * printed as a map together with the time the detection took.
+ *
+ * This example code is in the public domain.
+ */
+
+#include "camera.h"
+#include "camera_motion.h"
+
+#define FRAME_WIDTH  320
+#define FRAME_HEIGHT 240
+
+Camera cam;
+MotionDetector motion;
+
+void fatal_error(const char *msg) {
+  Serial.println(msg);
+  pinMode(LED_BUILTIN, OUTPUT);
+  while (1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+  }
+}
+
+void printMap() {
+  const uint8_t *map = motion.getMotionMap();
+  for (uint32_t y = 0; y < motion.getMapHeight(); y++) {
+    for (uint32_t x = 0; x < motion.getMapWidth(); x++) {
+      Serial.print(map[y * motion.getMapWidth() + x] ? '#' : '.');
+    }
+    Serial.println();
+  }
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  if (!cam.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_GRAYSCALE)) {
+    fatal_error("Camera begin failed");
+  }
+
+  if (!motion.begin(FRAME_WIDTH, FRAME_HEIGHT, 8)) {
+    fatal_error("Motion detector begin failed");
+  }
+  motion.setThreshold(20);
+  motion.setMinBlocks(4);
+}
+
+void loop() {
+  FrameBuffer fb;
+  if (cam.grabFrame(fb)) {
+    bool moved = motion.update(fb);
+    cam.releaseFrame(fb);
+
+    if (moved) {
+      Serial.print("Motion: ");
+      Serial.print(motion.getMotionCount());
+      Serial.print(" blocks, ");
+      Serial.print(k_cyc_to_us_floor32(motion.getCycles()));
+      Serial.println(" us");
+      printMap();
+    }
+  }
+}
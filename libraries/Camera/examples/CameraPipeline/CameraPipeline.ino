@@ -0,0 +1,84 @@
+/*
+ * Camera Pipeline
+ *
+ * Turns each camera frame into a 96x96 int8 grayscale image, the input
+ * format of typical TensorFlow Lite Micro vision models, by cropping the
+ * center square, resizing, converting and normalizing in a single pass.
+ * The cycles spent in every stage are printed for each frame.
+ *
+ * This example code is in the public domain.
+ */
+
+#include <zephyr/kernel.h>
+#include "camera.h"
+#include "frame_pipeline.h"
+
+#define FRAME_WIDTH  320
+#define FRAME_HEIGHT 240
+#define MODEL_SIZE   96
+
+Camera cam;
+FramePipeline pipeline;
+int8_t input[MODEL_SIZE * MODEL_SIZE];
+
+void fatal_error(const char *msg) {
+  Serial.println(msg);
+  pinMode(LED_BUILTIN, OUTPUT);
+  while (1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+  }
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial);
+
+  if (!cam.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565)) {
+    fatal_error("Camera begin failed");
+  }
+
+  pipeline.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_RGB565);
+  pipeline.crop((FRAME_WIDTH - FRAME_HEIGHT) / 2, 0, FRAME_HEIGHT, FRAME_HEIGHT)
+          .resize(MODEL_SIZE, MODEL_SIZE)
+          .convert(CAMERA_GRAYSCALE)
+          .normalize();
+
+  if (!pipeline.isValid() || pipeline.getOutputSize() != sizeof(input)) {
+    fatal_error("Invalid pipeline");
+  }
+}
+
+void loop() {
+  FrameBuffer fb;
+  if (!cam.grabFrame(fb)) {
+    return;
+  }
+
+  bool ok = pipeline.process(fb, (uint8_t *)input);
+  cam.releaseFrame(fb);
+  if (!ok) {
+    fatal_error("Frame processing failed");
+  }
+
+  // The model would run on input[] here
+  Serial.print("\nCenter pixel: ");
+  Serial.println(input[(MODEL_SIZE / 2) * MODEL_SIZE + MODEL_SIZE / 2]);
+
+  for (size_t i = 0; i < pipeline.getStageCount(); i++) {
+    Serial.print("  ");
+    Serial.print(pipeline.getStageName(i));
+    Serial.print(": ");
+    Serial.print(pipeline.getStageCycles(i));
+    Serial.println(" cycles");
+  }
+  Serial.print("  total: ");
+  Serial.print(pipeline.getTotalCycles());
+  Serial.print(" cycles, ");
+  Serial.print(k_cyc_to_us_floor32(pipeline.getTotalCycles()));
+  Serial.println(" us");
+
+  delay(1000);
+}
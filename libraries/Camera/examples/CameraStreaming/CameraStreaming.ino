@@ -0,0 +1,92 @@
+/*
+ * Camera Streaming
+ *
+ * Captures frames continuously in a background thread and processes them
+ * in a callback. Processing here is deliberately slow, so the camera
+ * captures faster than frames are consumed: only the newest frame is
+ * delivered and the rest are counted as dropped instead of piling up in
+ * the driver. The age of each frame when processing starts is measured
+ * from its capture timestamp.
+ *
+ * This example code is in the public domain.
+ */
+
+#include "camera.h"
+
+#define FRAME_WIDTH  320
+#define FRAME_HEIGHT 240
+
+Camera cam;
+volatile uint32_t brightness;
+volatile uint32_t latency;
+
+void fatal_error(const char *msg) {
+  Serial.println(msg);
+  pinMode(LED_BUILTIN, OUTPUT);
+  while (1) {
+      digitalWrite(LED_BUILTIN, HIGH);
+      delay(100);
+      digitalWrite(LED_BUILTIN, LOW);
+      delay(100);
+  }
+}
+
+// Runs in the capture thread for every delivered frame
+void onFrame(FrameBuffer &fb, void *arg) {
+  latency = millis() - fb.getTimestamp();
+
+  uint8_t *pixels = fb.getBuffer();
+  uint32_t len = fb.getBufferSize();
+  uint32_t sum = 0;
+
+  for (uint32_t i = 0; i < len; i++) {
+    sum += pixels[i];
+  }
+  brightness = sum / len;
+
+  // Simulate an expensive step, e.g. running a model
+  delay(100);
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial);
+
+  if (!cam.begin(FRAME_WIDTH, FRAME_HEIGHT, CAMERA_GRAYSCALE)) {
+    fatal_error("Camera begin failed");
+  }
+
+  if (!cam.startStreaming(onFrame)) {
+    fatal_error("Camera streaming failed");
+  }
+}
+
+void loop() {
+  CameraStats stats;
+  cam.getStats(stats);
+
+  Serial.print("Captured: ");
+  Serial.print(stats.captured);
+  Serial.print(", delivered: ");
+  Serial.print(stats.delivered);
+  Serial.print(", dropped: ");
+  Serial.print(stats.dropped);
+  Serial.print(", fps: ");
+  Serial.print(stats.fps, 1);
+  Serial.print(", brightness: ");
+  Serial.println(brightness);
+
+  Serial.print("Wait: ");
+  Serial.print(stats.wait_us);
+  Serial.print(" us, convert: ");
+  Serial.print(stats.convert_us);
+  Serial.print(" us, interval: ");
+  Serial.print(stats.interval_us);
+  Serial.print(" us, jitter: ");
+  Serial.print(stats.jitter_us);
+  Serial.print(" us, latency: ");
+  Serial.print(latency);
+  Serial.println(" ms");
+
+  delay(1000);
+}
@@ -18,13 +18,76 @@
  */
 #include "Arduino.h"
 #include "camera.h"
+#include "camera_pixel.h"
 
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/video.h>
 #include <zephyr/drivers/video-controls.h>
 
-FrameBuffer::FrameBuffer() : vbuf(NULL) {
+#ifndef CAMERA_STREAM_STACK_SIZE
+#define CAMERA_STREAM_STACK_SIZE 4096
+#endif
+
+// Same priority as loop(), so frame callbacks never preempt the sketch
+#ifndef CAMERA_STREAM_PRIORITY
+#define CAMERA_STREAM_PRIORITY CONFIG_MAIN_THREAD_PRIORITY
+#endif
+
+// Capture thread state. There is a single capture thread, so only one
+// camera can stream at a time.
+K_THREAD_STACK_DEFINE(camera_stream_stack, CAMERA_STREAM_STACK_SIZE);
+static struct {
+	struct k_thread thread;
+	struct k_mutex lock;
+	struct k_sem ready;
+	Camera *camera;
+	CameraFrameCallback callback;
+	void *arg;
+	volatile bool stop;
+	// Newest undelivered frame, for grabFrame() when there is no callback
+	FrameBuffer latest;
+	volatile uint32_t captured;
+	volatile uint32_t delivered;
+	volatile uint32_t dropped;
+	uint32_t window_start;
+	uint32_t window_frames;
+	volatile float fps;
+} stream;
+
+// Smallest frame size of a capability that contains width x height.
+static bool fit_format_cap(const struct video_format_cap *fcap, uint32_t width, uint32_t height,
+						   uint32_t *fit_width, uint32_t *fit_height) {
+	uint32_t w = MAX(width, fcap->width_min);
+	uint32_t h = MAX(height, fcap->height_min);
+
+	if (fcap->width_step > 1) {
+		w = fcap->width_min + ROUND_UP(w - fcap->width_min, fcap->width_step);
+	}
+	if (fcap->height_step > 1) {
+		h = fcap->height_min + ROUND_UP(h - fcap->height_min, fcap->height_step);
+	}
+
+	if (w > fcap->width_max || h > fcap->height_max) {
+		return false;
+	}
+
+	*fit_width = w;
+	*fit_height = h;
+	return true;
+}
+
+// Running average over about the last 16 samples.
+static inline void average(uint32_t *avg, uint32_t sample) {
+	*avg = *avg ? *avg + ((int32_t)(sample - *avg) / 16) : sample;
+}
+
+// Left edge of a centered window, on a pixel pair so YUYV stays aligned.
+static inline uint32_t crop_left(uint32_t frame_width, uint32_t width) {
+	return ((frame_width - width) / 2) & ~1u;
+}
+
+FrameBuffer::FrameBuffer() : vbuf(NULL), timestamp(0), sequence(0) {
 }
 
 uint32_t FrameBuffer::getBufferSize() {
@@ -43,7 +106,19 @@ uint8_t *FrameBuffer::getBuffer() {
 	return NULL;
 }
 
-Camera::Camera() : byte_swap(false), yuv_to_gray(false), vdev(NULL) {
+uint32_t FrameBuffer::getTimestamp() {
+	return this->timestamp;
+}
+
+uint32_t FrameBuffer::getSequence() {
+	return this->sequence;
+}
+
+Camera::Camera()
+	: byte_swap(false), yuv_to_gray(false), streaming(false), crop(false), crop_offset(0),
+	  crop_pitch(0), crop_row_len(0), crop_rows(0), sequence(0), last_dequeue(0),
+	  pending_frames(0), empty_poll(false), wait_cycles(0), convert_cycles(0), interval_cycles(0),
+	  jitter_cycles(0), vdev(NULL) {
 	for (size_t i = 0; i < ARRAY_SIZE(this->vbuf); i++) {
 		this->vbuf[i] = NULL;
 	}
@@ -58,51 +133,115 @@ bool Camera::begin(uint32_t width, uint32_t height, uint32_t pixformat, bool byt
 		return false;
 	}
 
+	// Sensor formats to try, in order of preference
+	uint32_t formats[2] = {0, 0};
+	this->byte_swap = false;
+	this->yuv_to_gray = false;
 	switch (pixformat) {
 	case CAMERA_RGB565:
 		this->byte_swap = byte_swap;
-		pixformat = VIDEO_PIX_FMT_RGB565;
+		formats[0] = VIDEO_PIX_FMT_RGB565;
 		break;
 	case CAMERA_GRAYSCALE:
-		// There's no support for mono sensors.
-		this->yuv_to_gray = true;
-		pixformat = VIDEO_PIX_FMT_YUYV;
+		formats[0] = VIDEO_PIX_FMT_GREY;
+		formats[1] = VIDEO_PIX_FMT_YUYV;
+		break;
+	case CAMERA_YUYV:
+		formats[0] = VIDEO_PIX_FMT_YUYV;
 		break;
 	default:
+		formats[0] = pixformat;
 		break;
 	}
 
 	// Get capabilities
 	struct video_caps caps;
+	caps.type = VIDEO_BUF_TYPE_OUTPUT;
 	if (video_get_caps(this->vdev, &caps)) {
 		return false;
 	}
 
-	for (size_t i = 0; caps.format_caps[i].pixelformat != 0; i++) {
-		const struct video_format_cap *fcap = &caps.format_caps[i];
-		if (fcap->width_min == width && fcap->height_min == height &&
-			fcap->pixelformat == pixformat) {
-			break;
-		}
-		if (caps.format_caps[i + 1].pixelformat == 0) {
-			Serial.println("The specified format is not supported");
-			return false;
+	// Pick the smallest frame size that contains the requested one
+	struct video_format fmt = {};
+	for (size_t f = 0; f < ARRAY_SIZE(formats) && formats[f] && !fmt.pixelformat; f++) {
+		for (size_t i = 0; caps.format_caps[i].pixelformat != 0; i++) {
+			const struct video_format_cap *fcap = &caps.format_caps[i];
+			uint32_t fit_width, fit_height;
+			if (fcap->pixelformat != formats[f] ||
+				!fit_format_cap(fcap, width, height, &fit_width, &fit_height)) {
+				continue;
+			}
+			if (!fmt.pixelformat || fit_width * fit_height < fmt.width * fmt.height) {
+				fmt.pixelformat = fcap->pixelformat;
+				fmt.width = fit_width;
+				fmt.height = fit_height;
+			}
 		}
 	}
 
-	// Set format.
-	static struct video_format fmt = {
-		.pixelformat = pixformat,
-		.width = width,
-		.height = height,
-		.pitch = width * 2,
-	};
+	if (!fmt.pixelformat) {
+		Serial.println("The specified format is not supported");
+		return false;
+	}
+
+	// Buffer sizes and cropping need a fixed number of bytes per pixel,
+	// which compressed formats such as JPEG don't have
+	uint32_t bits_per_pixel = video_bits_per_pixel(fmt.pixelformat);
+	if (bits_per_pixel == 0 || bits_per_pixel % BITS_PER_BYTE) {
+		Serial.println("The specified format is not supported");
+		return false;
+	}
+
+	uint32_t bytes_per_pixel = bits_per_pixel / BITS_PER_BYTE;
+	fmt.type = VIDEO_BUF_TYPE_OUTPUT;
+	fmt.pitch = fmt.width * bytes_per_pixel;
 
 	if (video_set_format(this->vdev, &fmt)) {
 		Serial.println("Failed to set video format");
 		return false;
 	}
 
+	// Let the sensor send only the requested window, if it can
+	if (fmt.width != width || fmt.height != height) {
+		struct video_selection sel = {};
+		sel.type = VIDEO_BUF_TYPE_OUTPUT;
+		sel.target = VIDEO_SEL_TGT_CROP;
+		sel.rect.left = crop_left(fmt.width, width);
+		sel.rect.top = (fmt.height - height) / 2;
+		sel.rect.width = width;
+		sel.rect.height = height;
+		if (video_set_selection(this->vdev, &sel) == 0 && video_get_format(this->vdev, &fmt)) {
+			Serial.println("Failed to get video format");
+			return false;
+		}
+		if (fmt.pitch == 0) {
+			fmt.pitch = fmt.width * bytes_per_pixel;
+		}
+	}
+
+	if (fmt.width < width || fmt.height < height) {
+		Serial.println("Failed to set video format");
+		return false;
+	}
+
+	// Cut out whatever the driver could not
+	this->crop_row_len = width * bytes_per_pixel;
+	this->crop_rows = height;
+	this->crop_pitch = fmt.pitch;
+	this->crop_offset = (fmt.height - height) / 2 * fmt.pitch +
+						crop_left(fmt.width, width) * bytes_per_pixel;
+	this->crop = fmt.pitch != this->crop_row_len || fmt.height != height;
+	this->yuv_to_gray = pixformat == CAMERA_GRAYSCALE && fmt.pixelformat == VIDEO_PIX_FMT_YUYV;
+
+	this->sequence = 0;
+	this->last_dequeue = 0;
+	this->pending_frames = 0;
+	this->empty_poll = false;
+	this->wait_cycles = 0;
+	this->convert_cycles = 0;
+	this->interval_cycles = 0;
+	this->jitter_cycles = 0;
+
 	// Allocate video buffers.
 	for (size_t i = 0; i < ARRAY_SIZE(this->vbuf); i++) {
 		this->vbuf[i] = video_buffer_aligned_alloc(fmt.pitch * fmt.height,
@@ -123,30 +262,86 @@ bool Camera::begin(uint32_t width, uint32_t height, uint32_t pixformat, bool byt
 	return true;
 }
 
-bool Camera::grabFrame(FrameBuffer &fb, uint32_t timeout) {
-	if (this->vdev == NULL) {
+bool Camera::dequeueFrame(FrameBuffer &fb, uint32_t timeout) {
+	uint32_t start = k_cycle_get_32();
+	if (video_dequeue(this->vdev, &fb.vbuf, K_MSEC(timeout))) {
+		this->empty_poll = true;
 		return false;
 	}
+	uint32_t now = k_cycle_get_32();
 
-	if (video_dequeue(this->vdev, &fb.vbuf, K_MSEC(timeout))) {
-		return false;
+	fb.sequence = ++this->sequence;
+	fb.timestamp = fb.vbuf->timestamp ? fb.vbuf->timestamp : k_uptime_get_32();
+
+	// A frame taken without waiting may have piled up in the driver, unless
+	// a poll since the previous frame came back empty. Only frames taken
+	// close to their arrival say how fast frames come: spread the time
+	// since the last such frame over all of the frames taken meanwhile.
+	this->pending_frames++;
+	if (timeout == 0 && !this->empty_poll) {
+		return true;
 	}
+	this->empty_poll = false;
 
-	if (this->byte_swap) {
-		uint16_t *pixels = (uint16_t *)fb.vbuf->buffer;
-		for (size_t i = 0; i < fb.vbuf->bytesused / 2; i++) {
-			pixels[i] = __REVSH(pixels[i]);
+	if (timeout) {
+		average(&this->wait_cycles, now - start);
+	}
+	if (this->last_dequeue) {
+		uint32_t interval = (now - this->last_dequeue) / this->pending_frames;
+		if (this->interval_cycles) {
+			int32_t deviation = interval - this->interval_cycles;
+			average(&this->jitter_cycles, deviation < 0 ? -deviation : deviation);
 		}
+		average(&this->interval_cycles, interval);
+	}
+	this->last_dequeue = now;
+	this->pending_frames = 0;
+	return true;
+}
+
+void Camera::convertFrame(struct video_buffer *vbuf) {
+	uint32_t start = k_cycle_get_32();
+
+	if (this->crop) {
+		vbuf->bytesused = camera_crop(vbuf->buffer, vbuf->buffer + this->crop_offset,
+									  this->crop_pitch, this->crop_row_len, this->crop_rows);
+	}
+
+	if (this->byte_swap) {
+		camera_swap_bytes16(vbuf->buffer, vbuf->bytesused);
 	}
 
 	if (this->yuv_to_gray) {
-		uint8_t *pixels = (uint8_t *)fb.vbuf->buffer;
-		for (size_t i = 0; i < fb.vbuf->bytesused / 2; i++) {
-			pixels[i] = pixels[i * 2];
+		vbuf->bytesused = camera_yuyv_to_gray(vbuf->buffer, vbuf->buffer, vbuf->bytesused);
+	}
+
+	average(&this->convert_cycles, k_cycle_get_32() - start);
+}
+
+bool Camera::grabFrame(FrameBuffer &fb, uint32_t timeout) {
+	if (this->vdev == NULL) {
+		return false;
+	}
+
+	if (this->streaming) {
+		if (stream.callback || k_sem_take(&stream.ready, K_MSEC(timeout))) {
+			return false;
+		}
+
+		k_mutex_lock(&stream.lock, K_FOREVER);
+		fb = stream.latest;
+		stream.latest.vbuf = NULL;
+		k_mutex_unlock(&stream.lock);
+
+		if (fb.vbuf == NULL) {
+			return false;
 		}
-		fb.vbuf->bytesused /= 2;
+		stream.delivered++;
+	} else if (!dequeueFrame(fb, timeout)) {
+		return false;
 	}
 
+	convertFrame(fb.vbuf);
 	return true;
 }
 
@@ -162,6 +357,130 @@ bool Camera::releaseFrame(FrameBuffer &fb) {
 	return true;
 }
 
+void Camera::streamEntry(void *p1, void *p2, void *p3) {
+	Camera *camera = (Camera *)p1;
+	FrameBuffer fb;
+	FrameBuffer newer;
+
+	while (!stream.stop) {
+		// Wake up regularly to notice stopStreaming()
+		if (!camera->dequeueFrame(fb, 100)) {
+			continue;
+		}
+		stream.captured++;
+		stream.window_frames++;
+
+		// Frames that piled up while the sketch was busy are stale; only
+		// the newest one is delivered
+		while (camera->dequeueFrame(newer, 0)) {
+			video_enqueue(camera->vdev, fb.vbuf);
+			fb = newer;
+			stream.captured++;
+			stream.window_frames++;
+			stream.dropped++;
+		}
+
+		uint32_t now = k_uptime_get_32();
+		if (now - stream.window_start >= 1000) {
+			stream.fps = stream.window_frames * 1000.0f / (now - stream.window_start);
+			stream.window_start = now;
+			stream.window_frames = 0;
+		}
+
+		if (stream.callback) {
+			camera->convertFrame(fb.vbuf);
+			stream.callback(fb, stream.arg);
+			stream.delivered++;
+			video_enqueue(camera->vdev, fb.vbuf);
+			continue;
+		}
+
+		// Replace the frame waiting for grabFrame(), if it was not taken
+		k_mutex_lock(&stream.lock, K_FOREVER);
+		if (stream.latest.vbuf) {
+			video_enqueue(camera->vdev, stream.latest.vbuf);
+			stream.dropped++;
+		}
+		stream.latest = fb;
+		k_mutex_unlock(&stream.lock);
+		k_sem_give(&stream.ready);
+	}
+}
+
+bool Camera::startStreaming(CameraFrameCallback callback, void *arg) {
+	if (this->vdev == NULL || this->streaming) {
+		return false;
+	}
+
+	k_sched_lock();
+	bool busy = stream.camera != NULL;
+	if (!busy) {
+		stream.camera = this;
+	}
+	k_sched_unlock();
+	if (busy) {
+		return false;
+	}
+
+	k_mutex_init(&stream.lock);
+	k_sem_init(&stream.ready, 0, 1);
+	stream.callback = callback;
+	stream.arg = arg;
+	stream.stop = false;
+	stream.latest.vbuf = NULL;
+	stream.captured = 0;
+	stream.delivered = 0;
+	stream.dropped = 0;
+	stream.window_start = k_uptime_get_32();
+	stream.window_frames = 0;
+	stream.fps = 0;
+
+	this->streaming = true;
+	k_thread_create(&stream.thread, camera_stream_stack,
+					K_THREAD_STACK_SIZEOF(camera_stream_stack), streamEntry, this, NULL, NULL,
+					CAMERA_STREAM_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&stream.thread, "camera_stream");
+	return true;
+}
+
+void Camera::stopStreaming() {
+	if (!this->streaming) {
+		return;
+	}
+
+	stream.stop = true;
+	k_thread_join(&stream.thread, K_FOREVER);
+
+	// Give the frame nobody grabbed back to the driver
+	if (stream.latest.vbuf) {
+		video_enqueue(this->vdev, stream.latest.vbuf);
+		stream.latest.vbuf = NULL;
+	}
+
+	this->streaming = false;
+	stream.camera = NULL;
+}
+
+bool Camera::isStreaming() {
+	return this->streaming;
+}
+
+void Camera::getStats(CameraStats &stats) {
+	stats.captured = stream.captured;
+	stats.delivered = stream.delivered;
+	stats.dropped = stream.dropped;
+	stats.fps = stream.fps;
+	stats.wait_us = k_cyc_to_us_floor32(this->wait_cycles);
+	stats.convert_us = k_cyc_to_us_floor32(this->convert_cycles);
+	stats.interval_us = k_cyc_to_us_floor32(this->interval_cycles);
+	stats.jitter_us = k_cyc_to_us_floor32(this->jitter_cycles);
+
+	// Report a stalled sensor instead of the last measured rate
+	if (k_uptime_get_32() - stream.window_start > 2000) {
+		stats.fps = 0;
+	}
+}
+
 bool Camera::setVerticalFlip(bool flip_enable) {
 	struct video_control ctrl = {.id = VIDEO_CID_VFLIP, .val = flip_enable};
 	return video_set_ctrl(this->vdev, &ctrl) == 0;
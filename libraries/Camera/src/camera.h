@@ -25,10 +25,14 @@
  * The different formats use different numbers of bits per pixel:
  * - Grayscale (8-bit)
  * - RGB565 (16-bit)
+ * - RGB888 (24-bit), produced by FramePipeline only
+ * - YUYV (16-bit, 4:2:2), as delivered by the sensor
  */
 enum CameraPixelFormat {
 	CAMERA_RGB565,    /**< RGB565 format (16-bit). */
 	CAMERA_GRAYSCALE, /**< Grayscale format (8-bit). */
+	CAMERA_RGB888,    /**< RGB888 format (24-bit, R first). */
+	CAMERA_YUYV,      /**< YUYV format (16-bit, Y0 U Y1 V). */
 };
 
 /**
@@ -38,6 +42,8 @@ enum CameraPixelFormat {
 class FrameBuffer {
 private:
 	struct video_buffer *vbuf;
+	uint32_t timestamp;
+	uint32_t sequence;
 
 public:
 	/**
@@ -60,9 +66,52 @@ public:
 	 * @return uint8_t* Pointer to the frame buffer.
 	 */
 	uint8_t *getBuffer();
+
+	/**
+	 * @brief Get the time the frame was captured.
+	 *
+	 * This is the time the driver received the frame, or the time it was
+	 * taken from the driver if the driver doesn't record it.
+	 *
+	 * @return uint32_t Capture time in milliseconds, on the millis() clock.
+	 */
+	uint32_t getTimestamp();
+
+	/**
+	 * @brief Get the sequence number of the frame.
+	 *
+	 * Frames are numbered from 1 as they are taken from the driver, so a
+	 * gap between two frames is the number of frames dropped in between.
+	 *
+	 * @return uint32_t Sequence number.
+	 */
+	uint32_t getSequence();
 	friend class Camera;
 };
 
+/**
+ * @brief Function called by the capture thread for every delivered frame.
+ *
+ * The frame is returned to the driver when the function returns, so it must
+ * not be kept. Frames captured while it runs are dropped except the newest.
+ */
+typedef void (*CameraFrameCallback)(FrameBuffer &fb, void *arg);
+
+/**
+ * @struct CameraStats
+ * @brief Frame counters of a streaming camera.
+ */
+struct CameraStats {
+	uint32_t captured;  /**< Frames dequeued from the driver. */
+	uint32_t delivered; /**< Frames passed to the callback or returned by grabFrame(). */
+	uint32_t dropped;   /**< Frames given back to the driver unseen, replaced by a newer one. */
+	float fps;          /**< Capture rate measured over the last second. */
+	uint32_t wait_us;     /**< Time spent waiting for the driver to fill a frame. */
+	uint32_t convert_us;  /**< Time spent converting a frame (crop, byte swap, grayscale). */
+	uint32_t interval_us; /**< Time between two captured frames. */
+	uint32_t jitter_us;   /**< Mean deviation of the time between frames from interval_us. */
+};
+
 /**
  * @class Camera
  * @brief The main class for controlling a camera.
@@ -71,9 +120,30 @@ class Camera {
 private:
 	bool byte_swap;
 	bool yuv_to_gray;
+	bool streaming;
+	// Window cut out of the sensor frames in software, when the driver
+	// can't deliver the requested size itself
+	bool crop;
+	uint32_t crop_offset;
+	uint32_t crop_pitch;
+	uint32_t crop_row_len;
+	uint32_t crop_rows;
+	// Frame numbering and timing, averaged over the last frames (cycles)
+	uint32_t sequence;
+	uint32_t last_dequeue;
+	uint32_t pending_frames;
+	bool empty_poll;
+	uint32_t wait_cycles;
+	uint32_t convert_cycles;
+	uint32_t interval_cycles;
+	uint32_t jitter_cycles;
 	const struct device *vdev;
 	struct video_buffer *vbuf[CONFIG_VIDEO_BUFFER_POOL_NUM_MAX];
 
+	bool dequeueFrame(FrameBuffer &fb, uint32_t timeout);
+	void convertFrame(struct video_buffer *vbuf);
+	static void streamEntry(void *p1, void *p2, void *p3);
+
 public:
 	/**
 	 * @brief Construct a new Camera object.
@@ -83,6 +153,12 @@ public:
 	/**
 	 * @brief Initialize the camera.
 	 *
+	 * Any resolution up to the sensor's largest is accepted. The sensor is
+	 * set to the smallest mode that contains it, and the center of that
+	 * mode is cropped to the requested size: by the driver where it
+	 * supports cropping, otherwise in software. Grayscale is read directly
+	 * from sensors that offer it and extracted from YUYV otherwise.
+	 *
 	 * @param width Frame width in pixels.
 	 * @param height Frame height in pixels.
 	 * @param pixformat Initial pixel format (default: CAMERA_RGB565).
@@ -95,6 +171,9 @@ public:
 	/**
 	 * @brief Capture a frame.
 	 *
+	 * While streaming without a callback, this returns the newest frame
+	 * of the capture thread; with a callback it fails.
+	 *
 	 * @param fb Reference to a FrameBuffer object to store the frame data.
 	 * @param timeout Time in milliseconds to wait for a frame (default: 5000).
 	 * @return true if the frame is successfully captured, otherwise false.
@@ -109,6 +188,59 @@ public:
 	 */
 	bool releaseFrame(FrameBuffer &fb);
 
+	/**
+	 * @brief Start capturing frames continuously in a background thread.
+	 *
+	 * With a callback, every frame is passed to it from the capture thread
+	 * and then returned to the driver automatically. Without one, the
+	 * newest frame is kept for grabFrame(), which then returns immediately
+	 * when a frame is ready; releaseFrame() must still be called.
+	 *
+	 * In both cases only the newest frame is delivered: frames that pile
+	 * up while the sketch is busy are returned to the driver and counted
+	 * as dropped. Without a callback, one buffer is held for grabFrame()
+	 * and one by the sketch, so CONFIG_VIDEO_BUFFER_POOL_NUM_MAX should be
+	 * at least 3 to keep the sensor running meanwhile.
+	 *
+	 * Only one camera can stream at a time.
+	 *
+	 * The capture thread runs at CAMERA_STREAM_PRIORITY, by default the
+	 * priority of the main thread: the callback runs only while loop()
+	 * waits or yields, and never preempts it. Define CAMERA_STREAM_PRIORITY
+	 * when building the library to change it.
+	 *
+	 * @param callback Function to receive the frames, or NULL to use grabFrame().
+	 * @param arg Argument passed to the callback.
+	 * @return true if streaming started, otherwise false.
+	 */
+	bool startStreaming(CameraFrameCallback callback = NULL, void *arg = NULL);
+
+	/**
+	 * @brief Stop the capture thread.
+	 *
+	 * Waits for a running callback to return. Frames held by the sketch
+	 * must still be released.
+	 */
+	void stopStreaming();
+
+	/**
+	 * @brief Check whether the capture thread is running.
+	 * @return true if streaming, otherwise false.
+	 */
+	bool isStreaming();
+
+	/**
+	 * @brief Get the frame counters and timings.
+	 *
+	 * The counters and the frame rate cover the time since streaming
+	 * started. The times are running averages over the last 16 or so
+	 * frames, taken from the capture thread or from grabFrame(), and are
+	 * also available without streaming.
+	 *
+	 * @param stats Receives the counters, the measured frame rate and the times.
+	 */
+	void getStats(CameraStats &stats);
+
 	/**
 	 * @brief Flip the camera image vertically.
 	 *
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Frame differencing and motion detection.
+ */
+#include "Arduino.h"
+#include "camera_motion.h"
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+// Word load from any address; a single LDR on Cortex-M.
+static inline uint32_t load32(const uint8_t *p) {
+	uint32_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+// Add the absolute differences of the four byte pairs of a and b to acc.
+static inline uint32_t sad4(uint32_t a, uint32_t b, uint32_t acc) {
+#if defined(__ARM_FEATURE_DSP)
+	return __USADA8(a, b, acc);
+#else
+	for (int i = 0; i < 4; i++, a >>= 8, b >>= 8) {
+		int32_t d = (int32_t)(a & 0xFF) - (int32_t)(b & 0xFF);
+		acc += d < 0 ? -d : d;
+	}
+	return acc;
+#endif
+}
+
+// Add the four bytes of w to acc.
+static inline uint32_t sum4(uint32_t w, uint32_t acc) {
+#if defined(__ARM_FEATURE_DSP)
+	return __USADA8(w, 0, acc);
+#else
+	w = (w & 0x00FF00FFu) + ((w >> 8) & 0x00FF00FFu);
+	return acc + (w & 0xFFFF) + (w >> 16);
+#endif
+}
+
+uint32_t camera_sad(const uint8_t *a, const uint8_t *b, size_t len) {
+	uint32_t acc = 0;
+	size_t i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+		acc = sad4(load32(a + i), load32(b + i), acc);
+		acc = sad4(load32(a + i + 4), load32(b + i + 4), acc);
+		acc = sad4(load32(a + i + 8), load32(b + i + 8), acc);
+		acc = sad4(load32(a + i + 12), load32(b + i + 12), acc);
+	}
+	for (; i + 4 <= len; i += 4) {
+		acc = sad4(load32(a + i), load32(b + i), acc);
+	}
+	for (; i < len; i++) {
+		acc += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+	}
+
+	return acc;
+}
+
+void camera_block_sad(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t height,
+					  uint32_t block, uint8_t *map) {
+	uint32_t area = block * block;
+
+	for (uint32_t y = 0; y + block <= height; y += block) {
+		for (uint32_t x = 0; x + block <= width; x += block) {
+			uint32_t acc = 0;
+			for (uint32_t r = 0; r < block; r++) {
+				const uint8_t *pa = a + (y + r) * width + x;
+				const uint8_t *pb = b + (y + r) * width + x;
+				for (uint32_t c = 0; c < block; c += 4) {
+					acc = sad4(load32(pa + c), load32(pb + c), acc);
+				}
+			}
+			*map++ = acc / area;
+		}
+	}
+}
+
+void camera_block_mean(const uint8_t *src, uint32_t width, uint32_t height, uint32_t block,
+					   uint8_t *map) {
+	uint32_t area = block * block;
+
+	for (uint32_t y = 0; y + block <= height; y += block) {
+		for (uint32_t x = 0; x + block <= width; x += block) {
+			uint32_t acc = 0;
+			for (uint32_t r = 0; r < block; r++) {
+				const uint8_t *p = src + (y + r) * width + x;
+				for (uint32_t c = 0; c < block; c += 4) {
+					acc = sum4(load32(p + c), acc);
+				}
+			}
+			*map++ = (acc + area / 2) / area;
+		}
+	}
+}
+
+MotionDetector::MotionDetector()
+	: width(0), height(0), block(0), map_width(0), map_height(0), frame(NULL), background(NULL),
+	  map(NULL), threshold(16), rate(4), min_blocks(1), primed(false), count(0), cycles(0) {
+}
+
+MotionDetector::~MotionDetector() {
+	end();
+}
+
+bool MotionDetector::begin(uint32_t width, uint32_t height, uint32_t block) {
+	end();
+
+	if (block == 0 || block % 4 || width < block || height < block) {
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->block = block;
+	this->map_width = width / block;
+	this->map_height = height / block;
+
+	size_t blocks = this->map_width * this->map_height;
+	this->frame = new uint8_t[blocks];
+	this->background = new uint16_t[blocks];
+	this->map = new uint8_t[blocks];
+	if (!this->frame || !this->background || !this->map) {
+		end();
+		return false;
+	}
+
+	reset();
+	return true;
+}
+
+void MotionDetector::end() {
+	delete[] this->frame;
+	delete[] this->background;
+	delete[] this->map;
+	this->frame = NULL;
+	this->background = NULL;
+	this->map = NULL;
+	this->map_width = 0;
+	this->map_height = 0;
+}
+
+void MotionDetector::reset() {
+	this->primed = false;
+	this->count = 0;
+	if (this->map) {
+		memset(this->map, 0, this->map_width * this->map_height);
+	}
+}
+
+void MotionDetector::setThreshold(uint8_t threshold) {
+	this->threshold = threshold;
+}
+
+void MotionDetector::setLearningRate(uint8_t shift) {
+	this->rate = shift > 8 ? 8 : shift;
+}
+
+void MotionDetector::setMinBlocks(uint32_t blocks) {
+	this->min_blocks = blocks;
+}
+
+bool MotionDetector::update(FrameBuffer &fb) {
+	if (fb.getBufferSize() < this->width * this->height) {
+		return false;
+	}
+
+	return update(fb.getBuffer());
+}
+
+bool MotionDetector::update(const uint8_t *gray) {
+	if (this->frame == NULL || gray == NULL) {
+		return false;
+	}
+
+	uint32_t start = k_cycle_get_32();
+	size_t blocks = this->map_width * this->map_height;
+
+	camera_block_mean(gray, this->width, this->height, this->block, this->frame);
+
+	if (!this->primed) {
+		for (size_t i = 0; i < blocks; i++) {
+			this->background[i] = this->frame[i] << 8;
+		}
+		this->primed = true;
+		this->cycles = k_cycle_get_32() - start;
+		return false;
+	}
+
+	uint32_t moving = 0;
+	for (size_t i = 0; i < blocks; i++) {
+		int32_t value = this->frame[i] << 8;
+		int32_t model = this->background[i];
+		int32_t diff = value - model;
+		bool motion = (diff < 0 ? -diff : diff) > (this->threshold << 8);
+
+		this->map[i] = motion ? 255 : 0;
+		moving += motion;
+
+		// Moving blocks are blended in more slowly, so the object itself
+		// does not become background right away
+		int shift = motion ? this->rate + 2 : this->rate;
+		this->background[i] = model + (diff >> shift);
+	}
+
+	this->count = moving;
+	this->cycles = k_cycle_get_32() - start;
+	return moving >= this->min_blocks;
+}
+
+const uint8_t *MotionDetector::getMotionMap() {
+	return this->map;
+}
+
+uint32_t MotionDetector::getMapWidth() {
+	return this->map_width;
+}
+
+uint32_t MotionDetector::getMapHeight() {
+	return this->map_height;
+}
+
+uint32_t MotionDetector::getMotionCount() {
+	return this->count;
+}
+
+uint32_t MotionDetector::getCycles() {
+	return this->cycles;
+}
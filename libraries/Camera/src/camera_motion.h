@@ -0,0 +1,201 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __CAMERA_MOTION_H__
+#define __CAMERA_MOTION_H__
+
+#include "camera.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Sum of absolute differences of two byte arrays.
+ *
+ * Four bytes are compared per instruction with USADA8 on cores with the
+ * DSP extension.
+ *
+ * @param a First array.
+ * @param b Second array.
+ * @param len Number of bytes.
+ * @return uint32_t Sum of |a[i] - b[i]|.
+ */
+uint32_t camera_sad(const uint8_t *a, const uint8_t *b, size_t len);
+
+/**
+ * @brief Mean absolute difference of two grayscale frames per block.
+ *
+ * Blocks that don't fit entirely in the frame are skipped.
+ *
+ * @param a First frame.
+ * @param b Second frame.
+ * @param width Frame width in pixels.
+ * @param height Frame height in pixels.
+ * @param block Block size in pixels, a multiple of 4.
+ * @param map Output of (width / block) x (height / block) bytes.
+ */
+void camera_block_sad(const uint8_t *a, const uint8_t *b, uint32_t width, uint32_t height,
+					  uint32_t block, uint8_t *map);
+
+/**
+ * @brief Downscale a grayscale frame by averaging blocks.
+ *
+ * @param src Frame.
+ * @param width Frame width in pixels.
+ * @param height Frame height in pixels.
+ * @param block Block size in pixels, a multiple of 4.
+ * @param map Output of (width / block) x (height / block) bytes.
+ */
+void camera_block_mean(const uint8_t *src, uint32_t width, uint32_t height, uint32_t block,
+					   uint8_t *map);
+
+/**
+ * @class MotionDetector
+ * @brief Detects motion in grayscale frames against a background model.
+ *
+ * Frames are reduced to one value per block, and each block is compared
+ * with a running average of its past values. Blocks that differ by more
+ * than the threshold are marked as moving. The background follows slow
+ * changes such as lighting; moving blocks are blended in four times more
+ * slowly, so an object that stops becomes background after a while.
+ *
+ * Only the reduced frame, the background and the motion map are stored,
+ * 4 bytes per block in total, and a VGA frame takes about a millisecond
+ * on a Cortex-M7.
+ *
+ * @code
+ * MotionDetector motion;
+ * motion.begin(320, 240);
+ * if (motion.update(fb)) {
+ *     Serial.println(motion.getMotionCount());
+ * }
+ * @endcode
+ */
+class MotionDetector {
+private:
+	uint32_t width;
+	uint32_t height;
+	uint32_t block;
+	uint32_t map_width;
+	uint32_t map_height;
+	uint8_t *frame;
+	uint16_t *background; // 8.8 fixed point
+	uint8_t *map;
+	uint8_t threshold;
+	uint8_t rate;
+	uint32_t min_blocks;
+	bool primed;
+	uint32_t count;
+	uint32_t cycles;
+
+public:
+	/**
+	 * @brief Construct a new MotionDetector object.
+	 */
+	MotionDetector();
+	~MotionDetector();
+
+	MotionDetector(const MotionDetector &) = delete;
+	MotionDetector &operator=(const MotionDetector &) = delete;
+
+	/**
+	 * @brief Allocate the model for frames of a given size.
+	 *
+	 * @param width Frame width in pixels.
+	 * @param height Frame height in pixels.
+	 * @param block Block size in pixels, a multiple of 4 (default: 8).
+	 * @return true on success, false if the size is invalid or out of memory.
+	 */
+	bool begin(uint32_t width, uint32_t height, uint32_t block = 8);
+
+	/**
+	 * @brief Free the model.
+	 */
+	void end();
+
+	/**
+	 * @brief Forget the background; the next frame becomes the new one.
+	 */
+	void reset();
+
+	/**
+	 * @brief Set the difference from the background that counts as motion.
+	 *
+	 * @param threshold Mean gray level difference of a block (default: 16).
+	 */
+	void setThreshold(uint8_t threshold);
+
+	/**
+	 * @brief Set how fast the background follows the frames.
+	 *
+	 * @param shift Each frame moves the background 1 / 2^shift of the way
+	 *              to the frame, from 0 (no memory) to 8 (default: 4).
+	 */
+	void setLearningRate(uint8_t shift);
+
+	/**
+	 * @brief Set how many blocks have to move to report motion.
+	 *
+	 * @param blocks Minimum number of moving blocks (default: 1).
+	 */
+	void setMinBlocks(uint32_t blocks);
+
+	/**
+	 * @brief Process a grayscale frame.
+	 *
+	 * @param fb Frame returned by Camera::grabFrame() with CAMERA_GRAYSCALE.
+	 * @return true if at least the minimum number of blocks moved.
+	 */
+	bool update(FrameBuffer &fb);
+
+	/**
+	 * @brief Process a grayscale frame.
+	 *
+	 * @param gray Frame of width x height bytes.
+	 * @return true if at least the minimum number of blocks moved.
+	 */
+	bool update(const uint8_t *gray);
+
+	/**
+	 * @brief Get the motion map of the last frame.
+	 *
+	 * @return One byte per block, row by row: 255 if moving, 0 otherwise.
+	 */
+	const uint8_t *getMotionMap();
+
+	/**
+	 * @brief Get the width of the motion map in blocks.
+	 */
+	uint32_t getMapWidth();
+
+	/**
+	 * @brief Get the height of the motion map in blocks.
+	 */
+	uint32_t getMapHeight();
+
+	/**
+	 * @brief Get the number of moving blocks in the last frame.
+	 */
+	uint32_t getMotionCount();
+
+	/**
+	 * @brief Get the cycles the last update() took.
+	 */
+	uint32_t getCycles();
+};
+
+#endif // __CAMERA_MOTION_H__
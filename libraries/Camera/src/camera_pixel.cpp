@@ -0,0 +1,119 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Pixel conversion kernels.
+ */
+#include "Arduino.h"
+#include "camera_pixel.h"
+
+#include <string.h>
+
+// Swap the bytes of both halfwords of a word.
+static inline uint32_t swap16x2(uint32_t w) {
+#if defined(CONFIG_CPU_CORTEX_M)
+	return __REV16(w);
+#else
+	return ((w & 0x00FF00FFu) << 8) | ((w >> 8) & 0x00FF00FFu);
+#endif
+}
+
+// Gather the luma bytes of two YUYV words (Y0 U0 Y1 V0, Y2 U1 Y3 V1 in
+// memory order) into one word (Y0 Y1 Y2 Y3).
+static inline uint32_t luma4(uint32_t w0, uint32_t w1) {
+#if defined(__ARM_FEATURE_DSP)
+	uint32_t a = __UXTB16(w0); // Y0 | Y1 << 16
+	uint32_t b = __UXTB16(w1); // Y2 | Y3 << 16
+	return __PKHBT(a, b, 16) | (__PKHTB(b, a, 16) << 8);
+#else
+	uint32_t a = w0 & 0x00FF00FFu;
+	uint32_t b = w1 & 0x00FF00FFu;
+	a = (a | (a >> 8)) & 0xFFFFu;
+	b = (b | (b >> 8)) & 0xFFFFu;
+	return a | (b << 16);
+#endif
+}
+
+void camera_swap_bytes16(uint8_t *buf, size_t len) {
+	size_t i = 0;
+
+	// Single pixels up to a word boundary.
+	for (; ((uintptr_t)(buf + i) & 3) != 0 && i + 1 < len; i += 2) {
+		uint8_t tmp = buf[i];
+		buf[i] = buf[i + 1];
+		buf[i + 1] = tmp;
+	}
+
+	if (((uintptr_t)(buf + i) & 3) == 0) {
+		uint32_t *words = (uint32_t *)(buf + i);
+		for (; i + 16 <= len; i += 16, words += 4) {
+			uint32_t w0 = words[0];
+			uint32_t w1 = words[1];
+			uint32_t w2 = words[2];
+			uint32_t w3 = words[3];
+			words[0] = swap16x2(w0);
+			words[1] = swap16x2(w1);
+			words[2] = swap16x2(w2);
+			words[3] = swap16x2(w3);
+		}
+		for (; i + 4 <= len; i += 4, words++) {
+			*words = swap16x2(*words);
+		}
+	}
+
+	for (; i + 1 < len; i += 2) {
+		uint8_t tmp = buf[i];
+		buf[i] = buf[i + 1];
+		buf[i + 1] = tmp;
+	}
+}
+
+size_t camera_yuyv_to_gray(uint8_t *dst, const uint8_t *src, size_t len) {
+	size_t pixels = len / 2;
+	size_t i = 0;
+
+	// In place, each output word only overwrites input that was already read.
+	if ((((uintptr_t)src | (uintptr_t)dst) & 3) == 0) {
+		const uint32_t *in = (const uint32_t *)src;
+		uint32_t *out = (uint32_t *)dst;
+		for (; i + 8 <= pixels; i += 8, in += 4, out += 2) {
+			uint32_t w0 = in[0];
+			uint32_t w1 = in[1];
+			uint32_t w2 = in[2];
+			uint32_t w3 = in[3];
+			out[0] = luma4(w0, w1);
+			out[1] = luma4(w2, w3);
+		}
+		for (; i + 4 <= pixels; i += 4, in += 2, out++) {
+			*out = luma4(in[0], in[1]);
+		}
+	}
+
+	for (; i < pixels; i++) {
+		dst[i] = src[i * 2];
+	}
+
+	return pixels;
+}
+
+size_t camera_crop(uint8_t *dst, const uint8_t *src, size_t pitch, size_t row_len, size_t rows) {
+	// Every row moves towards the start of the buffer, so in place the
+	// rows still to be copied are never overwritten.
+	for (size_t y = 0; y < rows; y++) {
+		memmove(dst + y * row_len, src + y * pitch, row_len);
+	}
+
+	return row_len * rows;
+}
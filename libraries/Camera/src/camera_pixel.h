@@ -0,0 +1,65 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __CAMERA_PIXEL_H__
+#define __CAMERA_PIXEL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Swap the bytes of every 16-bit pixel in place.
+ *
+ * Converts RGB565 between the little-endian byte order of Zephyr's
+ * VIDEO_PIX_FMT_RGB565 and the big-endian order most displays expect, which
+ * is also how FramePipeline and JPEGEncoder read byte-swapped frames. Works
+ * on two pixels per 32-bit word (REV16 on Cortex-M).
+ *
+ * @param buf Pixel data.
+ * @param len Length in bytes, a multiple of 2.
+ */
+void camera_swap_bytes16(uint8_t *buf, size_t len);
+
+/**
+ * @brief Extract the luma channel of a YUYV frame.
+ *
+ * Four pixels are converted per step with word loads and stores; on
+ * Cortex-M cores with the DSP extension the bytes are gathered with
+ * UXTB16/PKHBT/PKHTB. dst may equal src to convert in place.
+ *
+ * @param dst Destination of len / 2 grayscale bytes.
+ * @param src YUYV pixel data.
+ * @param len Length of src in bytes, a multiple of 2.
+ * @return size_t Number of bytes written to dst.
+ */
+size_t camera_yuyv_to_gray(uint8_t *dst, const uint8_t *src, size_t len);
+
+/**
+ * @brief Copy a window of a frame into a packed buffer.
+ *
+ * Rows are copied in order, so dst may equal src to crop in place.
+ *
+ * @param dst Destination of row_len * rows bytes.
+ * @param src First byte of the window.
+ * @param pitch Distance between the rows of src in bytes.
+ * @param row_len Bytes per row of the window.
+ * @param rows Number of rows of the window.
+ * @return size_t Number of bytes written to dst.
+ */
+size_t camera_crop(uint8_t *dst, const uint8_t *src, size_t pitch, size_t row_len, size_t rows);
+
+#endif // __CAMERA_PIXEL_H__
@@ -0,0 +1,632 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Line-based frame processing pipeline.
+ */
+#include "Arduino.h"
+#include "frame_pipeline.h"
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+// RGB565 with the bytes of each pixel swapped, as delivered with byte_swap.
+#define FRAME_RGB565_SWAPPED 0x100
+
+static uint32_t bytes_per_pixel(uint32_t format) {
+	switch (format) {
+	case CAMERA_GRAYSCALE:
+		return 1;
+	case CAMERA_RGB888:
+		return 3;
+	default:
+		return 2;
+	}
+}
+
+// Number of 8-bit channels a format is unpacked to.
+static uint32_t channels(uint32_t format) {
+	return format == CAMERA_GRAYSCALE ? 1 : 3;
+}
+
+static inline uint8_t luma(uint32_t r, uint32_t g, uint32_t b) {
+	return (77 * r + 150 * g + 29 * b) >> 8;
+}
+
+static inline void unpack565(uint32_t p, uint8_t *c) {
+	uint32_t r = p >> 11;
+	uint32_t g = (p >> 5) & 0x3F;
+	uint32_t b = p & 0x1F;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+static inline uint32_t pack565(uint32_t r, uint32_t g, uint32_t b) {
+	return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// Expand a row to 8-bit channels. Only RGB565 needs it; the other formats
+// already are their channels.
+static void unpack_row(uint32_t format, const uint8_t *src, uint8_t *dst, uint32_t width) {
+	if (format == FRAME_RGB565_SWAPPED) {
+		for (uint32_t x = 0; x < width; x++, src += 2, dst += 3) {
+			unpack565((src[0] << 8) | src[1], dst);
+		}
+	} else {
+		for (uint32_t x = 0; x < width; x++, src += 2, dst += 3) {
+			unpack565(src[0] | (src[1] << 8), dst);
+		}
+	}
+}
+
+// Store a row of 8-bit channels (1 or 3 per pixel) in a pixel format.
+static void pack_row(uint32_t format, const uint8_t *src, uint32_t src_channels, uint8_t *dst,
+					 uint32_t width) {
+	switch (format) {
+	case CAMERA_GRAYSCALE:
+		if (src_channels == 1) {
+			memcpy(dst, src, width);
+		} else {
+			for (uint32_t x = 0; x < width; x++, src += 3) {
+				dst[x] = luma(src[0], src[1], src[2]);
+			}
+		}
+		break;
+	case CAMERA_RGB888:
+		if (src_channels == 3) {
+			memcpy(dst, src, width * 3);
+		} else {
+			for (uint32_t x = 0; x < width; x++, dst += 3) {
+				dst[0] = dst[1] = dst[2] = src[x];
+			}
+		}
+		break;
+	default:
+		for (uint32_t x = 0; x < width; x++, src += src_channels, dst += 2) {
+			uint32_t p = src_channels == 3 ? pack565(src[0], src[1], src[2])
+										   : pack565(src[0], src[0], src[0]);
+			if (format == FRAME_RGB565_SWAPPED) {
+				dst[0] = p >> 8;
+				dst[1] = p;
+			} else {
+				dst[0] = p;
+				dst[1] = p >> 8;
+			}
+		}
+		break;
+	}
+}
+
+class FrameStage {
+public:
+	const char *name;
+	FrameStage *prev;
+	uint32_t width;
+	uint32_t height;
+	uint32_t format;
+	bool normalized;
+	uint32_t cycles;
+	uint8_t *line;
+
+	FrameStage(const char *name, FrameStage *prev)
+		: name(name), prev(prev), width(0), height(0), format(CAMERA_RGB565), normalized(false),
+		  cycles(0), line(NULL) {
+		if (prev) {
+			this->width = prev->width;
+			this->height = prev->height;
+			this->format = prev->format;
+			this->normalized = prev->normalized;
+		}
+	}
+
+	virtual ~FrameStage() {
+		delete[] this->line;
+	}
+
+	// Allocate the stage's buffers once its output geometry is known.
+	virtual bool init() {
+		this->line = new uint8_t[this->width * bytes_per_pixel(this->format)];
+		return this->line != NULL;
+	}
+
+	// Called before every frame.
+	virtual void reset() {
+		this->cycles = 0;
+	}
+
+	// Return output row y. Rows are requested in increasing order. Stages
+	// that compute new pixels write them to dst, or to their own line if
+	// dst is NULL; the result stays valid until the next call.
+	virtual const uint8_t *row(uint32_t y, uint8_t *dst) = 0;
+
+	uint8_t *target(uint8_t *dst) {
+		return dst ? dst : this->line;
+	}
+};
+
+class SourceStage : public FrameStage {
+public:
+	const uint8_t *frame;
+
+	SourceStage(uint32_t width, uint32_t height, uint32_t format)
+		: FrameStage("input", NULL), frame(NULL) {
+		this->width = width;
+		this->height = height;
+		this->format = format;
+	}
+
+	bool init() override {
+		return true;
+	}
+
+	const uint8_t *row(uint32_t y, uint8_t *dst) override {
+		return this->frame + y * this->width * bytes_per_pixel(this->format);
+	}
+};
+
+class CropStage : public FrameStage {
+	uint32_t x0;
+	uint32_t y0;
+
+public:
+	CropStage(FrameStage *prev, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+		: FrameStage("crop", prev), x0(x), y0(y) {
+		this->width = width;
+		this->height = height;
+	}
+
+	bool init() override {
+		return true;
+	}
+
+	const uint8_t *row(uint32_t y, uint8_t *dst) override {
+		return this->prev->row(y + this->y0, NULL) + this->x0 * bytes_per_pixel(this->format);
+	}
+};
+
+class DownscaleStage : public FrameStage {
+	uint32_t factor;
+	uint32_t reciprocal; // 65536 / (factor * factor)
+	uint16_t *sums;
+	uint8_t *pixels;     // One unpacked RGB565 input row
+
+public:
+	DownscaleStage(FrameStage *prev, uint32_t factor)
+		: FrameStage("downscale", prev), factor(factor),
+		  reciprocal((65536 + factor * factor / 2) / (factor * factor)), sums(NULL), pixels(NULL) {
+		this->width = prev->width / factor;
+		this->height = prev->height / factor;
+	}
+
+	~DownscaleStage() override {
+		delete[] this->sums;
+		delete[] this->pixels;
+	}
+
+	bool init() override {
+		uint32_t ch = channels(this->format);
+		this->sums = new uint16_t[this->width * ch];
+		if (channels(this->format) == 3 && bytes_per_pixel(this->format) == 2) {
+			this->pixels = new uint8_t[this->prev->width * 3];
+			if (this->pixels == NULL) {
+				return false;
+			}
+		}
+		return this->sums != NULL && FrameStage::init();
+	}
+
+	const uint8_t *row(uint32_t y, uint8_t *dst) override {
+		uint32_t ch = channels(this->format);
+		uint32_t span = this->factor * ch;
+		uint32_t start;
+
+		memset(this->sums, 0, this->width * ch * sizeof(uint16_t));
+		for (uint32_t i = 0; i < this->factor; i++) {
+			const uint8_t *src = this->prev->row(y * this->factor + i, NULL);
+
+			start = k_cycle_get_32();
+			if (this->pixels) {
+				unpack_row(this->format, src, this->pixels, this->width * this->factor);
+				src = this->pixels;
+			}
+			for (uint32_t x = 0; x < this->width; x++, src += span) {
+				uint16_t *sum = this->sums + x * ch;
+				for (uint32_t j = 0; j < span; j += ch) {
+					for (uint32_t c = 0; c < ch; c++) {
+						sum[c] += src[j + c];
+					}
+				}
+			}
+			this->cycles += k_cycle_get_32() - start;
+		}
+
+		start = k_cycle_get_32();
+		uint8_t *out = target(dst);
+		uint8_t *avg = this->pixels ? this->pixels : out;
+		for (uint32_t i = 0; i < this->width * ch; i++) {
+			avg[i] = (this->sums[i] * this->reciprocal) >> 16;
+		}
+		if (this->pixels) {
+			pack_row(this->format, avg, 3, out, this->width);
+		}
+		this->cycles += k_cycle_get_32() - start;
+		return out;
+	}
+};
+
+class ResizeStage : public FrameStage {
+	uint16_t *xs;       // Left source pixel of each output pixel
+	uint16_t *wx;       // Weight of the right source pixel, 0..256
+	uint8_t *rows[2];   // Unpacked source rows
+	int32_t cached[2];  // Source row held by rows[i], -1 if none
+	uint8_t *pixels;    // Interpolated output row for RGB565
+
+	// Map output coordinate i to source coordinate in 8.8 fixed point,
+	// aligning pixel centers.
+	static void map(uint32_t i, uint32_t out_size, uint32_t in_size, uint32_t *index,
+					uint32_t *weight) {
+		int32_t pos = (int32_t)(((2 * i + 1) * in_size * 256) / (2 * out_size)) - 128;
+		if (pos < 0) {
+			pos = 0;
+		}
+		if (pos > (int32_t)(in_size - 1) * 256) {
+			pos = (in_size - 1) * 256;
+		}
+		*index = pos >> 8;
+		*weight = pos & 0xFF;
+	}
+
+	const uint8_t *source(uint32_t y) {
+		if (this->cached[0] == (int32_t)y) {
+			return this->rows[0];
+		}
+		if (this->cached[1] == (int32_t)y) {
+			return this->rows[1];
+		}
+
+		// Rows are requested in increasing order, so the older one can go
+		int slot = this->cached[0] < this->cached[1] ? 0 : 1;
+		const uint8_t *src = this->prev->row(y, NULL);
+		uint32_t start = k_cycle_get_32();
+		if (bytes_per_pixel(this->format) == 2) {
+			unpack_row(this->format, src, this->rows[slot], this->prev->width);
+		} else {
+			memcpy(this->rows[slot], src, this->prev->width * channels(this->format));
+		}
+		this->cycles += k_cycle_get_32() - start;
+		this->cached[slot] = y;
+		return this->rows[slot];
+	}
+
+public:
+	ResizeStage(FrameStage *prev, uint32_t width, uint32_t height)
+		: FrameStage("resize", prev), xs(NULL), wx(NULL), pixels(NULL) {
+		this->width = width;
+		this->height = height;
+		this->rows[0] = this->rows[1] = NULL;
+	}
+
+	~ResizeStage() override {
+		delete[] this->xs;
+		delete[] this->wx;
+		delete[] this->rows[0];
+		delete[] this->rows[1];
+		delete[] this->pixels;
+	}
+
+	bool init() override {
+		uint32_t ch = channels(this->format);
+		this->xs = new uint16_t[this->width];
+		this->wx = new uint16_t[this->width];
+		this->rows[0] = new uint8_t[this->prev->width * ch];
+		this->rows[1] = new uint8_t[this->prev->width * ch];
+		if (bytes_per_pixel(this->format) == 2) {
+			this->pixels = new uint8_t[this->width * 3];
+			if (this->pixels == NULL) {
+				return false;
+			}
+		}
+		if (!this->xs || !this->wx || !this->rows[0] || !this->rows[1] || !FrameStage::init()) {
+			return false;
+		}
+
+		for (uint32_t x = 0; x < this->width; x++) {
+			uint32_t index, weight;
+			map(x, this->width, this->prev->width, &index, &weight);
+			this->xs[x] = index;
+			this->wx[x] = weight;
+		}
+		return true;
+	}
+
+	void reset() override {
+		FrameStage::reset();
+		this->cached[0] = this->cached[1] = -1;
+	}
+
+	const uint8_t *row(uint32_t y, uint8_t *dst) override {
+		uint32_t ch = channels(this->format);
+		uint32_t last = this->prev->width - 1;
+		uint32_t y0, fy;
+		map(y, this->height, this->prev->height, &y0, &fy);
+
+		const uint8_t *top = source(y0);
+		const uint8_t *bottom = source(y0 < this->prev->height - 1 ? y0 + 1 : y0);
+
+		uint32_t start = k_cycle_get_32();
+		uint8_t *out = target(dst);
+		uint8_t *px = this->pixels ? this->pixels : out;
+		for (uint32_t x = 0; x < this->width; x++) {
+			uint32_t i0 = this->xs[x] * ch;
+			uint32_t i1 = (this->xs[x] < last ? this->xs[x] + 1 : last) * ch;
+			uint32_t fx = this->wx[x];
+			for (uint32_t c = 0; c < ch; c++) {
+				uint32_t t = top[i0 + c] * (256 - fx) + top[i1 + c] * fx;
+				uint32_t b = bottom[i0 + c] * (256 - fx) + bottom[i1 + c] * fx;
+				*px++ = (t * (256 - fy) + b * fy + 32768) >> 16;
+			}
+		}
+		if (this->pixels) {
+			pack_row(this->format, this->pixels, 3, out, this->width);
+		}
+		this->cycles += k_cycle_get_32() - start;
+		return out;
+	}
+};
+
+class ConvertStage : public FrameStage {
+	uint8_t *pixels; // Unpacked RGB565 input row
+
+public:
+	ConvertStage(FrameStage *prev, uint32_t format) : FrameStage("convert", prev), pixels(NULL) {
+		this->format = format;
+	}
+
+	~ConvertStage() override {
+		delete[] this->pixels;
+	}
+
+	bool init() override {
+		if (bytes_per_pixel(this->prev->format) == 2) {
+			this->pixels = new uint8_t[this->width * 3];
+			if (this->pixels == NULL) {
+				return false;
+			}
+		}
+		return FrameStage::init();
+	}
+
+	const uint8_t *row(uint32_t y, uint8_t *dst) override {
+		const uint8_t *src = this->prev->row(y, NULL);
+
+		uint32_t start = k_cycle_get_32();
+		uint8_t *out = target(dst);
+		if (this->pixels) {
+			unpack_row(this->prev->format, src, this->pixels, this->width);
+			src = this->pixels;
+		}
+		pack_row(this->format, src, channels(this->prev->format), out, this->width);
+		this->cycles += k_cycle_get_32() - start;
+		return out;
+	}
+};
+
+class NormalizeStage : public FrameStage {
+	int8_t lut[256];
+
+public:
+	NormalizeStage(FrameStage *prev, float scale, int zero_point) : FrameStage("normalize", prev) {
+		this->normalized = true;
+		for (int v = 0; v < 256; v++) {
+			float q = v / 255.0f / scale + zero_point;
+			int32_t rounded = (int32_t)(q < 0 ? q - 0.5f : q + 0.5f);
+			this->lut[v] = rounded < -128 ? -128 : (rounded > 127 ? 127 : rounded);
+		}
+	}
+
+	const uint8_t *row(uint32_t y, uint8_t *dst) override {
+		const uint8_t *src = this->prev->row(y, NULL);
+
+		uint32_t start = k_cycle_get_32();
+		uint8_t *out = target(dst);
+		uint32_t n = this->width * channels(this->format);
+		for (uint32_t i = 0; i < n; i++) {
+			out[i] = (uint8_t)this->lut[src[i]];
+		}
+		this->cycles += k_cycle_get_32() - start;
+		return out;
+	}
+};
+
+FramePipeline::FramePipeline() : count(0), valid(false), total_cycles(0) {
+	for (size_t i = 0; i < ARRAY_SIZE(this->stages); i++) {
+		this->stages[i] = NULL;
+	}
+}
+
+FramePipeline::~FramePipeline() {
+	end();
+}
+
+bool FramePipeline::begin(uint32_t width, uint32_t height, uint32_t pixformat, bool byte_swap) {
+	end();
+
+	if (width == 0 || height == 0 || pixformat > CAMERA_RGB888) {
+		return false;
+	}
+
+	if (pixformat == CAMERA_RGB565 && byte_swap) {
+		pixformat = FRAME_RGB565_SWAPPED;
+	}
+
+	this->valid = true;
+	add(new SourceStage(width, height, pixformat));
+	return this->valid;
+}
+
+void FramePipeline::end() {
+	for (size_t i = 0; i < this->count; i++) {
+		delete this->stages[i];
+		this->stages[i] = NULL;
+	}
+	this->count = 0;
+	this->valid = false;
+}
+
+FramePipeline &FramePipeline::add(FrameStage *stage) {
+	if (stage == NULL) {
+		this->valid = false;
+		return *this;
+	}
+
+	if (!this->valid || this->count == ARRAY_SIZE(this->stages) || stage->width == 0 ||
+		stage->height == 0 || !stage->init()) {
+		delete stage;
+		this->valid = false;
+		return *this;
+	}
+
+	this->stages[this->count++] = stage;
+	return *this;
+}
+
+FramePipeline &FramePipeline::crop(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+	FrameStage *last = this->valid ? this->stages[this->count - 1] : NULL;
+	if (!last || last->normalized || x + width > last->width || y + height > last->height) {
+		this->valid = false;
+		return *this;
+	}
+	return add(new CropStage(last, x, y, width, height));
+}
+
+FramePipeline &FramePipeline::downscale(uint32_t factor) {
+	FrameStage *last = this->valid ? this->stages[this->count - 1] : NULL;
+	if (!last || last->normalized || factor < 2 || factor > 16) {
+		this->valid = false;
+		return *this;
+	}
+	return add(new DownscaleStage(last, factor));
+}
+
+FramePipeline &FramePipeline::resize(uint32_t width, uint32_t height) {
+	FrameStage *last = this->valid ? this->stages[this->count - 1] : NULL;
+	if (!last || last->normalized || width > 0xFFFF) {
+		this->valid = false;
+		return *this;
+	}
+	return add(new ResizeStage(last, width, height));
+}
+
+FramePipeline &FramePipeline::convert(uint32_t pixformat) {
+	FrameStage *last = this->valid ? this->stages[this->count - 1] : NULL;
+	if (!last || last->normalized || pixformat > CAMERA_RGB888) {
+		this->valid = false;
+		return *this;
+	}
+	return add(new ConvertStage(last, pixformat));
+}
+
+FramePipeline &FramePipeline::normalize(float scale, int zero_point) {
+	FrameStage *last = this->valid ? this->stages[this->count - 1] : NULL;
+	if (!last || last->normalized || bytes_per_pixel(last->format) == 2 || scale <= 0) {
+		this->valid = false;
+		return *this;
+	}
+	return add(new NormalizeStage(last, scale, zero_point));
+}
+
+bool FramePipeline::isValid() {
+	return this->valid;
+}
+
+uint32_t FramePipeline::getWidth() {
+	return this->valid ? this->stages[this->count - 1]->width : 0;
+}
+
+uint32_t FramePipeline::getHeight() {
+	return this->valid ? this->stages[this->count - 1]->height : 0;
+}
+
+uint32_t FramePipeline::getPixelFormat() {
+	if (!this->valid) {
+		return CAMERA_RGB565;
+	}
+	uint32_t format = this->stages[this->count - 1]->format;
+	return format == FRAME_RGB565_SWAPPED ? CAMERA_RGB565 : format;
+}
+
+uint32_t FramePipeline::getOutputSize() {
+	if (!this->valid) {
+		return 0;
+	}
+	FrameStage *last = this->stages[this->count - 1];
+	return last->width * last->height * bytes_per_pixel(last->format);
+}
+
+bool FramePipeline::process(FrameBuffer &fb, uint8_t *out) {
+	if (!this->valid) {
+		return false;
+	}
+
+	FrameStage *source = this->stages[0];
+	if (fb.getBufferSize() < source->width * source->height * bytes_per_pixel(source->format)) {
+		return false;
+	}
+
+	return process(fb.getBuffer(), out);
+}
+
+bool FramePipeline::process(const uint8_t *in, uint8_t *out) {
+	if (!this->valid || in == NULL || out == NULL) {
+		return false;
+	}
+
+	uint32_t start = k_cycle_get_32();
+
+	((SourceStage *)this->stages[0])->frame = in;
+	for (size_t i = 0; i < this->count; i++) {
+		this->stages[i]->reset();
+	}
+
+	FrameStage *last = this->stages[this->count - 1];
+	uint32_t pitch = last->width * bytes_per_pixel(last->format);
+	for (uint32_t y = 0; y < last->height; y++) {
+		uint8_t *dst = out + y * pitch;
+		const uint8_t *row = last->row(y, dst);
+		if (row != dst) {
+			memcpy(dst, row, pitch);
+		}
+	}
+
+	this->total_cycles = k_cycle_get_32() - start;
+	return true;
+}
+
+size_t FramePipeline::getStageCount() {
+	return this->count;
+}
+
+const char *FramePipeline::getStageName(size_t index) {
+	return index < this->count ? this->stages[index]->name : NULL;
+}
+
+uint32_t FramePipeline::getStageCycles(size_t index) {
+	return index < this->count ? this->stages[index]->cycles : 0;
+}
+
+uint32_t FramePipeline::getTotalCycles() {
+	return this->total_cycles;
+}
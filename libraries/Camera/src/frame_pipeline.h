@@ -0,0 +1,188 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __FRAME_PIPELINE_H__
+#define __FRAME_PIPELINE_H__
+
+#include "camera.h"
+
+#ifndef FRAME_PIPELINE_MAX_STAGES
+#define FRAME_PIPELINE_MAX_STAGES 8
+#endif
+
+class FrameStage;
+
+/**
+ * @class FramePipeline
+ * @brief Chain of crop, scale and conversion stages applied to camera frames.
+ *
+ * Stages run in the order they are added and are evaluated together in a
+ * single pass, one output row at a time: each stage pulls the rows it
+ * needs from the previous one and keeps at most a few lines of its own.
+ * Crops read straight from the frame, and no intermediate frames are
+ * allocated, so the only full-size buffer is the caller's output.
+ *
+ * @code
+ * FramePipeline pipe;
+ * pipe.begin(320, 240, CAMERA_RGB565);
+ * pipe.crop(40, 0, 240, 240).resize(96, 96).convert(CAMERA_GRAYSCALE).normalize();
+ * int8_t input[96 * 96];
+ * pipe.process(fb, (uint8_t *)input);
+ * @endcode
+ */
+class FramePipeline {
+private:
+	FrameStage *stages[FRAME_PIPELINE_MAX_STAGES + 1];
+	size_t count;
+	bool valid;
+	uint32_t total_cycles;
+
+	FramePipeline &add(FrameStage *stage);
+
+public:
+	/**
+	 * @brief Construct an empty FramePipeline.
+	 */
+	FramePipeline();
+	~FramePipeline();
+
+	FramePipeline(const FramePipeline &) = delete;
+	FramePipeline &operator=(const FramePipeline &) = delete;
+
+	/**
+	 * @brief Describe the input frames and remove all stages.
+	 *
+	 * @param width Input frame width in pixels.
+	 * @param height Input frame height in pixels.
+	 * @param pixformat Input pixel format (CAMERA_RGB565, CAMERA_GRAYSCALE or CAMERA_RGB888).
+	 * @param byte_swap Set if RGB565 frames come from a Camera started with byte_swap.
+	 * @return true if the input format is supported, otherwise false.
+	 */
+	bool begin(uint32_t width, uint32_t height, uint32_t pixformat = CAMERA_RGB565,
+			   bool byte_swap = false);
+
+	/**
+	 * @brief Remove all stages and free their line buffers.
+	 */
+	void end();
+
+	/**
+	 * @brief Keep only a rectangle of the image. Reads the frame in place.
+	 * @return FramePipeline& This pipeline, to chain further stages.
+	 */
+	FramePipeline &crop(uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+	/**
+	 * @brief Shrink by an integer factor, averaging factor x factor blocks.
+	 * @param factor Scale factor from 2 to 16.
+	 * @return FramePipeline& This pipeline, to chain further stages.
+	 */
+	FramePipeline &downscale(uint32_t factor);
+
+	/**
+	 * @brief Scale to an arbitrary size with bilinear interpolation.
+	 * @return FramePipeline& This pipeline, to chain further stages.
+	 */
+	FramePipeline &resize(uint32_t width, uint32_t height);
+
+	/**
+	 * @brief Convert to another pixel format.
+	 * @param pixformat CAMERA_RGB565, CAMERA_GRAYSCALE or CAMERA_RGB888.
+	 * @return FramePipeline& This pipeline, to chain further stages.
+	 */
+	FramePipeline &convert(uint32_t pixformat);
+
+	/**
+	 * @brief Quantize grayscale or RGB888 bytes to int8 model input.
+	 *
+	 * Each byte v becomes round(v / 255 / scale) + zero_point, clamped to
+	 * int8. The defaults give v - 128. Must be the last stage.
+	 *
+	 * @param scale Quantization scale of the model input.
+	 * @param zero_point Quantization zero point of the model input.
+	 * @return FramePipeline& This pipeline, to chain further stages.
+	 */
+	FramePipeline &normalize(float scale = 1.0f / 255, int zero_point = -128);
+
+	/**
+	 * @brief Check that begin() and all stages were accepted.
+	 * @return true if the pipeline can process frames, otherwise false.
+	 */
+	bool isValid();
+
+	/**
+	 * @brief Get the output width in pixels.
+	 */
+	uint32_t getWidth();
+
+	/**
+	 * @brief Get the output height in pixels.
+	 */
+	uint32_t getHeight();
+
+	/**
+	 * @brief Get the output pixel format.
+	 */
+	uint32_t getPixelFormat();
+
+	/**
+	 * @brief Get the size of one output image in bytes.
+	 */
+	uint32_t getOutputSize();
+
+	/**
+	 * @brief Run the pipeline on a captured frame.
+	 *
+	 * @param fb Frame returned by Camera::grabFrame().
+	 * @param out Output buffer of getOutputSize() bytes.
+	 * @return true on success, false if the pipeline or the frame is invalid.
+	 */
+	bool process(FrameBuffer &fb, uint8_t *out);
+
+	/**
+	 * @brief Run the pipeline on raw pixels in the input format.
+	 *
+	 * @param in Input image, tightly packed rows.
+	 * @param out Output buffer of getOutputSize() bytes.
+	 * @return true on success, false if the pipeline is invalid.
+	 */
+	bool process(const uint8_t *in, uint8_t *out);
+
+	/**
+	 * @brief Get the number of stages, including the input stage.
+	 */
+	size_t getStageCount();
+
+	/**
+	 * @brief Get the name of a stage (e.g. "crop").
+	 */
+	const char *getStageName(size_t index);
+
+	/**
+	 * @brief Get the cycles a stage spent in the last process() call.
+	 *
+	 * Only the stage's own work is counted, not the stages before it.
+	 */
+	uint32_t getStageCycles(size_t index);
+
+	/**
+	 * @brief Get the cycles the last process() call took in total.
+	 */
+	uint32_t getTotalCycles();
+};
+
+#endif // __FRAME_PIPELINE_H__
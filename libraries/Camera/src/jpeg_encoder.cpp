@@ -0,0 +1,569 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Baseline JPEG encoder.
+ */
+#include "Arduino.h"
+#include "jpeg_encoder.h"
+
+#include <string.h>
+
+// Fixed point precision of the DCT constants, and extra bits kept between
+// the row and the column pass.
+#define DCT_CONST_BITS 13
+#define DCT_PASS1_BITS 2
+
+// Natural order index of each zigzag position.
+static const uint8_t zigzag[64] = {
+	0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+	41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+	30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// ITU-T T.81 Annex K quantization tables, natural order.
+static const uint8_t std_qtable[2][64] = {
+	{
+		16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+		14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+		18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+		49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+	},
+	{
+		17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+		24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+	},
+};
+
+// ITU-T T.81 Annex K Huffman tables: number of codes of each length 1..16,
+// followed by the symbols.
+static const uint8_t dc_bits[2][16] = {
+	{0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+	{0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0},
+};
+
+static const uint8_t dc_vals[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const uint8_t ac_bits[2][16] = {
+	{0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d},
+	{0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77},
+};
+
+static const uint8_t ac_vals[2][162] = {
+	{
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51,
+		0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1,
+		0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18,
+		0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+		0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57,
+		0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+		0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92,
+		0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+		0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+		0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
+		0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2,
+		0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+	},
+	{
+		0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07,
+		0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09,
+		0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25,
+		0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38,
+		0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56,
+		0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+		0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+		0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+		0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6,
+		0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2,
+		0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+	},
+};
+
+// 1-D DCT matrix scaled by 2^13. After the even/odd butterfly every output
+// is a dot product of four sums (even outputs) or four differences (odd
+// outputs) with one row of this matrix.
+static const int16_t dct_matrix[8][4] = {
+	{2896, 2896, 2896, 2896},     {4017, 3406, 2276, 799},   {3784, 1567, -1567, -3784},
+	{3406, -799, -4017, -2276},   {2896, -2896, -2896, 2896}, {2276, -4017, 799, 3406},
+	{1567, -3784, 3784, -1567},   {799, -2276, 3406, -4017},
+};
+
+#if defined(__ARM_FEATURE_DSP)
+#define DCT_PACK(a, b) ((uint32_t)(uint16_t)(a) | ((uint32_t)(uint16_t)(b) << 16))
+#define DCT_ROW(u)                                                                                 \
+	{DCT_PACK(dct_matrix[u][0], dct_matrix[u][1]), DCT_PACK(dct_matrix[u][2], dct_matrix[u][3])}
+
+// The matrix as halfword pairs for the dual 16-bit multiply-accumulates.
+static const uint32_t dct_packed[8][2] = {
+	DCT_ROW(0), DCT_ROW(1), DCT_ROW(2), DCT_ROW(3), DCT_ROW(4), DCT_ROW(5), DCT_ROW(6), DCT_ROW(7),
+};
+#endif
+
+// In place 1-D DCT of 8 values spaced stride apart. Inputs and outputs fit
+// in 16 bits in both passes, which allows the packed DSP path.
+static void dct_1d(int16_t *d, int stride, int shift) {
+	int32_t s0 = d[0] + d[7 * stride];
+	int32_t s1 = d[1 * stride] + d[6 * stride];
+	int32_t s2 = d[2 * stride] + d[5 * stride];
+	int32_t s3 = d[3 * stride] + d[4 * stride];
+	int32_t t0 = d[0] - d[7 * stride];
+	int32_t t1 = d[1 * stride] - d[6 * stride];
+	int32_t t2 = d[2 * stride] - d[5 * stride];
+	int32_t t3 = d[3 * stride] - d[4 * stride];
+	int32_t round = 1 << (shift - 1);
+
+#if defined(__ARM_FEATURE_DSP)
+	uint32_t s01 = __PKHBT(s0, s1, 16);
+	uint32_t s23 = __PKHBT(s2, s3, 16);
+	uint32_t t01 = __PKHBT(t0, t1, 16);
+	uint32_t t23 = __PKHBT(t2, t3, 16);
+
+	for (int u = 0; u < 8; u += 2) {
+		int32_t even = __SMLAD(s23, dct_packed[u][1], __SMUAD(s01, dct_packed[u][0]));
+		int32_t odd = __SMLAD(t23, dct_packed[u + 1][1], __SMUAD(t01, dct_packed[u + 1][0]));
+		d[u * stride] = (even + round) >> shift;
+		d[(u + 1) * stride] = (odd + round) >> shift;
+	}
+#else
+	for (int u = 0; u < 8; u += 2) {
+		const int16_t *ke = dct_matrix[u];
+		const int16_t *ko = dct_matrix[u + 1];
+		d[u * stride] = (s0 * ke[0] + s1 * ke[1] + s2 * ke[2] + s3 * ke[3] + round) >> shift;
+		d[(u + 1) * stride] = (t0 * ko[0] + t1 * ko[1] + t2 * ko[2] + t3 * ko[3] + round) >> shift;
+	}
+#endif
+}
+
+// 2-D DCT of a level shifted block, scaled like the JPEG FDCT.
+static void dct_8x8(int16_t *block) {
+	for (int row = 0; row < 8; row++) {
+		dct_1d(block + row * 8, 1, DCT_CONST_BITS - DCT_PASS1_BITS);
+	}
+	for (int col = 0; col < 8; col++) {
+		dct_1d(block + col, 8, DCT_CONST_BITS + DCT_PASS1_BITS);
+	}
+}
+
+static void build_huffman(const uint8_t *bits, const uint8_t *vals, uint16_t *codes,
+						  uint8_t *sizes) {
+	uint32_t code = 0;
+	size_t k = 0;
+
+	for (int len = 1; len <= 16; len++) {
+		for (int i = 0; i < bits[len - 1]; i++, k++) {
+			codes[vals[k]] = code++;
+			sizes[vals[k]] = len;
+		}
+		code <<= 1;
+	}
+}
+
+// Number of bits of the magnitude of v (the JPEG size category).
+static inline int bit_length(uint32_t v) {
+	return v ? 32 - __builtin_clz(v) : 0;
+}
+
+static inline void unpack565(uint32_t p, int32_t *r, int32_t *g, int32_t *b) {
+	*r = ((p >> 8) & 0xF8) | (p >> 13);
+	*g = ((p >> 3) & 0xFC) | ((p >> 9) & 0x03);
+	*b = ((p << 3) & 0xF8) | ((p >> 2) & 0x07);
+}
+
+JPEGEncoder::JPEGEncoder()
+	: width(0), height(0), format(CAMERA_RGB565), byte_swap(false), quality(80), ready(false),
+	  table_quality(0), write_cb(NULL), write_arg(NULL), bits(0), nbits(0), chunk_len(0), total(0), failed(false) {
+}
+
+bool JPEGEncoder::begin(uint32_t width, uint32_t height, uint32_t pixformat, int quality,
+						bool byte_swap) {
+	this->ready = false;
+
+	if (width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF) {
+		return false;
+	}
+
+	switch (pixformat) {
+	case CAMERA_RGB565:
+	case CAMERA_GRAYSCALE:
+		break;
+	case CAMERA_YUYV:
+		// Pixels come in pairs
+		if (width & 1) {
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->format = pixformat;
+	this->byte_swap = byte_swap && pixformat == CAMERA_RGB565;
+
+	for (int i = 0; i < 2; i++) {
+		build_huffman(dc_bits[i], dc_vals, this->dc_codes[i], this->dc_sizes[i]);
+		build_huffman(ac_bits[i], ac_vals[i], this->ac_codes[i], this->ac_sizes[i]);
+	}
+
+	setQuality(quality);
+	buildQuantTables(this->quality);
+	this->ready = true;
+	return true;
+}
+
+void JPEGEncoder::setQuality(int quality) {
+	if (quality < 1) {
+		quality = 1;
+	} else if (quality > 100) {
+		quality = 100;
+	}
+	// Only latched here: the encoder may be in the middle of a frame
+	this->quality = quality;
+}
+
+void JPEGEncoder::buildQuantTables(int quality) {
+	this->table_quality = quality;
+
+	// Same scaling of the Annex K tables as libjpeg
+	int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+	for (int t = 0; t < 2; t++) {
+		for (int i = 0; i < 64; i++) {
+			int q = (std_qtable[t][i] * scale + 50) / 100;
+			q = q < 1 ? 1 : (q > 255 ? 255 : q);
+			this->qtable[t][i] = q;
+			this->qrecip[t][i] = 65535 / q + 1 - (q == 1);
+		}
+	}
+}
+
+int JPEGEncoder::getQuality() {
+	return this->quality;
+}
+
+void JPEGEncoder::putByte(uint8_t byte) {
+	this->chunk[this->chunk_len++] = byte;
+	this->total++;
+
+	if (this->chunk_len == sizeof(this->chunk)) {
+		if (!this->failed && !this->write_cb(this->chunk, this->chunk_len, this->write_arg)) {
+			this->failed = true;
+		}
+		this->chunk_len = 0;
+	}
+}
+
+void JPEGEncoder::putBytes(const uint8_t *data, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		putByte(data[i]);
+	}
+}
+
+void JPEGEncoder::putBits(uint32_t code, int size) {
+	this->bits = (this->bits << size) | (code & ((1u << size) - 1));
+	this->nbits += size;
+
+	while (this->nbits >= 8) {
+		this->nbits -= 8;
+		uint8_t byte = this->bits >> this->nbits;
+		putByte(byte);
+		// 0xFF in entropy coded data is stuffed with a zero byte
+		if (byte == 0xFF) {
+			putByte(0);
+		}
+	}
+}
+
+void JPEGEncoder::flushBits() {
+	if (this->nbits > 0) {
+		putBits(0x7F, 8 - this->nbits);
+	}
+	this->bits = 0;
+	this->nbits = 0;
+}
+
+void JPEGEncoder::writeHeaders() {
+	bool color = this->format != CAMERA_GRAYSCALE;
+	int tables = color ? 2 : 1;
+
+	static const uint8_t soi_app0[] = {
+		0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+		0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+	};
+	putBytes(soi_app0, sizeof(soi_app0));
+
+	// Quantization tables, in zigzag order
+	int len = 2 + tables * 65;
+	uint8_t dqt[] = {0xFF, 0xDB, (uint8_t)(len >> 8), (uint8_t)len};
+	putBytes(dqt, sizeof(dqt));
+	for (int t = 0; t < tables; t++) {
+		putByte(t);
+		for (int i = 0; i < 64; i++) {
+			putByte(this->qtable[t][zigzag[i]]);
+		}
+	}
+
+	// Frame header: Y sampled 2x1 for color, chroma 1x1
+	len = 8 + 3 * (color ? 3 : 1);
+	uint8_t sof[] = {
+		0xFF,
+		0xC0,
+		(uint8_t)(len >> 8),
+		(uint8_t)len,
+		8,
+		(uint8_t)(this->height >> 8),
+		(uint8_t)this->height,
+		(uint8_t)(this->width >> 8),
+		(uint8_t)this->width,
+		(uint8_t)(color ? 3 : 1),
+		1,
+		(uint8_t)(color ? 0x21 : 0x11),
+		0,
+		2,
+		0x11,
+		1,
+		3,
+		0x11,
+		1,
+	};
+	putBytes(sof, 10 + 3 * (color ? 3 : 1));
+
+	// Huffman tables
+	len = 2;
+	for (int t = 0; t < tables; t++) {
+		len += 17 + 12 + 17 + 162;
+	}
+	uint8_t dht[] = {0xFF, 0xC4, (uint8_t)(len >> 8), (uint8_t)len};
+	putBytes(dht, sizeof(dht));
+	for (int t = 0; t < tables; t++) {
+		putByte(0x00 | t);
+		putBytes(dc_bits[t], 16);
+		putBytes(dc_vals, 12);
+		putByte(0x10 | t);
+		putBytes(ac_bits[t], 16);
+		putBytes(ac_vals[t], 162);
+	}
+
+	// Scan header
+	len = 6 + 2 * (color ? 3 : 1);
+	uint8_t sos[] = {
+		0xFF, 0xDA, (uint8_t)(len >> 8), (uint8_t)len, (uint8_t)(color ? 3 : 1), 1, 0x00, 2, 0x11,
+		3,    0x11,
+	};
+	putBytes(sos, 5 + 2 * (color ? 3 : 1));
+	uint8_t spectral[] = {0, 63, 0};
+	putBytes(spectral, sizeof(spectral));
+}
+
+void JPEGEncoder::encodeBlock(int16_t *block, int table, int *dc) {
+	dct_8x8(block);
+
+	// Quantize in zigzag order
+	int16_t coef[64];
+	const uint16_t *recip = this->qrecip[table];
+	for (int i = 0; i < 64; i++) {
+		int idx = zigzag[i];
+		int32_t v = block[idx];
+		if (v < 0) {
+			coef[i] = -(int32_t)(((uint32_t)-v * recip[idx] + 32768) >> 16);
+		} else {
+			coef[i] = ((uint32_t)v * recip[idx] + 32768) >> 16;
+		}
+	}
+
+	int diff = coef[0] - *dc;
+	*dc = coef[0];
+	int size = bit_length(diff < 0 ? -diff : diff);
+	putBits(this->dc_codes[table][size], this->dc_sizes[table][size]);
+	if (size) {
+		putBits(diff < 0 ? diff - 1 : diff, size);
+	}
+
+	int run = 0;
+	for (int i = 1; i < 64; i++) {
+		int v = coef[i];
+		if (v == 0) {
+			run++;
+			continue;
+		}
+		while (run > 15) {
+			putBits(this->ac_codes[table][0xF0], this->ac_sizes[table][0xF0]);
+			run -= 16;
+		}
+		size = bit_length(v < 0 ? -v : v);
+		int symbol = (run << 4) | size;
+		putBits(this->ac_codes[table][symbol], this->ac_sizes[table][symbol]);
+		putBits(v < 0 ? v - 1 : v, size);
+		run = 0;
+	}
+	if (run) {
+		putBits(this->ac_codes[table][0x00], this->ac_sizes[table][0x00]);
+	}
+}
+
+size_t JPEGEncoder::encodeImage(const uint8_t *in) {
+	int16_t y0[64], y1[64], cb[64], cr[64];
+	int dc_y = 0, dc_cb = 0, dc_cr = 0;
+	uint32_t w = this->width;
+	uint32_t h = this->height;
+
+	int quality = this->quality;
+	if (quality != this->table_quality) {
+		buildQuantTables(quality);
+	}
+
+	this->bits = 0;
+	this->nbits = 0;
+	this->chunk_len = 0;
+	this->total = 0;
+	this->failed = false;
+
+	writeHeaders();
+
+	if (this->format == CAMERA_GRAYSCALE) {
+		for (uint32_t my = 0; my < h && !this->failed; my += 8) {
+			for (uint32_t mx = 0; mx < w; mx += 8) {
+				// Blocks crossing the right or bottom edge repeat the edge pixels
+				for (uint32_t r = 0; r < 8; r++) {
+					const uint8_t *row = in + (my + r < h ? my + r : h - 1) * w;
+					for (uint32_t c = 0; c < 8; c++) {
+						y0[r * 8 + c] = row[mx + c < w ? mx + c : w - 1] - 128;
+					}
+				}
+				encodeBlock(y0, 0, &dc_y);
+			}
+		}
+	} else {
+		uint32_t pitch = w * 2;
+		for (uint32_t my = 0; my < h && !this->failed; my += 8) {
+			for (uint32_t mx = 0; mx < w; mx += 16) {
+				for (uint32_t r = 0; r < 8; r++) {
+					const uint8_t *row = in + (my + r < h ? my + r : h - 1) * pitch;
+					for (uint32_t c = 0; c < 8; c++) {
+						int16_t *ly = (c < 4 ? y0 : y1) + r * 8 + (c & 3) * 2;
+
+						if (this->format == CAMERA_YUYV) {
+							uint32_t pair = mx / 2 + c;
+							const uint8_t *p = row + (pair < w / 2 ? pair : w / 2 - 1) * 4;
+							ly[0] = p[0] - 128;
+							ly[1] = p[2] - 128;
+							cb[r * 8 + c] = p[1] - 128;
+							cr[r * 8 + c] = p[3] - 128;
+							continue;
+						}
+
+						uint32_t x0 = mx + c * 2;
+						uint32_t x1 = x0 + 1;
+						x0 = x0 < w ? x0 : w - 1;
+						x1 = x1 < w ? x1 : w - 1;
+
+						uint32_t p0, p1;
+						if (this->byte_swap) {
+							p0 = (row[x0 * 2] << 8) | row[x0 * 2 + 1];
+							p1 = (row[x1 * 2] << 8) | row[x1 * 2 + 1];
+						} else {
+							p0 = row[x0 * 2] | (row[x0 * 2 + 1] << 8);
+							p1 = row[x1 * 2] | (row[x1 * 2 + 1] << 8);
+						}
+
+						int32_t r0, g0, b0, r1, g1, b1;
+						unpack565(p0, &r0, &g0, &b0);
+						unpack565(p1, &r1, &g1, &b1);
+
+						// JFIF YCbCr, level shifted; chroma of the pixel pair
+						ly[0] = ((19595 * r0 + 38470 * g0 + 7471 * b0 + 32768) >> 16) - 128;
+						ly[1] = ((19595 * r1 + 38470 * g1 + 7471 * b1 + 32768) >> 16) - 128;
+						int32_t rs = r0 + r1, gs = g0 + g1, bs = b0 + b1;
+						cb[r * 8 + c] = (-11059 * rs - 21709 * gs + 32768 * bs + 65536) >> 17;
+						cr[r * 8 + c] = (32768 * rs - 27439 * gs - 5329 * bs + 65536) >> 17;
+					}
+				}
+				encodeBlock(y0, 0, &dc_y);
+				encodeBlock(y1, 0, &dc_y);
+				encodeBlock(cb, 1, &dc_cb);
+				encodeBlock(cr, 1, &dc_cr);
+			}
+		}
+	}
+
+	flushBits();
+	putByte(0xFF);
+	putByte(0xD9);
+
+	if (this->chunk_len && !this->failed &&
+		!this->write_cb(this->chunk, this->chunk_len, this->write_arg)) {
+		this->failed = true;
+	}
+
+	return this->failed ? 0 : this->total;
+}
+
+size_t JPEGEncoder::encode(const uint8_t *in, JPEGWriteCallback write, void *arg) {
+	if (!this->ready || in == NULL || write == NULL) {
+		return 0;
+	}
+
+	this->write_cb = write;
+	this->write_arg = arg;
+	return encodeImage(in);
+}
+
+size_t JPEGEncoder::encode(FrameBuffer &fb, JPEGWriteCallback write, void *arg) {
+	uint32_t bpp = this->format == CAMERA_GRAYSCALE ? 1 : 2;
+	if (fb.getBufferSize() < this->width * this->height * bpp) {
+		return 0;
+	}
+
+	return encode(fb.getBuffer(), write, arg);
+}
+
+struct jpeg_memory_sink {
+	uint8_t *data;
+	size_t size;
+	size_t used;
+};
+
+static bool jpeg_memory_write(const uint8_t *data, size_t len, void *arg) {
+	struct jpeg_memory_sink *sink = (struct jpeg_memory_sink *)arg;
+
+	if (len > sink->size - sink->used) {
+		return false;
+	}
+
+	memcpy(sink->data + sink->used, data, len);
+	sink->used += len;
+	return true;
+}
+
+size_t JPEGEncoder::encode(const uint8_t *in, uint8_t *out, size_t size) {
+	if (out == NULL) {
+		return 0;
+	}
+
+	struct jpeg_memory_sink sink = {out, size, 0};
+	return encode(in, jpeg_memory_write, &sink);
+}
+
+size_t JPEGEncoder::encode(FrameBuffer &fb, uint8_t *out, size_t size) {
+	if (out == NULL) {
+		return 0;
+	}
+
+	struct jpeg_memory_sink sink = {out, size, 0};
+	return encode(fb, jpeg_memory_write, &sink);
+}
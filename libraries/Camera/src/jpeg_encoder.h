@@ -0,0 +1,173 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __JPEG_ENCODER_H__
+#define __JPEG_ENCODER_H__
+
+#include "camera.h"
+
+#ifndef JPEG_ENCODER_CHUNK_SIZE
+#define JPEG_ENCODER_CHUNK_SIZE 512
+#endif
+
+/**
+ * @brief Function receiving the encoded bytes.
+ *
+ * Called with chunks of at most JPEG_ENCODER_CHUNK_SIZE bytes while the
+ * frame is encoded.
+ *
+ * @return true to continue, false to abort encoding.
+ */
+typedef bool (*JPEGWriteCallback)(const uint8_t *data, size_t len, void *arg);
+
+/**
+ * @class JPEGEncoder
+ * @brief Baseline JPEG encoder for camera frames.
+ *
+ * Frames are encoded straight from the frame buffer, one 16x8 (8x8 for
+ * grayscale) block row after the other, and the output is produced in
+ * chunks of JPEG_ENCODER_CHUNK_SIZE bytes. Apart from the encoder object
+ * itself (about 2.5 KB) no memory is needed, so frames can be written to
+ * a file or a socket without a second frame-sized buffer.
+ *
+ * Color frames are stored as YCbCr 4:2:2, grayscale frames as a single
+ * component. The DCT uses integer arithmetic; on cores with the DSP
+ * extension two multiply-accumulates are done per instruction.
+ *
+ * @code
+ * JPEGEncoder jpeg;
+ * jpeg.begin(320, 240, CAMERA_RGB565, 75);
+ * size_t len = jpeg.encode(fb, out, sizeof(out));
+ * @endcode
+ */
+class JPEGEncoder {
+private:
+	uint32_t width;
+	uint32_t height;
+	uint32_t format;
+	bool byte_swap;
+	volatile int quality;
+	bool ready;
+
+	// Quantization tables, in natural order: the bytes written to the
+	// file, and reciprocals scaled by 2^16 for the encoder. They are
+	// rebuilt for table_quality when a frame starts.
+	int table_quality;
+	uint8_t qtable[2][64];
+	uint16_t qrecip[2][64];
+
+	// Huffman codes and lengths (DC luma, AC luma, DC chroma, AC chroma)
+	uint16_t dc_codes[2][12];
+	uint8_t dc_sizes[2][12];
+	uint16_t ac_codes[2][256];
+	uint8_t ac_sizes[2][256];
+
+	// Output state
+	JPEGWriteCallback write_cb;
+	void *write_arg;
+	uint32_t bits;
+	int nbits;
+	size_t chunk_len;
+	size_t total;
+	bool failed;
+	uint8_t chunk[JPEG_ENCODER_CHUNK_SIZE];
+
+	void putByte(uint8_t byte);
+	void putBytes(const uint8_t *data, size_t len);
+	void putBits(uint32_t code, int size);
+	void flushBits();
+	void buildQuantTables(int quality);
+	void writeHeaders();
+	void encodeBlock(int16_t *block, int table, int *dc);
+	size_t encodeImage(const uint8_t *in);
+
+public:
+	/**
+	 * @brief Construct a new JPEGEncoder object.
+	 */
+	JPEGEncoder();
+
+	/**
+	 * @brief Set up the encoder for frames of a given size and format.
+	 *
+	 * @param width Frame width in pixels.
+	 * @param height Frame height in pixels.
+	 * @param pixformat CAMERA_RGB565, CAMERA_GRAYSCALE or CAMERA_YUYV.
+	 * @param quality Quality from 1 (smallest) to 100 (best), default 80.
+	 * @param byte_swap Set if RGB565 frames come from a Camera started with byte_swap.
+	 * @return true if the format is supported, otherwise false.
+	 */
+	bool begin(uint32_t width, uint32_t height, uint32_t pixformat = CAMERA_RGB565,
+			   int quality = 80, bool byte_swap = false);
+
+	/**
+	 * @brief Change the quality of the following frames.
+	 *
+	 * May be called from another thread while a frame is being encoded:
+	 * the new quality is applied when the next frame starts.
+	 *
+	 * @param quality Quality from 1 (smallest) to 100 (best).
+	 */
+	void setQuality(int quality);
+
+	/**
+	 * @brief Get the current quality.
+	 */
+	int getQuality();
+
+	/**
+	 * @brief Encode a frame into a memory buffer.
+	 *
+	 * @param fb Frame returned by Camera::grabFrame().
+	 * @param out Output buffer.
+	 * @param size Size of the output buffer.
+	 * @return Size of the JPEG image, or 0 if it did not fit or the frame is invalid.
+	 */
+	size_t encode(FrameBuffer &fb, uint8_t *out, size_t size);
+
+	/**
+	 * @brief Encode raw pixels into a memory buffer.
+	 *
+	 * @param in Input image in the format given to begin().
+	 * @param out Output buffer.
+	 * @param size Size of the output buffer.
+	 * @return Size of the JPEG image, or 0 if it did not fit.
+	 */
+	size_t encode(const uint8_t *in, uint8_t *out, size_t size);
+
+	/**
+	 * @brief Encode a frame, passing the output to a function in chunks.
+	 *
+	 * @param fb Frame returned by Camera::grabFrame().
+	 * @param write Function receiving the encoded bytes.
+	 * @param arg Argument passed to the function.
+	 * @return Size of the JPEG image, or 0 on error or if the function aborted.
+	 */
+	size_t encode(FrameBuffer &fb, JPEGWriteCallback write, void *arg = NULL);
+
+	/**
+	 * @brief Encode raw pixels, passing the output to a function in chunks.
+	 *
+	 * @param in Input image in the format given to begin().
+	 * @param write Function receiving the encoded bytes.
+	 * @param arg Argument passed to the function.
+	 * @return Size of the JPEG image, or 0 on error or if the function aborted.
+	 */
+	size_t encode(const uint8_t *in, JPEGWriteCallback write, void *arg = NULL);
+};
+
+#endif // __JPEG_ENCODER_H__
@@ -0,0 +1,486 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * MJPEG over HTTP streaming server.
+ */
+#include "Arduino.h"
+#include "mjpeg_server.h"
+
+#include <string.h>
+
+MJPEGServer::MJPEGServer(uint16_t port) : port(port), running(false) {
+}
+
+MJPEGServer::~MJPEGServer() {
+	end();
+}
+
+bool MJPEGServer::isRunning() {
+	return this->running;
+}
+
+#if defined(CONFIG_NET_SOCKETS)
+#include "ZephyrServer.h"
+#include "ZephyrClient.h"
+
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include <stdio.h>
+#include <utility>
+
+#ifndef MJPEG_SERVER_ENCODER_STACK_SIZE
+#define MJPEG_SERVER_ENCODER_STACK_SIZE 4096
+#endif
+
+#ifndef MJPEG_SERVER_CLIENT_STACK_SIZE
+#define MJPEG_SERVER_CLIENT_STACK_SIZE 2048
+#endif
+
+// Below loop(), so encoding and sending never hold up the sketch
+#ifndef MJPEG_SERVER_PRIORITY
+#define MJPEG_SERVER_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+#endif
+
+// Every viewer may hold one frame while sending it; one more is the
+// newest frame and one more is being encoded.
+#define MJPEG_SERVER_FRAMES (MJPEG_SERVER_MAX_CLIENTS + 2)
+
+#define MJPEG_BOUNDARY "arduinoframe"
+
+static const char mjpeg_response[] = "HTTP/1.1 200 OK\r\n"
+									 "Content-Type: multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY
+									 "\r\n"
+									 "Cache-Control: no-cache, no-store\r\n"
+									 "Pragma: no-cache\r\n"
+									 "Connection: close\r\n"
+									 "\r\n";
+
+static const char mjpeg_busy[] = "HTTP/1.1 503 Service Unavailable\r\n"
+								 "Connection: close\r\n"
+								 "Content-Length: 0\r\n"
+								 "\r\n";
+
+// Frames and bytes per second, measured over windows of one second.
+struct mjpeg_rate {
+	uint32_t start;
+	uint32_t frames;
+	uint32_t bytes;
+	float fps;
+	float bandwidth;
+};
+
+struct mjpeg_frame {
+	uint8_t *data;
+	size_t len;
+	uint32_t seq;
+	uint8_t users;
+};
+
+struct mjpeg_client {
+	struct k_thread thread;
+	// The thread was started and has to be joined before the slot is reused
+	bool started;
+	volatile bool connected;
+	ZephyrClient client;
+	uint32_t frames;
+	uint32_t dropped;
+	uint32_t bytes;
+	struct mjpeg_rate rate;
+};
+
+K_THREAD_STACK_DEFINE(mjpeg_encoder_stack, MJPEG_SERVER_ENCODER_STACK_SIZE);
+K_THREAD_STACK_ARRAY_DEFINE(mjpeg_client_stacks, MJPEG_SERVER_MAX_CLIENTS,
+							MJPEG_SERVER_CLIENT_STACK_SIZE);
+
+static struct {
+	MJPEGServer *owner;
+	Camera *camera;
+	JPEGEncoder *encoder;
+	ZephyrServer *listener;
+	struct k_thread thread;
+	struct k_mutex lock;
+	struct k_condvar published;
+	volatile bool stop;
+	struct mjpeg_frame frames[MJPEG_SERVER_FRAMES];
+	// Index of the newest frame, -1 before the first one
+	int latest;
+	uint32_t seq;
+	uint32_t oversized;
+	struct mjpeg_rate rate;
+	struct mjpeg_client clients[MJPEG_SERVER_MAX_CLIENTS];
+} mjpeg;
+
+static void rate_reset(struct mjpeg_rate *rate) {
+	rate->start = k_uptime_get_32();
+	rate->frames = 0;
+	rate->bytes = 0;
+	rate->fps = 0;
+	rate->bandwidth = 0;
+}
+
+static void rate_update(struct mjpeg_rate *rate, uint32_t bytes) {
+	uint32_t now = k_uptime_get_32();
+
+	rate->frames++;
+	rate->bytes += bytes;
+	if (now - rate->start >= 1000) {
+		rate->fps = rate->frames * 1000.0f / (now - rate->start);
+		rate->bandwidth = rate->bytes * 1000.0f / (now - rate->start);
+		rate->start = now;
+		rate->frames = 0;
+		rate->bytes = 0;
+	}
+}
+
+// Report zero instead of the last measured rate once nothing happens.
+static bool rate_stalled(struct mjpeg_rate *rate) {
+	return k_uptime_get_32() - rate->start > 2000;
+}
+
+static bool send_all(ZephyrClient &client, const uint8_t *data, size_t len) {
+	while (len > 0 && !mjpeg.stop) {
+		size_t sent = client.write(data, len);
+		if (sent == 0 || sent > len) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				k_msleep(1);
+				continue;
+			}
+			return false;
+		}
+		data += sent;
+		len -= sent;
+	}
+	return len == 0;
+}
+
+// Wait up to a second for the end of the request headers. The request
+// itself does not matter: every URL gets the stream.
+static void skip_request(ZephyrClient &client) {
+	uint32_t start = k_uptime_get_32();
+	uint32_t tail = 0;
+
+	while (k_uptime_get_32() - start < 1000 && !mjpeg.stop) {
+		uint8_t c;
+		if (!client.available() || client.read(&c, 1) != 1) {
+			// Let the other clients and the capture loop run meanwhile
+			k_msleep(1);
+			continue;
+		}
+		tail = (tail << 8) | c;
+		if (tail == 0x0D0A0D0A) {
+			return;
+		}
+	}
+}
+
+static void client_entry(void *p1, void *p2, void *p3) {
+	struct mjpeg_client *slot = (struct mjpeg_client *)p1;
+	ZephyrClient &client = slot->client;
+	uint32_t last_seq = 0;
+	char header[96];
+
+	skip_request(client);
+	bool ok = send_all(client, (const uint8_t *)mjpeg_response, sizeof(mjpeg_response) - 1);
+
+	while (ok && !mjpeg.stop) {
+		k_mutex_lock(&mjpeg.lock, K_FOREVER);
+		while (!mjpeg.stop && (mjpeg.latest < 0 || mjpeg.frames[mjpeg.latest].seq == last_seq)) {
+			k_condvar_wait(&mjpeg.published, &mjpeg.lock, K_MSEC(100));
+		}
+		if (mjpeg.stop) {
+			k_mutex_unlock(&mjpeg.lock);
+			break;
+		}
+		struct mjpeg_frame *frame = &mjpeg.frames[mjpeg.latest];
+		frame->users++;
+		k_mutex_unlock(&mjpeg.lock);
+
+		// Frames published while the previous one was being sent are skipped
+		if (last_seq != 0) {
+			slot->dropped += frame->seq - last_seq - 1;
+		}
+		last_seq = frame->seq;
+
+		int len = snprintf(header, sizeof(header),
+						   "--" MJPEG_BOUNDARY "\r\n"
+						   "Content-Type: image/jpeg\r\n"
+						   "Content-Length: %u\r\n"
+						   "\r\n",
+						   (unsigned int)frame->len);
+		ok = send_all(client, (const uint8_t *)header, len) &&
+			 send_all(client, frame->data, frame->len) &&
+			 send_all(client, (const uint8_t *)"\r\n", 2);
+
+		k_mutex_lock(&mjpeg.lock, K_FOREVER);
+		frame->users--;
+		k_mutex_unlock(&mjpeg.lock);
+
+		if (ok) {
+			uint32_t bytes = len + frame->len + 2;
+			slot->frames++;
+			slot->bytes += bytes;
+			rate_update(&slot->rate, bytes);
+		}
+	}
+
+	client.stop();
+	slot->connected = false;
+}
+
+static void accept_clients() {
+	for (;;) {
+		ZephyrClient client = mjpeg.listener->accept();
+		if (!client) {
+			return;
+		}
+
+		struct mjpeg_client *slot = NULL;
+		for (size_t i = 0; i < MJPEG_SERVER_MAX_CLIENTS; i++) {
+			if (!mjpeg.clients[i].connected) {
+				slot = &mjpeg.clients[i];
+				break;
+			}
+		}
+
+		if (slot == NULL) {
+			client.write((const uint8_t *)mjpeg_busy, sizeof(mjpeg_busy) - 1);
+			client.stop();
+			continue;
+		}
+
+		size_t index = slot - mjpeg.clients;
+		if (slot->started) {
+			k_thread_join(&slot->thread, K_FOREVER);
+		}
+
+		slot->client = std::move(client);
+		slot->frames = 0;
+		slot->dropped = 0;
+		slot->bytes = 0;
+		rate_reset(&slot->rate);
+		slot->connected = true;
+		slot->started = true;
+		k_thread_create(&slot->thread, mjpeg_client_stacks[index],
+						K_THREAD_STACK_SIZEOF(mjpeg_client_stacks[index]), client_entry, slot, NULL,
+						NULL, MJPEG_SERVER_PRIORITY, 0, K_NO_WAIT);
+		k_thread_name_set(&slot->thread, "mjpeg_client");
+	}
+}
+
+static size_t connected_clients() {
+	size_t count = 0;
+	for (size_t i = 0; i < MJPEG_SERVER_MAX_CLIENTS; i++) {
+		count += mjpeg.clients[i].connected;
+	}
+	return count;
+}
+
+static void encoder_entry(void *p1, void *p2, void *p3) {
+	while (!mjpeg.stop) {
+		accept_clients();
+
+		// Nobody is watching, so don't spend time on encoding
+		if (connected_clients() == 0) {
+			k_msleep(50);
+			continue;
+		}
+
+		FrameBuffer fb;
+		if (!mjpeg.camera->grabFrame(fb, 100)) {
+			continue;
+		}
+
+		// A frame that is neither being sent nor the newest one can be
+		// overwritten without holding the lock: no viewer can pick it up
+		k_mutex_lock(&mjpeg.lock, K_FOREVER);
+		int index = 0;
+		while (mjpeg.frames[index].users || index == mjpeg.latest) {
+			index++;
+		}
+		k_mutex_unlock(&mjpeg.lock);
+
+		struct mjpeg_frame *frame = &mjpeg.frames[index];
+		size_t len = mjpeg.encoder->encode(fb, frame->data, MJPEG_SERVER_FRAME_SIZE);
+		mjpeg.camera->releaseFrame(fb);
+
+		if (len == 0) {
+			mjpeg.oversized++;
+			continue;
+		}
+
+		k_mutex_lock(&mjpeg.lock, K_FOREVER);
+		frame->len = len;
+		frame->seq = ++mjpeg.seq;
+		mjpeg.latest = index;
+		k_condvar_broadcast(&mjpeg.published);
+		k_mutex_unlock(&mjpeg.lock);
+
+		rate_update(&mjpeg.rate, len);
+	}
+}
+
+bool MJPEGServer::begin(Camera &camera, JPEGEncoder &encoder) {
+	if (this->running) {
+		return false;
+	}
+
+	k_sched_lock();
+	bool busy = mjpeg.owner != NULL;
+	if (!busy) {
+		mjpeg.owner = this;
+	}
+	k_sched_unlock();
+	if (busy) {
+		return false;
+	}
+
+	for (size_t i = 0; i < MJPEG_SERVER_FRAMES; i++) {
+		mjpeg.frames[i].data = new uint8_t[MJPEG_SERVER_FRAME_SIZE];
+		mjpeg.frames[i].len = 0;
+		mjpeg.frames[i].seq = 0;
+		mjpeg.frames[i].users = 0;
+		if (mjpeg.frames[i].data == NULL) {
+			this->running = true;
+			end();
+			return false;
+		}
+	}
+
+	mjpeg.listener = new ZephyrServer(this->port);
+	if (mjpeg.listener) {
+		mjpeg.listener->begin();
+	}
+	if (!mjpeg.listener || !*mjpeg.listener) {
+		this->running = true;
+		end();
+		return false;
+	}
+
+	k_mutex_init(&mjpeg.lock);
+	k_condvar_init(&mjpeg.published);
+	mjpeg.camera = &camera;
+	mjpeg.encoder = &encoder;
+	mjpeg.stop = false;
+	mjpeg.latest = -1;
+	mjpeg.seq = 0;
+	mjpeg.oversized = 0;
+	rate_reset(&mjpeg.rate);
+	for (size_t i = 0; i < MJPEG_SERVER_MAX_CLIENTS; i++) {
+		mjpeg.clients[i].started = false;
+		mjpeg.clients[i].connected = false;
+		mjpeg.clients[i].frames = 0;
+		mjpeg.clients[i].dropped = 0;
+		mjpeg.clients[i].bytes = 0;
+		rate_reset(&mjpeg.clients[i].rate);
+	}
+
+	this->running = true;
+	k_thread_create(&mjpeg.thread, mjpeg_encoder_stack,
+					K_THREAD_STACK_SIZEOF(mjpeg_encoder_stack), encoder_entry, NULL, NULL, NULL,
+					MJPEG_SERVER_PRIORITY, 0, K_NO_WAIT);
+	k_thread_name_set(&mjpeg.thread, "mjpeg_encoder");
+	return true;
+}
+
+void MJPEGServer::end() {
+	if (!this->running) {
+		return;
+	}
+
+	// Only reached with a listener when the threads were started
+	if (mjpeg.camera) {
+		mjpeg.stop = true;
+		k_condvar_broadcast(&mjpeg.published);
+		k_thread_join(&mjpeg.thread, K_FOREVER);
+
+		for (size_t i = 0; i < MJPEG_SERVER_MAX_CLIENTS; i++) {
+			struct mjpeg_client *slot = &mjpeg.clients[i];
+			if (!slot->started) {
+				continue;
+			}
+			// A viewer that stopped reading blocks in send until TCP gives up
+			if (k_thread_join(&slot->thread, K_SECONDS(2))) {
+				k_thread_abort(&slot->thread);
+			}
+			slot->client.stop();
+			slot->connected = false;
+			slot->started = false;
+		}
+	}
+
+	delete mjpeg.listener;
+	mjpeg.listener = NULL;
+	for (size_t i = 0; i < MJPEG_SERVER_FRAMES; i++) {
+		delete[] mjpeg.frames[i].data;
+		mjpeg.frames[i].data = NULL;
+	}
+
+	mjpeg.camera = NULL;
+	mjpeg.encoder = NULL;
+	mjpeg.owner = NULL;
+	this->running = false;
+}
+
+size_t MJPEGServer::getClientCount() {
+	return this->running ? connected_clients() : 0;
+}
+
+bool MJPEGServer::getClientStats(size_t index, MJPEGClientStats &stats) {
+	if (index >= MJPEG_SERVER_MAX_CLIENTS || mjpeg.owner != this) {
+		return false;
+	}
+
+	struct mjpeg_client *slot = &mjpeg.clients[index];
+	bool active = slot->connected && !rate_stalled(&slot->rate);
+	stats.connected = slot->connected;
+	stats.frames = slot->frames;
+	stats.dropped = slot->dropped;
+	stats.bytes = slot->bytes;
+	stats.fps = active ? slot->rate.fps : 0;
+	stats.bandwidth = active ? slot->rate.bandwidth : 0;
+	return true;
+}
+
+void MJPEGServer::getStats(MJPEGServerStats &stats) {
+	bool active = this->running && !rate_stalled(&mjpeg.rate);
+	stats.frames = mjpeg.seq;
+	stats.oversized = mjpeg.oversized;
+	stats.size = mjpeg.latest >= 0 ? mjpeg.frames[mjpeg.latest].len : 0;
+	stats.fps = active ? mjpeg.rate.fps : 0;
+}
+
+#else
+
+bool MJPEGServer::begin(Camera &camera, JPEGEncoder &encoder) {
+	return false;
+}
+
+void MJPEGServer::end() {
+}
+
+size_t MJPEGServer::getClientCount() {
+	return 0;
+}
+
+bool MJPEGServer::getClientStats(size_t index, MJPEGClientStats &stats) {
+	return false;
+}
+
+void MJPEGServer::getStats(MJPEGServerStats &stats) {
+	memset(&stats, 0, sizeof(stats));
+}
+
+#endif // CONFIG_NET_SOCKETS
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2025 Arduino SA
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __MJPEG_SERVER_H__
+#define __MJPEG_SERVER_H__
+
+#include "camera.h"
+#include "jpeg_encoder.h"
+
+#ifndef MJPEG_SERVER_MAX_CLIENTS
+#define MJPEG_SERVER_MAX_CLIENTS 2
+#endif
+
+#ifndef MJPEG_SERVER_FRAME_SIZE
+#define MJPEG_SERVER_FRAME_SIZE (48 * 1024)
+#endif
+
+/**
+ * @struct MJPEGClientStats
+ * @brief Counters of one connected viewer.
+ */
+struct MJPEGClientStats {
+	bool connected;     /**< A viewer is using this slot. */
+	uint32_t frames;    /**< Frames sent. */
+	uint32_t dropped;   /**< Frames skipped because the previous one was still being sent. */
+	uint32_t bytes;     /**< Bytes sent, including headers. */
+	float fps;          /**< Frames per second over the last second. */
+	float bandwidth;    /**< Bytes per second over the last second. */
+};
+
+/**
+ * @struct MJPEGServerStats
+ * @brief Counters of the encoder side of the server.
+ */
+struct MJPEGServerStats {
+	uint32_t frames;    /**< Frames encoded. */
+	uint32_t oversized; /**< Frames discarded because they exceeded MJPEG_SERVER_FRAME_SIZE. */
+	uint32_t size;      /**< Size of the last encoded frame in bytes. */
+	float fps;          /**< Encoded frames per second over the last second. */
+};
+
+/**
+ * @class MJPEGServer
+ * @brief Serves camera frames as an MJPEG stream over HTTP.
+ *
+ * Any request on the port is answered with a multipart/x-mixed-replace
+ * stream that browsers and video players display as live video. An
+ * encoder thread captures and compresses frames while separate threads
+ * send them, one per viewer, so encoding the next frame overlaps with
+ * sending the current one. Every viewer always gets the newest frame: a
+ * viewer on a slow link skips the frames encoded while it was busy rather
+ * than falling behind or slowing down the others.
+ *
+ * Frames are encoded into MJPEG_SERVER_MAX_CLIENTS + 2 buffers of
+ * MJPEG_SERVER_FRAME_SIZE bytes. Only one server can run at a time, and
+ * it is only available when networking is enabled.
+ *
+ * @code
+ * MJPEGServer server(80);
+ * jpeg.begin(320, 240, CAMERA_RGB565, 60);
+ * server.begin(cam, jpeg);
+ * @endcode
+ */
+class MJPEGServer {
+private:
+	uint16_t port;
+	bool running;
+
+public:
+	/**
+	 * @brief Construct a new MJPEGServer object.
+	 *
+	 * @param port TCP port to listen on (default: 80).
+	 */
+	MJPEGServer(uint16_t port = 80);
+	~MJPEGServer();
+
+	/**
+	 * @brief Start listening and streaming.
+	 *
+	 * The camera and the encoder must already be set up, and must not be
+	 * used by the sketch while the server runs. The encoder quality can be
+	 * changed with setQuality() at any time; it applies from the next frame.
+	 *
+	 * @param camera Camera to capture from.
+	 * @param encoder Encoder set up for the camera's frames.
+	 * @return true if the server started, otherwise false.
+	 */
+	bool begin(Camera &camera, JPEGEncoder &encoder);
+
+	/**
+	 * @brief Disconnect all viewers and stop the server.
+	 */
+	void end();
+
+	/**
+	 * @brief Check whether the server is running.
+	 */
+	bool isRunning();
+
+	/**
+	 * @brief Get the number of connected viewers.
+	 */
+	size_t getClientCount();
+
+	/**
+	 * @brief Get the counters of a viewer slot.
+	 *
+	 * @param index Slot from 0 to MJPEG_SERVER_MAX_CLIENTS - 1.
+	 * @param stats Receives the counters; they are kept after the viewer leaves.
+	 * @return true if the slot exists, otherwise false.
+	 */
+	bool getClientStats(size_t index, MJPEGClientStats &stats);
+
+	/**
+	 * @brief Get the encoder counters.
+	 *
+	 * @param stats Receives the counters.
+	 */
+	void getStats(MJPEGServerStats &stats);
+};
+
+#endif // __MJPEG_SERVER_H__
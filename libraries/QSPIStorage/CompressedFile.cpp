@@ -0,0 +1,794 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "CompressedFile.h"
+
+#include <cstring>
+
+// File layout: header, then one frame per block. A frame is the
+// uncompressed and payload lengths (16 bit little endian each) followed by
+// the payload; a payload as long as the block is stored uncompressed.
+static const uint8_t FILE_MAGIC[4] = {'Q', 'L', 'Z', '1'};
+static constexpr size_t FILE_HEADER_SIZE = 8;
+static constexpr size_t FRAME_HEADER_SIZE = 4;
+
+// LZ4 block format limits
+static constexpr size_t LZ_HASH_LOG = 12;
+static constexpr size_t LZ_MIN_MATCH = 4;
+static constexpr size_t LZ_LAST_LITERALS = 5;  // The block always ends with literals
+static constexpr size_t LZ_MATCH_LIMIT = 12;   // No match may start closer to the end
+
+static constexpr size_t SCRATCH_SIZE = CompressedFile::BLOCK_SIZE +
+                                       FRAME_HEADER_SIZE + CompressedFile::BLOCK_SIZE +
+                                       (1u << LZ_HASH_LOG) * sizeof(uint16_t);
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+static bool emitLength(uint8_t** op, uint8_t* end, size_t length) {
+    while (length >= 255) {
+        if (*op >= end) {
+            return false;
+        }
+        *(*op)++ = 255;
+        length -= 255;
+    }
+    if (*op >= end) {
+        return false;
+    }
+    *(*op)++ = static_cast<uint8_t>(length);
+    return true;
+}
+
+// Writes one sequence; matchLength 0 marks the final literals-only sequence
+static bool emitSequence(uint8_t** op, uint8_t* end, const uint8_t* literals, size_t literalLength,
+                         size_t offset, size_t matchLength) {
+    if (*op >= end) {
+        return false;
+    }
+
+    uint8_t* token = (*op)++;
+    size_t extraMatch = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+    *token = static_cast<uint8_t>(((literalLength < 15 ? literalLength : 15) << 4) |
+                                  (extraMatch < 15 ? extraMatch : 15));
+
+    if (literalLength >= 15 && !emitLength(op, end, literalLength - 15)) {
+        return false;
+    }
+    if (static_cast<size_t>(end - *op) < literalLength) {
+        return false;
+    }
+    memcpy(*op, literals, literalLength);
+    *op += literalLength;
+
+    if (matchLength == 0) {
+        return true;
+    }
+
+    if (end - *op < 2) {
+        return false;
+    }
+    *(*op)++ = static_cast<uint8_t>(offset);
+    *(*op)++ = static_cast<uint8_t>(offset >> 8);
+
+    return extraMatch < 15 || emitLength(op, end, extraMatch - 15);
+}
+
+// Greedy LZ4 block compressor. Returns the compressed length, or 0 if the
+// result would not fit in capacity bytes.
+static size_t compressBlock(const uint8_t* src, size_t length, uint8_t* dst, size_t capacity,
+                            uint16_t* table) {
+    uint8_t* op = dst;
+    uint8_t* end = dst + capacity;
+    size_t anchor = 0;
+
+    if (length > LZ_MATCH_LIMIT) {
+        memset(table, 0, (1u << LZ_HASH_LOG) * sizeof(uint16_t));
+
+        size_t limit = length - LZ_MATCH_LIMIT;
+        size_t matchEnd = length - LZ_LAST_LITERALS;
+        size_t ip = 0;
+        size_t misses = 0;
+
+        while (ip < limit) {
+            uint32_t sequence = read32(src + ip);
+            uint32_t h = hashSequence(sequence);
+            size_t ref = table[h];
+            table[h] = static_cast<uint16_t>(ip);
+
+            if (ref >= ip || read32(src + ref) != sequence) {
+                // Step faster through data that does not compress
+                ip += 1 + (misses++ >> 5);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+
+            size_t matchLength = LZ_MIN_MATCH;
+            while (ip + matchLength < matchEnd && src[ip + matchLength] == src[ref + matchLength]) {
+                matchLength++;
+            }
+
+            if (!emitSequence(&op, end, src + anchor, ip - anchor, ip - ref, matchLength)) {
+                return 0;
+            }
+
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+
+    if (!emitSequence(&op, end, src + anchor, length - anchor, 0, 0)) {
+        return 0;
+    }
+
+    return op - dst;
+}
+
+static bool readLength(const uint8_t** ip, const uint8_t* end, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*ip >= end) {
+            return false;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// LZ4 block decompressor; fails on any input that would not produce
+// exactly expected bytes
+static bool decompressBlock(const uint8_t* src, size_t length, uint8_t* dst, size_t expected) {
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + length;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + expected;
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(&ip, ipEnd, &literalLength)) {
+            return false;
+        }
+        if (literalLength > static_cast<size_t>(ipEnd - ip) ||
+            literalLength > static_cast<size_t>(opEnd - op)) {
+            return false;
+        }
+        memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+
+        if (ip == ipEnd) {
+            break;
+        }
+
+        if (ipEnd - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(&ip, ipEnd, &matchLength)) {
+            return false;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (matchLength > static_cast<size_t>(opEnd - op)) {
+            return false;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength) {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            while (matchLength-- > 0) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op == opEnd;
+}
+
+CompressedFile::CompressedFile() : File(), file_(), mode_(FileMode::READ), is_open_(false),
+    scratch_(nullptr), raw_(nullptr), frame_(nullptr), hash_(nullptr) {
+    reset();
+}
+
+CompressedFile::CompressedFile(const char* path) : File(path), file_(), mode_(FileMode::READ),
+    is_open_(false), scratch_(nullptr), raw_(nullptr), frame_(nullptr), hash_(nullptr) {
+    reset();
+}
+
+CompressedFile::CompressedFile(const String& path) : File(path), file_(), mode_(FileMode::READ),
+    is_open_(false), scratch_(nullptr), raw_(nullptr), frame_(nullptr), hash_(nullptr) {
+    reset();
+}
+
+CompressedFile::~CompressedFile() {
+    if (is_open_) {
+        close(nullptr);
+    }
+    delete[] reinterpret_cast<uint32_t*>(scratch_);
+}
+
+bool CompressedFile::allocateScratch(StorageError* error) {
+    if (scratch_ != nullptr) {
+        return true;
+    }
+
+    scratch_ = reinterpret_cast<uint8_t*>(
+        new uint32_t[(SCRATCH_SIZE + sizeof(uint32_t) - 1) / sizeof(uint32_t)]);
+    if (scratch_ == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate compression buffers");
+        }
+        return false;
+    }
+
+    raw_ = scratch_;
+    frame_ = raw_ + BLOCK_SIZE;
+    hash_ = reinterpret_cast<uint16_t*>(frame_ + FRAME_HEADER_SIZE + BLOCK_SIZE);
+    return true;
+}
+
+void CompressedFile::reset() {
+    position_ = 0;
+    size_ = 0;
+    sizeKnown_ = false;
+    blockStart_ = 0;
+    blockLength_ = 0;
+    nextFrame_ = FILE_HEADER_SIZE;
+    checkpointCount_ = 0;
+    checkpointStride_ = 1;
+    frontierIndex_ = 0;
+    frontier_.rawOffset = 0;
+    frontier_.fileOffset = FILE_HEADER_SIZE;
+}
+
+// ==================== Opening and Closing ====================
+
+bool CompressedFile::open(const char* filename, FileMode mode, StorageError* error) {
+    if (filename == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "No file path specified");
+        }
+        return false;
+    }
+
+    path_.assign(filename);
+    return open(mode, error);
+}
+
+bool CompressedFile::open(const String& filename, FileMode mode, StorageError* error) {
+    return open(filename.c_str(), mode, error);
+}
+
+bool CompressedFile::open(FileMode mode, StorageError* error) {
+    if (is_open_) {
+        close(nullptr);
+    }
+
+    if (mode == FileMode::READ_WRITE || mode == FileMode::READ_WRITE_CREATE) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_MODE, "Compressed files are append-only");
+        }
+        return false;
+    }
+
+    if (!allocateScratch(error)) {
+        return false;
+    }
+
+    reset();
+
+    // Only writers create the file: reading a missing one fails with
+    // FILE_NOT_FOUND from the open below and leaves the flash untouched
+    bool create = (mode == FileMode::WRITE) ||
+                  (mode == FileMode::APPEND && !QSPIFile(path_).exists());
+
+    if (!create) {
+        // Validate the header and, for appending, find the end of the data
+        if (!file_.open(path_, FileMode::READ, error)) {
+            return false;
+        }
+
+        uint8_t header[FILE_HEADER_SIZE];
+        if (file_.read(header, sizeof(header), error) != sizeof(header) ||
+            memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+            (header[4] | (header[5] << 8)) != BLOCK_SIZE) {
+            file_.close(nullptr);
+            if (error) {
+                error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Not a compressed file");
+            }
+            return false;
+        }
+
+        is_open_ = true;
+        mode_ = FileMode::READ;
+
+        if (mode == FileMode::READ) {
+            return true;
+        }
+
+        if (!scanToEnd(error)) {
+            close(nullptr);
+            return false;
+        }
+        file_.close(nullptr);
+        is_open_ = false;
+
+        if (!file_.open(path_, FileMode::APPEND, error)) {
+            return false;
+        }
+        position_ = size_;
+    } else {
+        // WRITE does not truncate, and frames left past the new data would
+        // be read back as part of the file
+        if (!file_.open(path_, FileMode::WRITE, error)) {
+            return false;
+        }
+        if (!file_.truncate(0, error)) {
+            file_.close(nullptr);
+            return false;
+        }
+
+        uint8_t header[FILE_HEADER_SIZE] = {};
+        memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header[4] = static_cast<uint8_t>(BLOCK_SIZE);
+        header[5] = static_cast<uint8_t>(BLOCK_SIZE >> 8);
+        if (file_.write(header, sizeof(header), error) != sizeof(header)) {
+            file_.close(nullptr);
+            return false;
+        }
+        sizeKnown_ = true;
+    }
+
+    is_open_ = true;
+    mode_ = mode;
+    return true;
+}
+
+bool CompressedFile::close(StorageError* error) {
+    if (!is_open_) {
+        return true;
+    }
+
+    bool ok = true;
+    if (mode_ != FileMode::READ) {
+        ok = writeFrame(error);
+    }
+
+    is_open_ = false;
+    if (!file_.close(ok ? error : nullptr)) {
+        ok = false;
+    }
+
+    return ok;
+}
+
+bool CompressedFile::changeMode(FileMode mode, StorageError* error) {
+    if (!is_open_) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "File not open");
+        }
+        return false;
+    }
+
+    if (!close(error)) {
+        return false;
+    }
+    return open(mode, error);
+}
+
+bool CompressedFile::isOpen() const {
+    return is_open_;
+}
+
+// ==================== Frames ====================
+
+bool CompressedFile::readFrameHeader(size_t fileOffset, uint16_t* rawLength, uint16_t* payloadLength,
+                                     StorageError* error) {
+    uint8_t header[FRAME_HEADER_SIZE];
+    if (!file_.seek(fileOffset, error) ||
+        file_.read(header, sizeof(header), error) != sizeof(header)) {
+        if (error && !error->hasError()) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Truncated frame header");
+        }
+        return false;
+    }
+
+    *rawLength = header[0] | (header[1] << 8);
+    *payloadLength = header[2] | (header[3] << 8);
+
+    if (*rawLength == 0 || *rawLength > BLOCK_SIZE || *payloadLength > *rawLength) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Invalid frame header");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void CompressedFile::recordFrame(size_t rawOffset, size_t fileOffset, size_t rawLength,
+                                 size_t frameLength) {
+    if (fileOffset != frontier_.fileOffset) {
+        return;
+    }
+
+    if (frontierIndex_ % checkpointStride_ == 0) {
+        if (checkpointCount_ == MAX_CHECKPOINTS) {
+            // Keep every other checkpoint so the table covers any file size
+            for (size_t i = 0; i < MAX_CHECKPOINTS / 2; i++) {
+                checkpoints_[i] = checkpoints_[2 * i];
+            }
+            checkpointCount_ = MAX_CHECKPOINTS / 2;
+            checkpointStride_ *= 2;
+        }
+
+        if (frontierIndex_ % checkpointStride_ == 0) {
+            checkpoints_[checkpointCount_].rawOffset = rawOffset;
+            checkpoints_[checkpointCount_].fileOffset = fileOffset;
+            checkpointCount_++;
+        }
+    }
+
+    frontierIndex_++;
+    frontier_.rawOffset = rawOffset + rawLength;
+    frontier_.fileOffset = fileOffset + frameLength;
+}
+
+bool CompressedFile::scanToEnd(StorageError* error) {
+    size_t fileSize = file_.size(error);
+
+    while (frontier_.fileOffset < fileSize) {
+        uint16_t rawLength;
+        uint16_t payloadLength;
+        if (!readFrameHeader(frontier_.fileOffset, &rawLength, &payloadLength, error)) {
+            return false;
+        }
+        recordFrame(frontier_.rawOffset, frontier_.fileOffset, rawLength,
+                    FRAME_HEADER_SIZE + payloadLength);
+    }
+
+    size_ = frontier_.rawOffset;
+    sizeKnown_ = true;
+    return true;
+}
+
+bool CompressedFile::loadBlock(size_t offset, StorageError* error) {
+    // Start from the closest known frame at or before the offset
+    Checkpoint at = {0, FILE_HEADER_SIZE};
+    if (blockLength_ > 0 && blockStart_ + blockLength_ <= offset) {
+        at.rawOffset = blockStart_ + blockLength_;
+        at.fileOffset = nextFrame_;
+    }
+    if (frontier_.rawOffset <= offset && frontier_.rawOffset > at.rawOffset) {
+        at = frontier_;
+    }
+    for (size_t i = 0; i < checkpointCount_; i++) {
+        if (checkpoints_[i].rawOffset <= offset && checkpoints_[i].rawOffset > at.rawOffset) {
+            at = checkpoints_[i];
+        }
+    }
+
+    size_t fileSize = file_.size(error);
+    uint16_t rawLength;
+    uint16_t payloadLength;
+
+    for (;;) {
+        if (at.fileOffset >= fileSize) {
+            // End of file
+            size_ = at.rawOffset;
+            sizeKnown_ = true;
+            return false;
+        }
+
+        if (!readFrameHeader(at.fileOffset, &rawLength, &payloadLength, error)) {
+            return false;
+        }
+        recordFrame(at.rawOffset, at.fileOffset, rawLength, FRAME_HEADER_SIZE + payloadLength);
+
+        if (offset < at.rawOffset + rawLength) {
+            break;
+        }
+        at.rawOffset += rawLength;
+        at.fileOffset += FRAME_HEADER_SIZE + payloadLength;
+    }
+
+    // The file position is right after the header that was just read
+    uint8_t* payload = frame_ + FRAME_HEADER_SIZE;
+    if (file_.read(payload, payloadLength, error) != payloadLength) {
+        if (error && !error->hasError()) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Truncated frame");
+        }
+        return false;
+    }
+
+    if (payloadLength == rawLength) {
+        memcpy(raw_, payload, rawLength);
+    } else if (!decompressBlock(payload, payloadLength, raw_, rawLength)) {
+        blockLength_ = 0;
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Corrupted compressed block");
+        }
+        return false;
+    }
+
+    blockStart_ = at.rawOffset;
+    blockLength_ = rawLength;
+    nextFrame_ = at.fileOffset + FRAME_HEADER_SIZE + payloadLength;
+    return true;
+}
+
+bool CompressedFile::writeFrame(StorageError* error) {
+    if (blockLength_ == 0) {
+        return true;
+    }
+
+    uint8_t* payload = frame_ + FRAME_HEADER_SIZE;
+    size_t payloadLength = compressBlock(raw_, blockLength_, payload, blockLength_ - 1, hash_);
+    if (payloadLength == 0) {
+        memcpy(payload, raw_, blockLength_);
+        payloadLength = blockLength_;
+    }
+
+    frame_[0] = static_cast<uint8_t>(blockLength_);
+    frame_[1] = static_cast<uint8_t>(blockLength_ >> 8);
+    frame_[2] = static_cast<uint8_t>(payloadLength);
+    frame_[3] = static_cast<uint8_t>(payloadLength >> 8);
+
+    size_t frameLength = FRAME_HEADER_SIZE + payloadLength;
+    if (file_.write(frame_, frameLength, error) != frameLength) {
+        if (error && !error->hasError()) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Failed to write compressed block");
+        }
+        return false;
+    }
+
+    blockLength_ = 0;
+    return true;
+}
+
+// ==================== Reading Operations ====================
+
+size_t CompressedFile::read(uint8_t* buffer, size_t size, StorageError* error) {
+    if (!is_open_ || mode_ != FileMode::READ) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "File not open for reading");
+        }
+        return 0;
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        if (position_ < blockStart_ || position_ >= blockStart_ + blockLength_) {
+            if (!loadBlock(position_, error)) {
+                break;
+            }
+        }
+
+        size_t offset = position_ - blockStart_;
+        size_t chunk = blockLength_ - offset;
+        if (chunk > size - total) {
+            chunk = size - total;
+        }
+
+        memcpy(buffer + total, raw_ + offset, chunk);
+        total += chunk;
+        position_ += chunk;
+    }
+
+    return total;
+}
+
+int CompressedFile::read(StorageError* error) {
+    uint8_t byte;
+    size_t ret = read(&byte, 1, error);
+    if (ret == 1) {
+        return byte;
+    }
+    return -1;
+}
+
+String CompressedFile::readAsString(StorageError* error) {
+    if (!is_open_) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "File not open");
+        }
+        return String();
+    }
+
+    size_t fileSize = size(error);
+    if (fileSize == 0) {
+        return String();
+    }
+
+    // Seek to beginning
+    seek(0, error);
+
+    // Read entire file
+    char* buffer = new char[fileSize + 1];
+    if (buffer == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate buffer");
+        }
+        return String();
+    }
+
+    size_t bytesRead = read(reinterpret_cast<uint8_t*>(buffer), fileSize, error);
+    buffer[bytesRead] = '\0';
+
+    String result(buffer);
+    delete[] buffer;
+
+    return result;
+}
+
+uint32_t CompressedFile::available(StorageError* error) {
+    if (!is_open_ || mode_ != FileMode::READ) {
+        return 0;
+    }
+
+    size_t fileSize = size(error);
+    return position_ < fileSize ? fileSize - position_ : 0;
+}
+
+bool CompressedFile::seek(size_t offset, StorageError* error) {
+    if (!is_open_ || mode_ != FileMode::READ) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Seeking requires READ mode");
+        }
+        return false;
+    }
+
+    if (offset > size(error)) {
+        if (error && !error->hasError()) {
+            error->setError(StorageErrorCode::SEEK_ERROR, "Offset beyond end of file");
+        }
+        return false;
+    }
+
+    // The block is loaded by the next read()
+    position_ = offset;
+    return true;
+}
+
+size_t CompressedFile::position(StorageError* error) {
+    return position_;
+}
+
+size_t CompressedFile::size(StorageError* error) {
+    if (is_open_) {
+        if (!sizeKnown_ && !scanToEnd(error)) {
+            return 0;
+        }
+        return size_;
+    }
+
+    // Not open: read the frame headers through a temporary handle
+    CompressedFile file(path_);
+    if (!file.open(FileMode::READ, error)) {
+        return 0;
+    }
+    return file.size(error);
+}
+
+// ==================== Writing Operations ====================
+
+size_t CompressedFile::write(const uint8_t* buffer, size_t size, StorageError* error) {
+    if (!is_open_ || mode_ == FileMode::READ) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "File not open for writing");
+        }
+        return 0;
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        size_t chunk = BLOCK_SIZE - blockLength_;
+        if (chunk > size - total) {
+            chunk = size - total;
+        }
+
+        memcpy(raw_ + blockLength_, buffer + total, chunk);
+        blockLength_ += chunk;
+        total += chunk;
+        position_ += chunk;
+        size_ += chunk;
+
+        if (blockLength_ == BLOCK_SIZE && !writeFrame(error)) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+size_t CompressedFile::write(const String& data, StorageError* error) {
+    return write(reinterpret_cast<const uint8_t*>(data.c_str()), data.length(), error);
+}
+
+size_t CompressedFile::write(uint8_t value, StorageError* error) {
+    return write(&value, 1, error);
+}
+
+bool CompressedFile::flush(StorageError* error) {
+    if (!is_open_) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "File not open");
+        }
+        return false;
+    }
+
+    if (mode_ == FileMode::READ) {
+        return true;
+    }
+
+    return writeFrame(error) && file_.flush(error);
+}
+
+// ==================== File Management ====================
+
+bool CompressedFile::exists(StorageError* error) const {
+    return QSPIFile(path_).exists(error);
+}
+
+bool CompressedFile::remove(StorageError* error) {
+    if (is_open_) {
+        close(nullptr);
+    }
+
+    return QSPIFile(path_).remove(error);
+}
+
+bool CompressedFile::rename(const char* newFilename, StorageError* error) {
+    if (is_open_) {
+        close(nullptr);
+    }
+
+    QSPIFile file(path_);
+    if (!file.rename(newFilename, error)) {
+        return false;
+    }
+
+    // Update internal path
+    path_.assign(newFilename);
+
+    return true;
+}
+
+bool CompressedFile::rename(const String& newFilename, StorageError* error) {
+    return rename(newFilename.c_str(), error);
+}
+
+// ==================== Compression Information ====================
+
+size_t CompressedFile::compressedSize(StorageError* error) {
+    if (is_open_) {
+        return file_.size(error);
+    }
+    return QSPIFile(path_).size(error);
+}
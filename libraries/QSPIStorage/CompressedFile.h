@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_COMPRESSED_FILE_H
+#define QSPI_COMPRESSED_FILE_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+#include "QSPIFile.h"
+
+/**
+ * @class CompressedFile
+ * @brief File that is transparently compressed on storage.
+ *
+ * Data is split into blocks of BLOCK_SIZE bytes, each compressed on its own
+ * with an LZ4-compatible block coder and written as one frame. Text logs and
+ * configuration data typically shrink 3-5x, so fewer bytes have to be
+ * programmed and more fit on the partition. Blocks that do not compress are
+ * stored as they are.
+ *
+ * Reading decompresses one block at a time. seek() skips whole frames by
+ * their headers and uses a small table of remembered frame positions, so
+ * only the block containing the target is decompressed.
+ *
+ * All working memory (about 16 KB) is allocated once by the first open()
+ * and reused; reads and writes never allocate.
+ *
+ * Compressed files are append-only: open them with READ, WRITE or APPEND.
+ * Every flush() ends the current block early, so flush sparingly.
+ *
+ * @code
+ * CompressedFile log("/storage/log.lz");
+ * log.open(FileMode::APPEND);
+ * log.write("temperature=21.5\n");
+ * log.close();
+ * @endcode
+ */
+class CompressedFile : public File {
+public:
+    /// Uncompressed bytes per frame, the unit of compression and seeking
+    static constexpr size_t BLOCK_SIZE = 4096;
+
+    CompressedFile();
+    CompressedFile(const char* path);
+    CompressedFile(const String& path);
+    ~CompressedFile() override;
+
+    CompressedFile(const CompressedFile&) = delete;
+    CompressedFile& operator=(const CompressedFile&) = delete;
+
+    // ==================== Opening and Closing ====================
+
+    bool open(const char* filename, FileMode mode, StorageError* error = nullptr) override;
+    bool open(const String& filename, FileMode mode, StorageError* error = nullptr) override;
+
+    /**
+     * @brief Open the file at the path set in the constructor.
+     * @param mode READ, WRITE or APPEND; the READ_WRITE modes are not
+     *             supported. Only WRITE and APPEND create a missing file.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool open(FileMode mode = FileMode::READ, StorageError* error = nullptr) override;
+
+    /**
+     * @brief Write out the last block and close the file.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool close(StorageError* error = nullptr) override;
+
+    bool changeMode(FileMode mode, StorageError* error = nullptr) override;
+    bool isOpen() const override;
+
+    // ==================== Reading Operations ====================
+
+    size_t read(uint8_t* buffer, size_t size, StorageError* error = nullptr) override;
+    int read(StorageError* error = nullptr) override;
+    String readAsString(StorageError* error = nullptr) override;
+    uint32_t available(StorageError* error = nullptr) override;
+
+    /**
+     * @brief Seek to an uncompressed offset. Only supported in READ mode.
+     * @param offset Byte offset in the uncompressed data
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool seek(size_t offset, StorageError* error = nullptr) override;
+
+    size_t position(StorageError* error = nullptr) override;
+
+    /**
+     * @brief Get the uncompressed size.
+     *
+     * The first call on a file opened for reading walks the frame headers.
+     *
+     * @param error Optional pointer to receive error details
+     * @return Uncompressed size in bytes
+     */
+    size_t size(StorageError* error = nullptr) override;
+
+    // ==================== Writing Operations ====================
+
+    size_t write(const uint8_t* buffer, size_t size, StorageError* error = nullptr) override;
+    size_t write(const String& data, StorageError* error = nullptr) override;
+    size_t write(uint8_t value, StorageError* error = nullptr) override;
+
+    /**
+     * @brief Compress and write the current partial block.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool flush(StorageError* error = nullptr) override;
+
+    // ==================== File Management ====================
+
+    bool exists(StorageError* error = nullptr) const override;
+    bool remove(StorageError* error = nullptr) override;
+    bool rename(const char* newFilename, StorageError* error = nullptr) override;
+    bool rename(const String& newFilename, StorageError* error = nullptr) override;
+
+    // ==================== Compression Information ====================
+
+    /**
+     * @brief Get the size of the file on storage, including frame headers.
+     * @param error Optional pointer to receive error details
+     * @return Compressed size in bytes
+     */
+    size_t compressedSize(StorageError* error = nullptr);
+
+private:
+    struct Checkpoint {
+        uint32_t rawOffset;   // Uncompressed offset of the frame
+        uint32_t fileOffset;  // Offset of the frame header in the file
+    };
+
+    static constexpr size_t MAX_CHECKPOINTS = 32;
+
+    QSPIFile file_;
+    FileMode mode_;
+    bool is_open_;
+
+    uint8_t* scratch_;   // raw_, frame_ and hash_ in one allocation
+    uint8_t* raw_;       // Current uncompressed block
+    uint8_t* frame_;     // Frame header and payload
+    uint16_t* hash_;     // Match finder table
+
+    size_t position_;    // Uncompressed read/write offset
+    size_t size_;        // Uncompressed size, valid if sizeKnown_
+    bool sizeKnown_;
+
+    // Block in raw_: [blockStart_, blockStart_ + blockLength_)
+    size_t blockStart_;
+    size_t blockLength_;
+    size_t nextFrame_;   // File offset of the frame after the loaded block
+
+    // Frames are discovered in order; frontier_ is the first unscanned one
+    Checkpoint checkpoints_[MAX_CHECKPOINTS];
+    size_t checkpointCount_;
+    size_t checkpointStride_;
+    size_t frontierIndex_;
+    Checkpoint frontier_;
+
+    bool allocateScratch(StorageError* error);
+    void reset();
+    bool readFrameHeader(size_t fileOffset, uint16_t* rawLength, uint16_t* payloadLength,
+                         StorageError* error);
+    void recordFrame(size_t rawOffset, size_t fileOffset, size_t rawLength, size_t frameLength);
+    bool loadBlock(size_t offset, StorageError* error);
+    bool writeFrame(StorageError* error);
+    bool scanToEnd(StorageError* error);
+};
+
+#endif // QSPI_COMPRESSED_FILE_H
@@ -0,0 +1,754 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "KVStore.h"
+
+#include <zephyr/sys/crc.h>
+#include <cstring>
+
+// Record framing:
+// 'K' 'V' | type + end flag | key length | value length (LE16) | CRC-32 (LE32) | key | value
+// The CRC covers bytes 2..5 of the header, the key and the value.
+static constexpr uint8_t RECORD_MAGIC_0 = 'K';
+static constexpr uint8_t RECORD_MAGIC_1 = 'V';
+static constexpr uint8_t TYPE_PUT = 0x01;
+static constexpr uint8_t TYPE_REMOVE = 0x02;
+static constexpr uint8_t TYPE_COMMIT = 0x03;
+static constexpr uint8_t TYPE_MASK = 0x7F;
+// Set on the last record of a committed operation or batch
+static constexpr uint8_t FLAG_END = 0x80;
+
+KVStore::KVStore()
+    : slots_(nullptr), mask_(0), count_(0), pending_(nullptr), pendingCount_(0),
+      scratch_(nullptr), active_(false), batching_(false), batchStart_(0), logEnd_(0),
+      liveBytes_(0), compactions_(0) {
+    keyBuf_[0] = '\0';
+}
+
+KVStore::~KVStore() {
+    end();
+}
+
+uint32_t KVStore::hashKey(const char* key, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(key[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t KVStore::recordCrc(const uint8_t* header, const uint8_t* payload, size_t length) {
+    uint32_t crc = crc32_ieee_update(0, header + 2, 4);
+    return crc32_ieee_update(crc, payload, length);
+}
+
+static void tempPath(const char* path, char* out, size_t size) {
+    snprintf(out, size, "%s.tmp", path);
+}
+
+bool KVStore::begin(const KVStoreConfig& config, StorageError* error) {
+    if (active_) {
+        return true;
+    }
+
+    if (config.path == nullptr || config.maxKeys == 0 || config.maxBatchSize == 0 ||
+        config.maxValueSize > 0xFFFF) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Invalid key-value store configuration");
+        }
+        return false;
+    }
+
+    config_ = config;
+
+    // Keep the load factor below 2/3 so probe sequences stay short
+    size_t capacity = 1;
+    while (capacity < config_.maxKeys + config_.maxKeys / 2 + 1) {
+        capacity <<= 1;
+    }
+
+    slots_ = new Slot[capacity];
+    pending_ = new PendingOp[config_.maxBatchSize];
+    scratch_ = new uint8_t[HEADER_SIZE + MAX_KEY_LENGTH + config_.maxValueSize];
+    if (slots_ == nullptr || pending_ == nullptr || scratch_ == nullptr) {
+        releaseMemory();
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate index");
+        }
+        return false;
+    }
+
+    memset(slots_, 0, capacity * sizeof(Slot));
+    mask_ = capacity - 1;
+    count_ = 0;
+    pendingCount_ = 0;
+    liveBytes_ = 0;
+    compactions_ = 0;
+    batching_ = false;
+
+    // A leftover temporary file means a compaction was interrupted before
+    // the rename; the original log is still complete
+    char tmp[STORAGE_MAX_PATH_LENGTH];
+    tempPath(config_.path, tmp, sizeof(tmp));
+    QSPIFile leftover(tmp);
+    if (leftover.exists(nullptr)) {
+        leftover.remove(nullptr);
+    }
+
+    if (!file_.open(config_.path, FileMode::READ_WRITE_CREATE, error) || !recover(error)) {
+        file_.close(nullptr);
+        releaseMemory();
+        return false;
+    }
+
+    active_ = true;
+    return true;
+}
+
+void KVStore::end() {
+    if (batching_) {
+        abortBatch(nullptr);
+    }
+
+    file_.close(nullptr);
+    releaseMemory();
+    active_ = false;
+}
+
+void KVStore::releaseMemory() {
+    delete[] slots_;
+    delete[] pending_;
+    delete[] scratch_;
+    slots_ = nullptr;
+    pending_ = nullptr;
+    scratch_ = nullptr;
+}
+
+bool KVStore::readAt(uint32_t offset, void* buffer, size_t length) {
+    if (!file_.seek(offset, nullptr)) {
+        return false;
+    }
+    return file_.read(static_cast<uint8_t*>(buffer), length, nullptr) == length;
+}
+
+bool KVStore::checkRecord(uint32_t offset, const uint8_t* header, uint32_t crc) {
+    // The payload is read in pieces of the scratch buffer size, so records
+    // written with a larger maxValueSize can be checked too. A record that
+    // fits is left whole after the header.
+    uint8_t* chunk = scratch_ + HEADER_SIZE;
+    size_t chunkSize = MAX_KEY_LENGTH + config_.maxValueSize;
+    size_t payloadLen = header[3] + (header[4] | (header[5] << 8));
+    uint32_t actual = crc32_ieee_update(0, header + 2, 4);
+
+    for (size_t done = 0; done < payloadLen;) {
+        size_t length = payloadLen - done < chunkSize ? payloadLen - done : chunkSize;
+        if (!readAt(offset + HEADER_SIZE + done, chunk, length)) {
+            return false;
+        }
+        actual = crc32_ieee_update(actual, chunk, length);
+        done += length;
+    }
+
+    return actual == crc;
+}
+
+bool KVStore::recover(StorageError* error) {
+    size_t fileSize = file_.size();
+    uint32_t offset = 0;
+    uint32_t committed = 0;
+
+    pendingCount_ = 0;
+
+    while (offset + HEADER_SIZE <= fileSize) {
+        uint8_t* header = scratch_;
+        uint8_t* payload = scratch_ + HEADER_SIZE;
+
+        if (!readAt(offset, header, HEADER_SIZE)) {
+            break;
+        }
+        if (header[0] != RECORD_MAGIC_0 || header[1] != RECORD_MAGIC_1) {
+            break;
+        }
+
+        uint8_t type = header[2] & TYPE_MASK;
+        uint8_t keyLen = header[3];
+        uint16_t valueLen = header[4] | (header[5] << 8);
+        uint32_t crc = header[6] | (header[7] << 8) | (header[8] << 16) |
+                       (static_cast<uint32_t>(header[9]) << 24);
+
+        // Only a record that runs past the end of the file or fails its CRC
+        // is a torn tail; the CRC also covers the type and both lengths
+        size_t payloadLen = keyLen + valueLen;
+        if (offset + HEADER_SIZE + payloadLen > fileSize || !checkRecord(offset, header, crc)) {
+            break;
+        }
+
+        // Anything else wrong with a record that is intact on flash is a
+        // configuration mismatch or corruption, and truncating would lose
+        // committed data
+        bool known = (type == TYPE_COMMIT) ? (keyLen == 0 && valueLen == 0)
+                                           : (type == TYPE_PUT || type == TYPE_REMOVE) && keyLen > 0;
+        if (!known) {
+            if (error) {
+                error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Unknown record in key-value log");
+            }
+            return false;
+        }
+        if (valueLen > config_.maxValueSize) {
+            if (error) {
+                error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Stored value larger than maxValueSize");
+            }
+            return false;
+        }
+
+        if (type != TYPE_COMMIT) {
+            if (pendingCount_ == config_.maxBatchSize) {
+                if (error) {
+                    error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Stored batch larger than maxBatchSize");
+                }
+                return false;
+            }
+            PendingOp& op = pending_[pendingCount_++];
+            op.hash = hashKey(reinterpret_cast<const char*>(payload), keyLen);
+            op.offset = offset;
+            op.valueLen = valueLen;
+            op.keyLen = keyLen;
+            op.remove = (type == TYPE_REMOVE);
+        }
+
+        offset += HEADER_SIZE + payloadLen;
+
+        if (header[2] & FLAG_END) {
+            if (!applyPending()) {
+                if (error) {
+                    error->setError(StorageErrorCode::STORAGE_FULL, "More keys stored than maxKeys");
+                }
+                return false;
+            }
+            committed = offset;
+        }
+    }
+
+    // Drop a torn record or an uncommitted batch at the end of the log
+    pendingCount_ = 0;
+    if (committed < fileSize && !file_.truncate(committed, error)) {
+        return false;
+    }
+
+    logEnd_ = committed;
+    return true;
+}
+
+bool KVStore::applyPending() {
+    for (size_t i = 0; i < pendingCount_; i++) {
+        const PendingOp& op = pending_[i];
+
+        if (!readAt(op.offset + HEADER_SIZE, keyBuf_, op.keyLen)) {
+            return false;
+        }
+        keyBuf_[op.keyLen] = '\0';
+
+        if (!applyOp(op, keyBuf_)) {
+            return false;
+        }
+    }
+
+    pendingCount_ = 0;
+    return true;
+}
+
+int KVStore::findSlot(uint32_t hash, const char* key, uint8_t keyLen) {
+    size_t i = hash & mask_;
+
+    while (slots_[i].used) {
+        const Slot& slot = slots_[i];
+        // Full 32-bit hashes rarely collide, so the key is only read back
+        // from flash to confirm a likely match
+        if (slot.hash == hash && slot.keyLen == keyLen &&
+            readAt(slot.offset + HEADER_SIZE, scratch_, keyLen) &&
+            memcmp(scratch_, key, keyLen) == 0) {
+            return static_cast<int>(i);
+        }
+        i = (i + 1) & mask_;
+    }
+
+    return -1;
+}
+
+void KVStore::eraseSlot(size_t index) {
+    // Backward-shift deletion keeps linear probing free of tombstones
+    size_t i = index;
+    size_t j = index;
+
+    while (true) {
+        slots_[i].used = 0;
+
+        while (true) {
+            j = (j + 1) & mask_;
+            if (!slots_[j].used) {
+                return;
+            }
+            size_t home = slots_[j].hash & mask_;
+            bool inGap = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!inGap) {
+                break;
+            }
+        }
+
+        slots_[i] = slots_[j];
+        i = j;
+    }
+}
+
+bool KVStore::applyOp(const PendingOp& op, const char* key) {
+    int index = findSlot(op.hash, key, op.keyLen);
+
+    if (op.remove) {
+        if (index >= 0) {
+            liveBytes_ -= recordSize(slots_[index].keyLen, slots_[index].valueLen);
+            eraseSlot(index);
+            count_--;
+        }
+        return true;
+    }
+
+    if (index >= 0) {
+        liveBytes_ -= recordSize(slots_[index].keyLen, slots_[index].valueLen);
+    } else {
+        if (count_ >= config_.maxKeys) {
+            return false;
+        }
+        size_t i = op.hash & mask_;
+        while (slots_[i].used) {
+            i = (i + 1) & mask_;
+        }
+        index = static_cast<int>(i);
+        slots_[index].hash = op.hash;
+        slots_[index].keyLen = op.keyLen;
+        slots_[index].used = 1;
+        count_++;
+    }
+
+    slots_[index].offset = op.offset;
+    slots_[index].valueLen = op.valueLen;
+    liveBytes_ += recordSize(op.keyLen, op.valueLen);
+    return true;
+}
+
+bool KVStore::appendRecord(uint8_t type, const char* key, uint8_t keyLen, const void* value,
+                           uint16_t valueLen, uint32_t& offset, StorageError* error) {
+    uint8_t* header = scratch_;
+    uint8_t* payload = scratch_ + HEADER_SIZE;
+    size_t payloadLen = keyLen + valueLen;
+
+    // Assemble the whole record so it goes out in a single write
+    if (keyLen > 0) {
+        memcpy(payload, key, keyLen);
+    }
+    if (valueLen > 0) {
+        memcpy(payload + keyLen, value, valueLen);
+    }
+
+    header[0] = RECORD_MAGIC_0;
+    header[1] = RECORD_MAGIC_1;
+    header[2] = type;
+    header[3] = keyLen;
+    header[4] = static_cast<uint8_t>(valueLen);
+    header[5] = static_cast<uint8_t>(valueLen >> 8);
+    uint32_t crc = recordCrc(header, payload, payloadLen);
+    header[6] = static_cast<uint8_t>(crc);
+    header[7] = static_cast<uint8_t>(crc >> 8);
+    header[8] = static_cast<uint8_t>(crc >> 16);
+    header[9] = static_cast<uint8_t>(crc >> 24);
+
+    size_t size = HEADER_SIZE + payloadLen;
+    if (!file_.seek(logEnd_, error) || file_.write(scratch_, size, error) != size) {
+        // Do not leave half a record in front of the next one
+        file_.truncate(logEnd_, nullptr);
+        if (error && !error->hasError()) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Failed to append record");
+        }
+        return false;
+    }
+
+    offset = logEnd_;
+    logEnd_ += size;
+    return true;
+}
+
+bool KVStore::validateKey(const char* key, size_t& keyLen, StorageError* error) {
+    if (!active_) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Key-value store not started");
+        }
+        return false;
+    }
+
+    keyLen = (key != nullptr) ? strlen(key) : 0;
+    if (keyLen == 0 || keyLen > MAX_KEY_LENGTH) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Invalid key");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool KVStore::syncIfNeeded(StorageError* error) {
+    return !config_.syncOnWrite || file_.flush(error);
+}
+
+bool KVStore::queueOrApply(const PendingOp& op, const char* key, StorageError* error) {
+    if (batching_) {
+        pending_[pendingCount_++] = op;
+        return true;
+    }
+
+    if (!syncIfNeeded(error)) {
+        // The caller is told the operation failed, so it must not come back
+        // from the log later. If the record can't be taken back, keep the
+        // index in line with the log and report only the sync failure.
+        if (!rollback(op.offset)) {
+            applyOp(op, key);
+        }
+        return false;
+    }
+
+    applyOp(op, key);
+    maybeCompact();
+    return true;
+}
+
+bool KVStore::rollback(uint32_t offset) {
+    if (!file_.truncate(offset, nullptr)) {
+        return false;
+    }
+    logEnd_ = offset;
+    return true;
+}
+
+bool KVStore::set(const char* key, const void* value, size_t length, StorageError* error) {
+    size_t keyLen;
+    if (!validateKey(key, keyLen, error)) {
+        return false;
+    }
+
+    if ((value == nullptr && length > 0) || length > config_.maxValueSize) {
+        if (error) {
+            error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Invalid value size");
+        }
+        return false;
+    }
+
+    if (batching_ && pendingCount_ == config_.maxBatchSize) {
+        if (error) {
+            error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Batch is full");
+        }
+        return false;
+    }
+
+    PendingOp op;
+    op.hash = hashKey(key, keyLen);
+    op.valueLen = static_cast<uint16_t>(length);
+    op.keyLen = static_cast<uint8_t>(keyLen);
+    op.remove = 0;
+
+    // Reject new keys up front so a committed record always fits the index
+    if (count_ + pendingCount_ >= config_.maxKeys && findSlot(op.hash, key, op.keyLen) < 0) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_FULL, "Key-value store is full");
+        }
+        return false;
+    }
+
+    uint8_t type = TYPE_PUT | (batching_ ? 0 : FLAG_END);
+    if (!appendRecord(type, key, op.keyLen, value, op.valueLen, op.offset, error)) {
+        return false;
+    }
+
+    return queueOrApply(op, key, error);
+}
+
+bool KVStore::remove(const char* key, StorageError* error) {
+    size_t keyLen;
+    if (!validateKey(key, keyLen, error)) {
+        return false;
+    }
+
+    if (batching_ && pendingCount_ == config_.maxBatchSize) {
+        if (error) {
+            error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Batch is full");
+        }
+        return false;
+    }
+
+    PendingOp op;
+    op.hash = hashKey(key, keyLen);
+    op.valueLen = 0;
+    op.keyLen = static_cast<uint8_t>(keyLen);
+    op.remove = 1;
+
+    // Inside a batch the key may be created by an earlier operation
+    if (!batching_ && findSlot(op.hash, key, op.keyLen) < 0) {
+        if (error) {
+            error->setError(StorageErrorCode::FILE_NOT_FOUND, "Key not found");
+        }
+        return false;
+    }
+
+    uint8_t type = TYPE_REMOVE | (batching_ ? 0 : FLAG_END);
+    if (!appendRecord(type, key, op.keyLen, nullptr, 0, op.offset, error)) {
+        return false;
+    }
+
+    return queueOrApply(op, key, error);
+}
+
+size_t KVStore::get(const char* key, void* buffer, size_t size, StorageError* error) {
+    size_t keyLen;
+    if (!validateKey(key, keyLen, error)) {
+        return 0;
+    }
+
+    int index = findSlot(hashKey(key, keyLen), key, static_cast<uint8_t>(keyLen));
+    if (index < 0) {
+        if (error) {
+            error->setError(StorageErrorCode::FILE_NOT_FOUND, "Key not found");
+        }
+        return 0;
+    }
+
+    const Slot& slot = slots_[index];
+    size_t copy = size < slot.valueLen ? size : slot.valueLen;
+    if (copy > 0 && !readAt(slot.offset + HEADER_SIZE + slot.keyLen, buffer, copy)) {
+        if (error) {
+            error->setError(StorageErrorCode::READ_ERROR, "Failed to read value");
+        }
+        return 0;
+    }
+
+    return slot.valueLen;
+}
+
+bool KVStore::contains(const char* key) {
+    size_t keyLen;
+    if (!validateKey(key, keyLen, nullptr)) {
+        return false;
+    }
+
+    return findSlot(hashKey(key, keyLen), key, static_cast<uint8_t>(keyLen)) >= 0;
+}
+
+size_t KVStore::valueSize(const char* key) {
+    size_t keyLen;
+    if (!validateKey(key, keyLen, nullptr)) {
+        return 0;
+    }
+
+    int index = findSlot(hashKey(key, keyLen), key, static_cast<uint8_t>(keyLen));
+    return index >= 0 ? slots_[index].valueLen : 0;
+}
+
+bool KVStore::forEach(KVStoreCallback callback, void* context, StorageError* error) {
+    if (!active_ || callback == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Key-value store not started");
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i <= mask_; i++) {
+        const Slot& slot = slots_[i];
+        if (!slot.used) {
+            continue;
+        }
+
+        if (!readAt(slot.offset + HEADER_SIZE, scratch_, slot.keyLen + slot.valueLen)) {
+            if (error) {
+                error->setError(StorageErrorCode::READ_ERROR, "Failed to read record");
+            }
+            return false;
+        }
+
+        memcpy(keyBuf_, scratch_, slot.keyLen);
+        keyBuf_[slot.keyLen] = '\0';
+
+        if (!callback(keyBuf_, scratch_ + slot.keyLen, slot.valueLen, context)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool KVStore::beginBatch(StorageError* error) {
+    if (!active_ || batching_) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Cannot start a batch");
+        }
+        return false;
+    }
+
+    batching_ = true;
+    batchStart_ = logEnd_;
+    pendingCount_ = 0;
+    return true;
+}
+
+bool KVStore::commitBatch(StorageError* error) {
+    if (!batching_) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "No batch in progress");
+        }
+        return false;
+    }
+
+    if (pendingCount_ > 0) {
+        // Records of the batch are only applied at boot once this marker
+        // made it to flash
+        uint32_t offset;
+        if (!appendRecord(TYPE_COMMIT | FLAG_END, nullptr, 0, nullptr, 0, offset, error)) {
+            abortBatch(nullptr);
+            return false;
+        }
+
+        // As in queueOrApply(), a batch reported as failed must not be
+        // replayed at boot
+        bool synced = syncIfNeeded(error);
+        if (!synced && rollback(batchStart_)) {
+            pendingCount_ = 0;
+            batching_ = false;
+            return false;
+        }
+
+        if (!applyPending()) {
+            batching_ = false;
+            pendingCount_ = 0;
+            if (error && synced) {
+                error->setError(StorageErrorCode::READ_ERROR, "Failed to apply batch");
+            }
+            return false;
+        }
+        if (!synced) {
+            batching_ = false;
+            return false;
+        }
+    }
+
+    batching_ = false;
+    maybeCompact();
+    return true;
+}
+
+void KVStore::abortBatch(StorageError* error) {
+    if (!batching_) {
+        return;
+    }
+
+    file_.truncate(batchStart_, error);
+    logEnd_ = batchStart_;
+    pendingCount_ = 0;
+    batching_ = false;
+}
+
+void KVStore::maybeCompact() {
+    // Compact only when at least half of the log is dead, so every byte of
+    // live data is rewritten at most once per byte of new data written
+    if (logEnd_ >= config_.compactThreshold && logEnd_ - liveBytes_ >= liveBytes_) {
+        compact(nullptr);
+    }
+}
+
+bool KVStore::compact(StorageError* error) {
+    if (!active_ || batching_) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Cannot compact now");
+        }
+        return false;
+    }
+
+    char tmpPath[STORAGE_MAX_PATH_LENGTH];
+    tempPath(config_.path, tmpPath, sizeof(tmpPath));
+
+    QSPIFile tmp(tmpPath);
+    if (tmp.exists(nullptr)) {
+        tmp.remove(nullptr);
+    }
+    if (!tmp.open(FileMode::WRITE, error)) {
+        return false;
+    }
+
+    // Copy the live records; every one becomes a committed single write
+    for (size_t i = 0; i <= mask_; i++) {
+        const Slot& slot = slots_[i];
+        if (!slot.used) {
+            continue;
+        }
+
+        size_t size = recordSize(slot.keyLen, slot.valueLen);
+        if (!readAt(slot.offset, scratch_, size)) {
+            tmp.close(nullptr);
+            tmp.remove(nullptr);
+            if (error) {
+                error->setError(StorageErrorCode::READ_ERROR, "Failed to read record");
+            }
+            return false;
+        }
+
+        scratch_[2] = TYPE_PUT | FLAG_END;
+        uint32_t crc = recordCrc(scratch_, scratch_ + HEADER_SIZE, size - HEADER_SIZE);
+        scratch_[6] = static_cast<uint8_t>(crc);
+        scratch_[7] = static_cast<uint8_t>(crc >> 8);
+        scratch_[8] = static_cast<uint8_t>(crc >> 16);
+        scratch_[9] = static_cast<uint8_t>(crc >> 24);
+
+        if (tmp.write(scratch_, size, error) != size) {
+            tmp.close(nullptr);
+            tmp.remove(nullptr);
+            return false;
+        }
+    }
+
+    if (!tmp.close(error)) {
+        tmp.remove(nullptr);
+        return false;
+    }
+
+    // The rename atomically replaces the old log
+    file_.close(nullptr);
+    bool renamed = tmp.rename(config_.path, error);
+    if (!file_.open(config_.path, FileMode::READ_WRITE_CREATE, error)) {
+        active_ = false;
+        return false;
+    }
+    if (!renamed) {
+        return false;
+    }
+
+    // Records were written in slot order
+    uint32_t offset = 0;
+    for (size_t i = 0; i <= mask_; i++) {
+        if (slots_[i].used) {
+            slots_[i].offset = offset;
+            offset += recordSize(slots_[i].keyLen, slots_[i].valueLen);
+        }
+    }
+
+    logEnd_ = offset;
+    liveBytes_ = offset;
+    compactions_++;
+    return true;
+}
+
+void KVStore::getStats(KVStoreStats& stats) const {
+    stats.keys = count_;
+    stats.liveBytes = liveBytes_;
+    stats.logBytes = logEnd_;
+    stats.compactions = compactions_;
+}
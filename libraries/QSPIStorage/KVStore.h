@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_KV_STORE_H
+#define QSPI_KV_STORE_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+#include "QSPIFile.h"
+
+/**
+ * @struct KVStoreConfig
+ * @brief Configuration for KVStore::begin().
+ */
+struct KVStoreConfig {
+    const char* path = "/storage/kvstore.dat"; ///< Log file holding all records
+    size_t maxKeys = 128;                      ///< Capacity of the RAM index
+    size_t maxValueSize = 1024;                ///< Largest value accepted by set()
+    size_t maxBatchSize = 16;                  ///< Most operations in one batch
+    size_t compactThreshold = 32 * 1024;       ///< Smallest log size worth compacting
+    bool syncOnWrite = true;                   ///< fs_sync after every committed write
+};
+
+/**
+ * @struct KVStoreStats
+ * @brief Space accounting of a KVStore.
+ */
+struct KVStoreStats {
+    size_t keys;          ///< Number of stored keys
+    size_t liveBytes;     ///< Bytes of the log holding current values
+    size_t logBytes;      ///< Total size of the log file
+    uint32_t compactions; ///< Compactions run since begin()
+};
+
+/**
+ * @brief Callback invoked by KVStore::forEach() for every key.
+ * @return false to stop the iteration early
+ */
+typedef bool (*KVStoreCallback)(const char* key, const uint8_t* value, size_t length,
+                                void* context);
+
+/**
+ * @class KVStore
+ * @brief Key-value store on QSPI flash with an in-RAM hash index.
+ *
+ * Storing every setting as its own file costs a LittleFS file and its
+ * metadata per key. KVStore keeps all keys in one append-only log file
+ * and an open-addressing hash table in RAM that maps each key to the
+ * offset of its latest value, so lookups cost one hash probe plus one read.
+ *
+ * Every record carries a CRC-32. set() and remove() are committed
+ * individually; operations between beginBatch() and commitBatch() become
+ * visible together, both at runtime and after a power loss.
+ *
+ * Overwritten and removed values stay in the log until it is compacted. To
+ * bound flash wear, compaction only runs once the log is larger than
+ * compactThreshold and at least half of it is dead, so the live data is
+ * rewritten at most once for every equal amount of new data. The compacted
+ * log is written to a temporary file and swapped in with an atomic rename.
+ *
+ * @note KVStore is not thread safe. Use it from a single thread.
+ *
+ * @code
+ * KVStore kv;
+ * kv.begin();
+ *
+ * uint32_t boots = 0;
+ * kv.get("boots", &boots, sizeof(boots));
+ * boots++;
+ * kv.set("boots", &boots, sizeof(boots));
+ * @endcode
+ */
+class KVStore {
+public:
+    /// Bytes of framing stored in front of every record
+    static constexpr size_t HEADER_SIZE = 10;
+    /// Longest key accepted, excluding the terminator
+    static constexpr size_t MAX_KEY_LENGTH = 255;
+
+    KVStore();
+    ~KVStore();
+
+    KVStore(const KVStore&) = delete;
+    KVStore& operator=(const KVStore&) = delete;
+
+    /**
+     * @brief Open the store and rebuild the index from the log.
+     *
+     * A torn record or an uncommitted batch at the end of the log is
+     * dropped. A log holding values or batches larger than the configuration
+     * allows is left untouched and begin() fails.
+     *
+     * @param config Store configuration
+     * @param error Optional pointer to receive error details
+     * @return true if the store is ready
+     */
+    bool begin(const KVStoreConfig& config = KVStoreConfig(), StorageError* error = nullptr);
+
+    /**
+     * @brief Close the store. A pending batch is discarded.
+     */
+    void end();
+
+    /**
+     * @brief Store a value, replacing any previous one.
+     * @param key Null-terminated key, 1 to MAX_KEY_LENGTH characters
+     * @param value Value bytes
+     * @param length Value size, at most maxValueSize
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool set(const char* key, const void* value, size_t length, StorageError* error = nullptr);
+
+    /**
+     * @brief Read a value.
+     * @param key Key to look up
+     * @param buffer Destination buffer
+     * @param size Size of the destination buffer; at most this many bytes are copied
+     * @param error Optional pointer to receive error details
+     * @return Size of the stored value, or 0 if the key does not exist
+     */
+    size_t get(const char* key, void* buffer, size_t size, StorageError* error = nullptr);
+
+    /**
+     * @brief Check whether a key exists.
+     * @param key Key to look up
+     * @return true if the key exists
+     */
+    bool contains(const char* key);
+
+    /**
+     * @brief Get the size of a stored value.
+     * @param key Key to look up
+     * @return Value size, or 0 if the key does not exist
+     */
+    size_t valueSize(const char* key);
+
+    /**
+     * @brief Delete a key.
+     * @param key Key to delete
+     * @param error Optional pointer to receive error details
+     * @return true if the key was deleted
+     */
+    bool remove(const char* key, StorageError* error = nullptr);
+
+    /**
+     * @brief Call a function for every stored key.
+     *
+     * The key and value pointers are only valid during the callback.
+     *
+     * @param callback Function called for every key
+     * @param context User pointer passed to the callback
+     * @param error Optional pointer to receive error details
+     * @return true if all keys could be read
+     */
+    bool forEach(KVStoreCallback callback, void* context = nullptr, StorageError* error = nullptr);
+
+    /**
+     * @brief Start collecting set()/remove() calls into an atomic batch.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false if a batch is already open
+     */
+    bool beginBatch(StorageError* error = nullptr);
+
+    /**
+     * @brief Commit the batch; all its operations become visible at once.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool commitBatch(StorageError* error = nullptr);
+
+    /**
+     * @brief Discard the operations of the current batch.
+     * @param error Optional pointer to receive error details
+     */
+    void abortBatch(StorageError* error = nullptr);
+
+    /**
+     * @brief Rewrite the log with only the current values.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool compact(StorageError* error = nullptr);
+
+    /**
+     * @brief Get the number of stored keys.
+     */
+    size_t count() const { return count_; }
+
+    /**
+     * @brief Get space accounting for the store.
+     * @param stats Output structure
+     */
+    void getStats(KVStoreStats& stats) const;
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t offset;
+        uint16_t valueLen;
+        uint8_t keyLen;
+        uint8_t used;
+    };
+
+    struct PendingOp {
+        uint32_t hash;
+        uint32_t offset;
+        uint16_t valueLen;
+        uint8_t keyLen;
+        uint8_t remove;
+    };
+
+    KVStoreConfig config_;
+    QSPIFile file_;
+    Slot* slots_;
+    size_t mask_;
+    size_t count_;
+    PendingOp* pending_;
+    size_t pendingCount_;
+    uint8_t* scratch_;
+    char keyBuf_[MAX_KEY_LENGTH + 1];
+    bool active_;
+    bool batching_;
+    uint32_t batchStart_;
+    uint32_t logEnd_;
+    size_t liveBytes_;
+    uint32_t compactions_;
+
+    static uint32_t hashKey(const char* key, size_t length);
+    static uint32_t recordCrc(const uint8_t* header, const uint8_t* payload, size_t length);
+    static size_t recordSize(uint8_t keyLen, uint16_t valueLen) {
+        return HEADER_SIZE + keyLen + valueLen;
+    }
+
+    bool validateKey(const char* key, size_t& keyLen, StorageError* error);
+    bool readAt(uint32_t offset, void* buffer, size_t length);
+    bool appendRecord(uint8_t type, const char* key, uint8_t keyLen, const void* value,
+                      uint16_t valueLen, uint32_t& offset, StorageError* error);
+    bool checkRecord(uint32_t offset, const uint8_t* header, uint32_t crc);
+    bool recover(StorageError* error);
+    bool applyPending();
+    bool queueOrApply(const PendingOp& op, const char* key, StorageError* error);
+    bool applyOp(const PendingOp& op, const char* key);
+    int findSlot(uint32_t hash, const char* key, uint8_t keyLen);
+    void eraseSlot(size_t index);
+    bool syncIfNeeded(StorageError* error);
+    bool rollback(uint32_t offset);
+    void maybeCompact();
+    void releaseMemory();
+};
+
+#endif // QSPI_KV_STORE_H
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "MappedRegion.h"
+#include "QSPIFile.h"
+
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/cache.h>
+#include <cstring>
+
+#if DT_NODE_EXISTS(DT_NODELABEL(qspi_flash))
+#define QSPI_FLASH_NODE DT_NODELABEL(qspi_flash)
+
+#if DT_NODE_EXISTS(DT_CHILD(QSPI_FLASH_NODE, partitions))
+#define QSPI_PARTITION_ENTRY(node) {DT_PROP(node, label), DT_FIXED_PARTITION_ID(node)},
+
+static const struct {
+    const char* label;
+    uint8_t id;
+} qspi_partitions[] = {
+    DT_FOREACH_CHILD(DT_CHILD(QSPI_FLASH_NODE, partitions), QSPI_PARTITION_ENTRY)
+};
+#define QSPI_HAS_PARTITIONS 1
+#endif
+
+// The controller maps the whole flash chip at its qspi_mm address
+#if defined(CONFIG_STM32_MEMMAP) && DT_REG_HAS_NAME(DT_PARENT(QSPI_FLASH_NODE), qspi_mm)
+#define QSPI_XIP_BASE DT_REG_ADDR_BY_NAME(DT_PARENT(QSPI_FLASH_NODE), qspi_mm)
+#endif
+#endif
+
+// Asset pack layout: table of contents in the first sector, data after it
+static constexpr uint8_t PACK_MAGIC[4] = {'A', 'P', 'K', '1'};
+static constexpr size_t PACK_SECTOR_SIZE = 4096;
+static constexpr size_t PACK_DATA_START = PACK_SECTOR_SIZE;
+static constexpr size_t PACK_ALIGNMENT = 32;
+// Erase in larger steps so the driver can use block erase commands
+static constexpr size_t PACK_ERASE_AHEAD = 64 * 1024;
+
+struct PackHeader {
+    uint8_t magic[4];
+    uint32_t count;
+    uint32_t tocCrc;   // CRC-32 of the entry table
+    uint32_t reserved;
+};
+
+static bool openPartition(const char* label, const struct flash_area** area, StorageError* error) {
+#ifdef QSPI_HAS_PARTITIONS
+    if (label != nullptr) {
+        for (size_t i = 0; i < sizeof(qspi_partitions) / sizeof(qspi_partitions[0]); i++) {
+            if (strcmp(qspi_partitions[i].label, label) == 0) {
+                if (flash_area_open(qspi_partitions[i].id, area) == 0) {
+                    return true;
+                }
+                if (error) {
+                    error->setError(StorageErrorCode::HARDWARE_ERROR, "Failed to open partition");
+                }
+                return false;
+            }
+        }
+    }
+#endif
+
+    if (error) {
+        error->setError(StorageErrorCode::INVALID_PATH, "Unknown flash partition");
+    }
+    return false;
+}
+
+// ==================== MappedRegion ====================
+
+MappedRegion::MappedRegion() : area_(nullptr), offset_(0), length_(0) {
+}
+
+MappedRegion::~MappedRegion() {
+    unmap();
+}
+
+bool MappedRegion::isSupported() {
+#ifdef QSPI_XIP_BASE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MappedRegion::map(const char* label, StorageError* error) {
+    return map(label, 0, SIZE_MAX, error);
+}
+
+bool MappedRegion::map(const char* label, size_t offset, size_t length, StorageError* error) {
+    unmap();
+
+    if (!isSupported()) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION,
+                "Memory-mapped flash is not supported on this board");
+        }
+        return false;
+    }
+
+    const struct flash_area* area;
+    if (!openPartition(label, &area, error)) {
+        return false;
+    }
+
+    if (offset > area->fa_size) {
+        flash_area_close(area);
+        if (error) {
+            error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Range outside the partition");
+        }
+        return false;
+    }
+    if (length > area->fa_size - offset) {
+        if (length != SIZE_MAX) {
+            flash_area_close(area);
+            if (error) {
+                error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Range outside the partition");
+            }
+            return false;
+        }
+        length = area->fa_size - offset;
+    }
+
+    area_ = area;
+    offset_ = offset;
+    length_ = length;
+
+#ifdef QSPI_XIP_BASE
+    // The range may have been rewritten through the driver since it was
+    // last read through the window
+    sys_cache_data_invd_range(reinterpret_cast<void*>(QSPI_XIP_BASE + area_->fa_off + offset_),
+                              length_);
+#endif
+
+    return true;
+}
+
+bool MappedRegion::mapAsset(const char* label, const char* name, StorageError* error) {
+    unmap();
+
+    if (name == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "No asset name specified");
+        }
+        return false;
+    }
+
+    const struct flash_area* area;
+    if (!openPartition(label, &area, error)) {
+        return false;
+    }
+
+    // Read the table of contents through the driver; only the asset itself
+    // is accessed through the window
+    PackHeader header;
+    bool valid = flash_area_read(area, 0, &header, sizeof(header)) == 0 &&
+                 memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0 &&
+                 header.count <= AssetPackWriter::MAX_ASSETS;
+
+    uint32_t crc = 0;
+    size_t found = SIZE_MAX;
+    uint32_t assetOffset = 0;
+    uint32_t assetLength = 0;
+    uint32_t assetCrc = 0;
+
+    for (uint32_t i = 0; valid && i < header.count; i++) {
+        struct {
+            char name[AssetPackWriter::MAX_NAME_LENGTH + 1];
+            uint32_t offset;
+            uint32_t length;
+            uint32_t crc;
+        } entry;
+
+        if (flash_area_read(area, sizeof(header) + i * sizeof(entry), &entry, sizeof(entry)) != 0) {
+            valid = false;
+            break;
+        }
+        crc = crc32_ieee_update(crc, reinterpret_cast<const uint8_t*>(&entry), sizeof(entry));
+
+        entry.name[AssetPackWriter::MAX_NAME_LENGTH] = '\0';
+        if (found == SIZE_MAX && strcmp(entry.name, name) == 0) {
+            found = i;
+            assetOffset = entry.offset;
+            assetLength = entry.length;
+            assetCrc = entry.crc;
+        }
+    }
+    flash_area_close(area);
+
+    if (!valid || crc != header.tocCrc) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "No valid asset pack in partition");
+        }
+        return false;
+    }
+
+    if (found == SIZE_MAX) {
+        if (error) {
+            error->setError(StorageErrorCode::FILE_NOT_FOUND, "Asset not found");
+        }
+        return false;
+    }
+
+    if (!map(label, assetOffset, assetLength, error)) {
+        return false;
+    }
+
+    // Catch assets damaged after the pack was written
+    if (crc32_ieee_update(0, data(), length_) != assetCrc) {
+        unmap();
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Asset checksum mismatch");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void MappedRegion::unmap() {
+    if (area_ != nullptr) {
+        flash_area_close(area_);
+        area_ = nullptr;
+    }
+    offset_ = 0;
+    length_ = 0;
+}
+
+const uint8_t* MappedRegion::data() {
+    if (area_ == nullptr) {
+        return nullptr;
+    }
+
+#ifdef QSPI_XIP_BASE
+    // Writes and erases switch the controller to indirect mode; any read
+    // through the driver switches it back to memory-mapped mode
+    uint8_t probe;
+    flash_area_read(area_, offset_, &probe, sizeof(probe));
+    return reinterpret_cast<const uint8_t*>(QSPI_XIP_BASE + area_->fa_off + offset_);
+#else
+    return nullptr;
+#endif
+}
+
+// ==================== AssetPackWriter ====================
+
+AssetPackWriter::AssetPackWriter()
+    : area_(nullptr), entries_(nullptr), count_(0), cursor_(0), erased_(0) {
+}
+
+AssetPackWriter::~AssetPackWriter() {
+    close();
+}
+
+void AssetPackWriter::close() {
+    if (area_ != nullptr) {
+        flash_area_close(area_);
+        area_ = nullptr;
+    }
+    delete[] entries_;
+    entries_ = nullptr;
+    count_ = 0;
+}
+
+size_t AssetPackWriter::available() const {
+    if (area_ == nullptr || cursor_ >= area_->fa_size) {
+        return 0;
+    }
+    return area_->fa_size - cursor_;
+}
+
+bool AssetPackWriter::begin(const char* label, StorageError* error) {
+    close();
+
+    if (!openPartition(label, &area_, error)) {
+        return false;
+    }
+
+    if (area_->fa_size <= PACK_DATA_START) {
+        close();
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_FULL, "Partition too small for an asset pack");
+        }
+        return false;
+    }
+
+    entries_ = new Entry[MAX_ASSETS];
+    if (entries_ == nullptr) {
+        close();
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate asset table");
+        }
+        return false;
+    }
+
+    // Erasing the table first invalidates the old pack right away
+    if (flash_area_erase(area_, 0, PACK_SECTOR_SIZE) != 0) {
+        close();
+        if (error) {
+            error->setError(StorageErrorCode::HARDWARE_ERROR, "Failed to erase asset table");
+        }
+        return false;
+    }
+
+    cursor_ = PACK_DATA_START;
+    erased_ = PACK_DATA_START;
+    return true;
+}
+
+bool AssetPackWriter::startAsset(const char* name, StorageError* error) {
+    if (area_ == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Asset pack not started");
+        }
+        return false;
+    }
+
+    if (name == nullptr || name[0] == '\0' || strlen(name) > MAX_NAME_LENGTH) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Invalid asset name");
+        }
+        return false;
+    }
+
+    if (count_ >= MAX_ASSETS) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_FULL, "Too many assets");
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < count_; i++) {
+        if (strcmp(entries_[i].name, name) == 0) {
+            if (error) {
+                error->setError(StorageErrorCode::ALREADY_EXISTS, "Asset already added");
+            }
+            return false;
+        }
+    }
+
+    Entry& entry = entries_[count_];
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, name, MAX_NAME_LENGTH);
+    entry.offset = cursor_;
+    return true;
+}
+
+bool AssetPackWriter::append(const uint8_t* data, size_t length, StorageError* error) {
+    if (length > available()) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_FULL, "Asset pack partition full");
+        }
+        return false;
+    }
+
+    if (cursor_ + length > erased_) {
+        size_t end = cursor_ + length;
+        if (end < erased_ + PACK_ERASE_AHEAD) {
+            end = erased_ + PACK_ERASE_AHEAD;
+        }
+        end = (end + PACK_SECTOR_SIZE - 1) & ~(PACK_SECTOR_SIZE - 1);
+        if (end > area_->fa_size) {
+            end = area_->fa_size;
+        }
+
+        if (flash_area_erase(area_, erased_, end - erased_) != 0) {
+            if (error) {
+                error->setError(StorageErrorCode::HARDWARE_ERROR, "Failed to erase asset data");
+            }
+            return false;
+        }
+        erased_ = end;
+    }
+
+    if (flash_area_write(area_, cursor_, data, length) != 0) {
+        if (error) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Failed to write asset data");
+        }
+        return false;
+    }
+
+    Entry& entry = entries_[count_];
+    entry.crc = crc32_ieee_update(entry.crc, data, length);
+    entry.length += length;
+    cursor_ += length;
+    return true;
+}
+
+void AssetPackWriter::endAsset() {
+    count_++;
+    // Start the next asset on an aligned address so typed data can be
+    // read in place
+    cursor_ = (cursor_ + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+}
+
+bool AssetPackWriter::add(const char* name, const void* data, size_t length, StorageError* error) {
+    if (!startAsset(name, error)) {
+        return false;
+    }
+
+    if (length > 0 && !append(static_cast<const uint8_t*>(data), length, error)) {
+        return false;
+    }
+
+    endAsset();
+    return true;
+}
+
+bool AssetPackWriter::addFile(const char* name, const char* path, StorageError* error) {
+    if (!startAsset(name, error)) {
+        return false;
+    }
+
+    QSPIFile file(path);
+    if (!file.open(FileMode::READ, error)) {
+        return false;
+    }
+
+    uint8_t* buffer = new uint8_t[PACK_SECTOR_SIZE];
+    if (buffer == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate copy buffer");
+        }
+        return false;
+    }
+
+    bool ok = true;
+    size_t remaining = file.size();
+    while (ok && remaining > 0) {
+        size_t bytesRead = file.read(buffer, PACK_SECTOR_SIZE, error);
+        if (bytesRead == 0) {
+            if (error && !error->hasError()) {
+                error->setError(StorageErrorCode::READ_ERROR, "Short read from asset file");
+            }
+            ok = false;
+            break;
+        }
+        ok = append(buffer, bytesRead, error);
+        remaining -= bytesRead < remaining ? bytesRead : remaining;
+    }
+
+    delete[] buffer;
+    file.close(nullptr);
+
+    if (!ok) {
+        // Leave the slot unused; the data written so far is simply skipped
+        cursor_ = (cursor_ + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+        return false;
+    }
+
+    endAsset();
+    return true;
+}
+
+bool AssetPackWriter::finish(StorageError* error) {
+    if (area_ == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Asset pack not started");
+        }
+        return false;
+    }
+
+    static_assert(sizeof(PackHeader) + MAX_ASSETS * sizeof(Entry) <= PACK_SECTOR_SIZE,
+                  "Asset table must fit in one sector");
+
+    PackHeader header;
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.count = count_;
+    header.tocCrc = crc32_ieee_update(0, reinterpret_cast<const uint8_t*>(entries_),
+                                      count_ * sizeof(Entry));
+    header.reserved = 0;
+
+    // Entries first, header last: the pack only becomes valid once the
+    // magic is on flash
+    bool ok = count_ == 0 ||
+              flash_area_write(area_, sizeof(header), entries_, count_ * sizeof(Entry)) == 0;
+    ok = ok && flash_area_write(area_, 0, &header, sizeof(header)) == 0;
+
+    close();
+
+    if (!ok) {
+        if (error) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Failed to write asset table");
+        }
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_MAPPED_REGION_H
+#define QSPI_MAPPED_REGION_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+
+// Forward declaration - avoid including zephyr headers in public header
+struct flash_area;
+
+/**
+ * @class MappedRegion
+ * @brief Read-only, zero-copy access to QSPI flash through the XIP window.
+ *
+ * On boards whose QSPI controller supports memory-mapped mode (GIGA R1,
+ * Portenta H7 and Opta with CONFIG_STM32_MEMMAP), flash contents can be read
+ * through a plain pointer. A MappedRegion exposes either a whole raw
+ * partition, such as "wlan" or "4343WA1.bin", or one asset stored by
+ * AssetPackWriter, without copying anything into RAM.
+ *
+ * Files on the LittleFS and FAT mounts are not stored contiguously and
+ * cannot be mapped; store read-mostly data as assets instead.
+ *
+ * @warning The flash leaves memory-mapped mode while it is written or erased
+ * through any partition. Call data() again after storage writes instead of
+ * keeping the pointer, and do not read the region while another thread
+ * writes to the QSPI flash.
+ *
+ * @code
+ * MappedRegion certs;
+ * if (certs.map("wlan")) {
+ *     const uint8_t* p = certs.data();
+ *     parse(p, certs.size());
+ * }
+ * @endcode
+ */
+class MappedRegion {
+public:
+    MappedRegion();
+    ~MappedRegion();
+
+    MappedRegion(const MappedRegion&) = delete;
+    MappedRegion& operator=(const MappedRegion&) = delete;
+
+    /**
+     * @brief Map a whole raw flash partition.
+     * @param label Partition label from the devicetree (e.g. "wlan", "ota")
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool map(const char* label, StorageError* error = nullptr);
+
+    /**
+     * @brief Map a byte range of a raw flash partition.
+     * @param label Partition label from the devicetree
+     * @param offset Start of the range within the partition
+     * @param length Length of the range in bytes
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool map(const char* label, size_t offset, size_t length, StorageError* error = nullptr);
+
+    /**
+     * @brief Map one asset of an asset pack written by AssetPackWriter.
+     * @param label Partition holding the asset pack
+     * @param name Asset name
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool mapAsset(const char* label, const char* name, StorageError* error = nullptr);
+
+    /**
+     * @brief Release the mapping.
+     */
+    void unmap();
+
+    /**
+     * @brief Get a pointer to the mapped bytes.
+     *
+     * Re-enters memory-mapped mode if a flash write or erase left it.
+     *
+     * @return Pointer into the XIP window, or nullptr if not mapped
+     */
+    const uint8_t* data();
+
+    /**
+     * @brief Get the mapped length in bytes.
+     */
+    size_t size() const { return length_; }
+
+    /**
+     * @brief Check if a region is mapped.
+     */
+    bool isMapped() const { return area_ != nullptr; }
+
+    /**
+     * @brief Check if this board can map QSPI flash.
+     * @return true if memory-mapped access is available
+     */
+    static bool isSupported();
+
+private:
+    const struct flash_area* area_;
+    size_t offset_;
+    size_t length_;
+};
+
+/**
+ * @class AssetPackWriter
+ * @brief Stores files contiguously in a raw partition so they can be mapped.
+ *
+ * An asset pack is a table of contents in the first 4 KB sector of a raw
+ * partition followed by the asset data, each asset starting on a 32 byte
+ * boundary. The table of contents is written last by finish(), so an
+ * interrupted write leaves no valid pack behind.
+ *
+ * @warning begin() erases the partition. Only use a partition that is not
+ * mounted as a filesystem, or whose filesystem may be destroyed.
+ *
+ * @code
+ * AssetPackWriter pack;
+ * pack.begin("ota");
+ * pack.addFile("lut", "/storage/lut.bin");
+ * pack.finish();
+ *
+ * MappedRegion lut;
+ * lut.mapAsset("ota", "lut");
+ * @endcode
+ */
+class AssetPackWriter {
+public:
+    /// Longest asset name, excluding the terminator
+    static constexpr size_t MAX_NAME_LENGTH = 31;
+    /// Most assets in one pack
+    static constexpr size_t MAX_ASSETS = 64;
+
+    AssetPackWriter();
+    ~AssetPackWriter();
+
+    AssetPackWriter(const AssetPackWriter&) = delete;
+    AssetPackWriter& operator=(const AssetPackWriter&) = delete;
+
+    /**
+     * @brief Start a new pack, erasing the previous one.
+     * @param label Partition label from the devicetree
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool begin(const char* label, StorageError* error = nullptr);
+
+    /**
+     * @brief Add an asset from memory.
+     * @param name Asset name, at most MAX_NAME_LENGTH characters
+     * @param data Asset contents
+     * @param length Asset size in bytes
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool add(const char* name, const void* data, size_t length, StorageError* error = nullptr);
+
+    /**
+     * @brief Add an asset from a file, e.g. one downloaded to /storage.
+     * @param name Asset name, at most MAX_NAME_LENGTH characters
+     * @param path Path of the source file
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool addFile(const char* name, const char* path, StorageError* error = nullptr);
+
+    /**
+     * @brief Write the table of contents and close the pack.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool finish(StorageError* error = nullptr);
+
+    /**
+     * @brief Free space left in the partition in bytes.
+     */
+    size_t available() const;
+
+private:
+    struct Entry {
+        char name[MAX_NAME_LENGTH + 1];
+        uint32_t offset;
+        uint32_t length;
+        uint32_t crc;
+    };
+
+    const struct flash_area* area_;
+    Entry* entries_;
+    size_t count_;
+    size_t cursor_;  // Next free byte
+    size_t erased_;  // Bytes erased from the start of the partition
+
+    bool startAsset(const char* name, StorageError* error);
+    bool append(const uint8_t* data, size_t length, StorageError* error);
+    void endAsset();
+    void close();
+};
+
+#endif // QSPI_MAPPED_REGION_H
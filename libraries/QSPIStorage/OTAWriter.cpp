@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "OTAWriter.h"
+
+#include <zephyr/fs/fs.h>
+#include <zephyr/storage/flash_map.h>
+#include <errno.h>
+#include <cstring>
+
+#if defined(CONFIG_MBEDTLS)
+#include <mbedtls/sha256.h>
+#endif
+
+#if DT_NODE_EXISTS(DT_NODELABEL(ota_fs))
+// FAT mount created by the devicetree fstab entry for /ota:, exported to
+// sketches by the loader
+FS_FSTAB_DECLARE_ENTRY(DT_NODELABEL(ota_fs));
+#define OTA_FSTAB_MOUNT (&FS_FSTAB_ENTRY(DT_NODELABEL(ota_fs)))
+#endif
+
+#ifndef OTA_WRITER_STACK_SIZE
+#define OTA_WRITER_STACK_SIZE 2048
+#endif
+
+#ifndef OTA_WRITER_PRIORITY
+#define OTA_WRITER_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+#endif
+
+// Flash geometry of the QSPI NOR parts used on these boards
+static constexpr size_t OTA_PAGE_SIZE = 256;
+static constexpr size_t OTA_SECTOR_SIZE = 4096;
+static constexpr size_t OTA_BLOCK_SIZE = 64 * 1024;
+// Programs are split so erase-ahead and progress reports interleave
+static constexpr size_t OTA_PROGRAM_CHUNK = 4096;
+// How far ahead of the received data to erase when the image size is unknown
+static constexpr size_t OTA_ERASE_AHEAD = 256 * 1024;
+static constexpr size_t OTA_BUFFER_ALIGNMENT = 32;
+
+K_THREAD_STACK_DEFINE(ota_writer_stack, OTA_WRITER_STACK_SIZE);
+static struct k_thread ota_writer_thread;
+static struct k_mutex worker_lock;
+static struct k_sem work_available;
+static OTAWriter* active_writer = nullptr;
+static bool worker_started = false;
+
+void OTAWriter::startWorker() {
+    k_sched_lock();
+    if (!worker_started) {
+        k_mutex_init(&worker_lock);
+        k_sem_init(&work_available, 0, 1);
+        k_thread_create(&ota_writer_thread, ota_writer_stack,
+                        K_THREAD_STACK_SIZEOF(ota_writer_stack), workerEntry, nullptr, nullptr,
+                        nullptr, OTA_WRITER_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&ota_writer_thread, "ota_writer");
+        worker_started = true;
+    }
+    k_sched_unlock();
+}
+
+void OTAWriter::workerEntry(void* p1, void* p2, void* p3) {
+    for (;;) {
+        k_sem_take(&work_available, K_FOREVER);
+
+        // Holding the worker lock keeps the writer from being released
+        // while a flash operation is in progress
+        k_mutex_lock(&worker_lock, K_FOREVER);
+        if (active_writer != nullptr) {
+            while (active_writer->step()) {
+            }
+        }
+        k_mutex_unlock(&worker_lock);
+    }
+}
+
+OTAWriter::OTAWriter()
+    : area_(nullptr), buffer_(nullptr), allocation_(nullptr), capacity_(0), head_(0), count_(0),
+      imageSize_(0), received_(0), programmed_(0), erased_(0), finishing_(false), active_(false),
+      finished_(false), error_(0), sha_(nullptr), startMs_(0), endMs_(0), eraseMs_(0),
+      programMs_(0), stalls_(0) {
+    memset(digest_, 0, sizeof(digest_));
+    k_mutex_init(&lock_);
+    k_condvar_init(&changed_);
+}
+
+OTAWriter::~OTAWriter() {
+    abort();
+}
+
+size_t OTAWriter::capacity() {
+#if FIXED_PARTITION_EXISTS(ota_partition)
+    return FIXED_PARTITION_SIZE(ota_partition);
+#else
+    return 0;
+#endif
+}
+
+bool OTAWriter::begin(size_t imageSize, size_t bufferSize, uint8_t* buffer, StorageError* error) {
+    abort();
+
+#if FIXED_PARTITION_EXISTS(ota_partition)
+    if (bufferSize == 0 || bufferSize % OTA_SECTOR_SIZE != 0 ||
+        reinterpret_cast<uintptr_t>(buffer) % OTA_BUFFER_ALIGNMENT != 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION,
+                "Staging buffer must be a 32 byte aligned multiple of 4096 bytes");
+        }
+        return false;
+    }
+
+    if (imageSize > capacity()) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_FULL, "Image larger than the OTA partition");
+        }
+        return false;
+    }
+
+#ifdef OTA_FSTAB_MOUNT
+    // The raw image overwrites the FAT volume; release it first
+    struct fs_statvfs stat;
+    if (fs_statvfs(OTA_FSTAB_MOUNT->mnt_point, &stat) == 0 && fs_unmount(OTA_FSTAB_MOUNT) < 0) {
+        if (error) {
+            error->setError(StorageErrorCode::HARDWARE_ERROR, "Failed to unmount /ota:");
+        }
+        return false;
+    }
+#endif
+
+    if (flash_area_open(FIXED_PARTITION_ID(ota_partition), &area_) != 0) {
+        area_ = nullptr;
+        if (error) {
+            error->setError(StorageErrorCode::HARDWARE_ERROR, "Failed to open OTA partition");
+        }
+        return false;
+    }
+
+    buffer_ = buffer;
+    if (buffer_ == nullptr) {
+        allocation_ = new uint8_t[bufferSize + OTA_BUFFER_ALIGNMENT - 1];
+        if (allocation_ == nullptr) {
+            release();
+            if (error) {
+                error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate staging buffer");
+            }
+            return false;
+        }
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(allocation_) + OTA_BUFFER_ALIGNMENT - 1) &
+                            ~static_cast<uintptr_t>(OTA_BUFFER_ALIGNMENT - 1);
+        buffer_ = reinterpret_cast<uint8_t*>(aligned);
+    }
+
+#if defined(CONFIG_MBEDTLS)
+    mbedtls_sha256_context* sha = new mbedtls_sha256_context;
+    if (sha == nullptr) {
+        release();
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate hash context");
+        }
+        return false;
+    }
+    mbedtls_sha256_init(sha);
+    mbedtls_sha256_starts(sha, 0);
+    sha_ = sha;
+#endif
+
+    capacity_ = bufferSize;
+    head_ = 0;
+    count_ = 0;
+    imageSize_ = imageSize;
+    received_ = 0;
+    programmed_ = 0;
+    erased_ = 0;
+    finishing_ = false;
+    finished_ = false;
+    error_ = 0;
+    memset(digest_, 0, sizeof(digest_));
+    startMs_ = 0;
+    endMs_ = 0;
+    eraseMs_ = 0;
+    programMs_ = 0;
+    stalls_ = 0;
+    active_ = true;
+
+    startWorker();
+
+    k_mutex_lock(&worker_lock, K_FOREVER);
+    if (active_writer != nullptr) {
+        k_mutex_unlock(&worker_lock);
+        active_ = false;
+        release();
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Another OTA update is in progress");
+        }
+        return false;
+    }
+    active_writer = this;
+    k_mutex_unlock(&worker_lock);
+
+    // Start erasing while the caller sets up the download
+    k_sem_give(&work_available);
+    return true;
+#else
+    if (error) {
+        error->setError(StorageErrorCode::INVALID_OPERATION, "No OTA partition on this board");
+    }
+    return false;
+#endif
+}
+
+bool OTAWriter::step() {
+    k_mutex_lock(&lock_, K_FOREVER);
+
+    if (!active_) {
+        k_mutex_unlock(&lock_);
+        return false;
+    }
+
+    if (error_ != 0 && count_ > 0) {
+        // Staged data can no longer be written; the error reports the loss
+        head_ = 0;
+        count_ = 0;
+        k_condvar_broadcast(&changed_);
+    }
+
+    // Program whole pages from the oldest contiguous run of the ring; the
+    // tail of the image is flushed by finish()
+    size_t tail = (head_ + capacity_ - count_) % capacity_;
+    size_t chunk = capacity_ - tail < count_ ? capacity_ - tail : count_;
+    if (chunk > OTA_PROGRAM_CHUNK) {
+        chunk = OTA_PROGRAM_CHUNK;
+    }
+    if (!finishing_) {
+        chunk -= chunk % OTA_PAGE_SIZE;
+    }
+
+    size_t limit = imageSize_ != 0 ? imageSize_ : received_ + OTA_ERASE_AHEAD;
+    if (finishing_ || programmed_ + chunk > limit) {
+        limit = programmed_ + chunk;
+    }
+    limit = (limit + OTA_SECTOR_SIZE - 1) & ~(OTA_SECTOR_SIZE - 1);
+    if (limit > area_->fa_size) {
+        limit = area_->fa_size;
+    }
+
+    bool erase = erased_ < limit && (chunk == 0 || programmed_ + chunk > erased_);
+    if (error_ != 0 || (chunk == 0 && !erase)) {
+        k_mutex_unlock(&lock_);
+        return false;
+    }
+
+    if (erase) {
+        // Erase a whole block where possible, it takes less time than the
+        // same range in sectors
+        size_t offset = erased_;
+        size_t length = OTA_SECTOR_SIZE;
+        if (offset % OTA_BLOCK_SIZE == 0 && offset + OTA_BLOCK_SIZE <= limit) {
+            length = OTA_BLOCK_SIZE;
+        }
+
+        k_mutex_unlock(&lock_);
+        uint32_t start = millis();
+        int ret = flash_area_erase(area_, offset, length);
+        uint32_t elapsed = millis() - start;
+        k_mutex_lock(&lock_, K_FOREVER);
+
+        eraseMs_ += elapsed;
+        if (ret < 0) {
+            error_ = ret;
+        } else {
+            erased_ += length;
+        }
+    } else {
+        size_t offset = programmed_;
+        const uint8_t* data = buffer_ + tail;
+
+        k_mutex_unlock(&lock_);
+        uint32_t start = millis();
+        int ret = flash_area_write(area_, offset, data, chunk);
+        uint32_t elapsed = millis() - start;
+        k_mutex_lock(&lock_, K_FOREVER);
+
+        programMs_ += elapsed;
+        if (ret < 0) {
+            error_ = ret;
+        } else {
+            programmed_ += chunk;
+            count_ -= chunk;
+        }
+    }
+
+    k_condvar_broadcast(&changed_);
+    k_mutex_unlock(&lock_);
+    return true;
+}
+
+size_t OTAWriter::write(const uint8_t* data, size_t length, StorageError* error) {
+    if (!active_ || finishing_) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "OTA update not started");
+        }
+        return 0;
+    }
+
+    if (data == nullptr || length == 0) {
+        return 0;
+    }
+
+    if ((imageSize_ != 0 && received_ + length > imageSize_) ||
+        received_ + length > area_->fa_size) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_FULL, "Data exceeds the image size");
+        }
+        return 0;
+    }
+
+#if defined(CONFIG_MBEDTLS)
+    // Hashing here overlaps with the storage thread's flash operations
+    mbedtls_sha256_update(static_cast<mbedtls_sha256_context*>(sha_), data, length);
+#endif
+
+    k_mutex_lock(&lock_, K_FOREVER);
+
+    if (startMs_ == 0) {
+        startMs_ = millis();
+    }
+
+    size_t remaining = length;
+    while (remaining > 0 && error_ == 0) {
+        if (count_ == capacity_) {
+            // Back-pressure: let the storage thread catch up
+            stalls_++;
+            k_sem_give(&work_available);
+            k_condvar_wait(&changed_, &lock_, K_FOREVER);
+            continue;
+        }
+
+        size_t space = capacity_ - count_;
+        size_t contiguous = capacity_ - head_;
+        size_t chunk = remaining;
+        if (chunk > space) {
+            chunk = space;
+        }
+        if (chunk > contiguous) {
+            chunk = contiguous;
+        }
+
+        memcpy(buffer_ + head_, data, chunk);
+        head_ = (head_ + chunk) % capacity_;
+        count_ += chunk;
+        received_ += chunk;
+        data += chunk;
+        remaining -= chunk;
+    }
+
+    int ret = error_;
+    k_mutex_unlock(&lock_);
+    k_sem_give(&work_available);
+
+    if (ret != 0) {
+        if (error) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Failed to write OTA partition");
+        }
+        return 0;
+    }
+
+    return length;
+}
+
+bool OTAWriter::finish(StorageError* error) {
+    if (!active_) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "OTA update not started");
+        }
+        return false;
+    }
+
+    k_mutex_lock(&lock_, K_FOREVER);
+    finishing_ = true;
+    k_sem_give(&work_available);
+    while (count_ > 0 && error_ == 0) {
+        k_condvar_wait(&changed_, &lock_, K_FOREVER);
+    }
+    int ret = error_;
+    endMs_ = millis();
+    k_mutex_unlock(&lock_);
+
+#if defined(CONFIG_MBEDTLS)
+    mbedtls_sha256_finish(static_cast<mbedtls_sha256_context*>(sha_), digest_);
+#endif
+
+    size_t expected = imageSize_;
+    abort();
+
+    if (ret != 0) {
+        if (error) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Failed to write OTA partition");
+        }
+        return false;
+    }
+
+    if (expected != 0 && programmed_ != expected) {
+        if (error) {
+            error->setError(StorageErrorCode::WRITE_ERROR, "Image shorter than announced");
+        }
+        return false;
+    }
+
+    finished_ = true;
+    return true;
+}
+
+void OTAWriter::abort() {
+    if (!active_) {
+        return;
+    }
+
+    k_mutex_lock(&lock_, K_FOREVER);
+    active_ = false;
+    k_condvar_broadcast(&changed_);
+    k_mutex_unlock(&lock_);
+
+    // Waits for a flash operation in progress to complete
+    k_mutex_lock(&worker_lock, K_FOREVER);
+    if (active_writer == this) {
+        active_writer = nullptr;
+    }
+    k_mutex_unlock(&worker_lock);
+
+    release();
+}
+
+void OTAWriter::release() {
+#if defined(CONFIG_MBEDTLS)
+    if (sha_ != nullptr) {
+        mbedtls_sha256_free(static_cast<mbedtls_sha256_context*>(sha_));
+        delete static_cast<mbedtls_sha256_context*>(sha_);
+    }
+#endif
+    sha_ = nullptr;
+
+    delete[] allocation_;
+    allocation_ = nullptr;
+    buffer_ = nullptr;
+
+    if (area_ != nullptr) {
+        flash_area_close(area_);
+        area_ = nullptr;
+    }
+}
+
+bool OTAWriter::getSha256(uint8_t* digest) const {
+#if defined(CONFIG_MBEDTLS)
+    if (finished_ && digest != nullptr) {
+        memcpy(digest, digest_, sizeof(digest_));
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool OTAWriter::verify(const uint8_t* expected, StorageError* error) const {
+    uint8_t digest[SHA256_SIZE];
+    if (!getSha256(digest)) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "No image digest available");
+        }
+        return false;
+    }
+
+    // Compare every byte so the time taken does not depend on the contents
+    uint8_t diff = 0;
+    for (size_t i = 0; i < SHA256_SIZE; i++) {
+        diff |= digest[i] ^ expected[i];
+    }
+
+    if (diff != 0) {
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_CORRUPTED, "Image digest mismatch");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+OTAWriterStats OTAWriter::getStats() {
+    k_mutex_lock(&lock_, K_FOREVER);
+
+    OTAWriterStats stats;
+    stats.bytesWritten = programmed_;
+    stats.eraseMs = eraseMs_;
+    stats.programMs = programMs_;
+    stats.stalls = stalls_;
+
+    uint32_t end = active_ ? millis() : endMs_;
+    stats.elapsedMs = startMs_ != 0 ? end - startMs_ : 0;
+    stats.bytesPerSecond = stats.elapsedMs != 0
+        ? static_cast<uint32_t>(static_cast<uint64_t>(programmed_) * 1000 / stats.elapsedMs)
+        : 0;
+
+    k_mutex_unlock(&lock_);
+    return stats;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_OTA_WRITER_H
+#define QSPI_OTA_WRITER_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+
+// Forward declaration - avoid including zephyr headers in public header
+struct flash_area;
+
+/**
+ * @brief Throughput counters of an OTAWriter.
+ */
+struct OTAWriterStats {
+    size_t bytesWritten;     ///< Bytes programmed to flash
+    uint32_t elapsedMs;      ///< Time from the first write() to finish()
+    uint32_t bytesPerSecond; ///< Sustained write rate over elapsedMs
+    uint32_t eraseMs;        ///< Time the flash spent erasing
+    uint32_t programMs;      ///< Time the flash spent programming
+    uint32_t stalls;         ///< Times write() waited for the staging buffer
+};
+
+/**
+ * @class OTAWriter
+ * @brief Streams an update image into the raw "ota" partition.
+ *
+ * write() accepts chunks of any size, as they arrive from the network, and
+ * copies them into an aligned staging ring. A storage thread programs whole
+ * flash pages from the ring and uses idle time to erase sectors ahead of the
+ * write cursor, so the caller rarely waits for an erase. A SHA-256 digest of
+ * the image is computed while it is written.
+ *
+ * @warning The image replaces the FAT filesystem on /ota:, which is
+ * unmounted by begin(). Reformat the partition to use /ota: again.
+ *
+ * @code
+ * OTAWriter ota;
+ * ota.begin(contentLength);
+ * while (client.available()) {
+ *     int n = client.read(buf, sizeof(buf));
+ *     ota.write(buf, n);
+ * }
+ * ota.finish();
+ * ota.verify(expectedSha256);
+ * @endcode
+ */
+class OTAWriter {
+public:
+    /// Size of a SHA-256 digest in bytes
+    static constexpr size_t SHA256_SIZE = 32;
+
+    OTAWriter();
+    ~OTAWriter();
+
+    OTAWriter(const OTAWriter&) = delete;
+    OTAWriter& operator=(const OTAWriter&) = delete;
+
+    /**
+     * @brief Start writing a new image.
+     * @param imageSize Expected image size, or 0 if unknown. When known, the
+     *        whole image area is erased ahead and write() rejects extra data.
+     * @param bufferSize Staging ring size in bytes, a multiple of 4096
+     * @param buffer Optional caller-owned staging ring (e.g. SDRAM), 32 byte aligned
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool begin(size_t imageSize = 0, size_t bufferSize = 32 * 1024, uint8_t* buffer = nullptr,
+               StorageError* error = nullptr);
+
+    /**
+     * @brief Queue a chunk of the image.
+     * @param data Image bytes
+     * @param length Number of bytes
+     * @param error Optional pointer to receive error details
+     * @return Number of bytes accepted, 0 on error
+     */
+    size_t write(const uint8_t* data, size_t length, StorageError* error = nullptr);
+
+    /**
+     * @brief Write out the staged data and finalize the digest.
+     * @param error Optional pointer to receive error details
+     * @return true if the whole image is on flash, false otherwise
+     */
+    bool finish(StorageError* error = nullptr);
+
+    /**
+     * @brief Stop writing and discard staged data.
+     */
+    void abort();
+
+    /**
+     * @brief Compare the image digest with an expected value.
+     * @param expected Expected SHA-256 digest (SHA256_SIZE bytes)
+     * @param error Optional pointer to receive error details
+     * @return true if finish() succeeded and the digests match
+     */
+    bool verify(const uint8_t* expected, StorageError* error = nullptr) const;
+
+    /**
+     * @brief Get the SHA-256 digest of the image. Valid after finish().
+     * @param digest Receives SHA256_SIZE bytes
+     * @return true if the digest is available
+     */
+    bool getSha256(uint8_t* digest) const;
+
+    /**
+     * @brief Bytes accepted by write() so far.
+     */
+    size_t size() const { return received_; }
+
+    /**
+     * @brief Size of the ota partition in bytes, 0 if it does not exist.
+     */
+    static size_t capacity();
+
+    /**
+     * @brief Get throughput counters. Rates are final after finish().
+     */
+    OTAWriterStats getStats();
+
+private:
+    const struct flash_area* area_;
+    uint8_t* buffer_;
+    uint8_t* allocation_;   // Owned memory behind buffer_, if any
+    size_t capacity_;
+    size_t head_;           // Next byte written by write()
+    size_t count_;          // Bytes staged, ending at head_
+    size_t imageSize_;
+    size_t received_;
+    size_t programmed_;     // Bytes on flash
+    size_t erased_;         // Bytes erased from the start of the partition
+    bool finishing_;        // Flush partial pages and stop when empty
+    bool active_;
+    bool finished_;
+    int error_;             // First error seen by the storage thread
+    void* sha_;             // Hash context, kept out of this header
+    uint8_t digest_[SHA256_SIZE];
+    uint32_t startMs_;
+    uint32_t endMs_;
+    uint32_t eraseMs_;
+    uint32_t programMs_;
+    uint32_t stalls_;
+    struct k_mutex lock_;
+    struct k_condvar changed_; // Signalled when the storage thread made progress
+
+    bool step();
+    void release();
+    static void startWorker();
+    static void workerEntry(void* p1, void* p2, void* p3);
+};
+
+#endif // QSPI_OTA_WRITER_H
@@ -6,30 +6,107 @@
 
 #include "QSPIFile.h"
 #include "QSPIFolder.h"
+#include "QSPIWriteBehind.h"
+#include "QSPIStorage.h"
 
 #include <zephyr/fs/fs.h>
+#include <zephyr/sys/atomic.h>
 #include <errno.h>
 #include <cstring>
+#include <utility>
 
-QSPIFile::QSPIFile() : File(), file_(nullptr), is_open_(false), mode_(FileMode::READ) {
+// Transfer buffers are aligned to a cache line so flash drivers can DMA
+// straight into them
+static constexpr size_t TRANSFER_ALIGNMENT = 32;
+
+// File handles are taken from a small static pool, so opening files does
+// not go through the heap. Handles beyond the pool fall back to new.
+#ifndef QSPI_FILE_HANDLE_POOL_SIZE
+#define QSPI_FILE_HANDLE_POOL_SIZE 8
+#endif
+
+static struct fs_file_t handle_pool[QSPI_FILE_HANDLE_POOL_SIZE];
+static ATOMIC_DEFINE(handle_pool_used, QSPI_FILE_HANDLE_POOL_SIZE);
+
+static struct fs_file_t* allocFileHandle() {
+    for (size_t i = 0; i < QSPI_FILE_HANDLE_POOL_SIZE; i++) {
+        if (!atomic_test_and_set_bit(handle_pool_used, i)) {
+            return &handle_pool[i];
+        }
+    }
+    return new struct fs_file_t;
+}
+
+static void releaseFileHandle(struct fs_file_t* handle) {
+    if (handle >= handle_pool && handle < handle_pool + QSPI_FILE_HANDLE_POOL_SIZE) {
+        atomic_clear_bit(handle_pool_used, handle - handle_pool);
+    } else {
+        delete handle;
+    }
 }
 
-QSPIFile::QSPIFile(const char* path) : File(path), file_(nullptr), is_open_(false), mode_(FileMode::READ) {
+QSPIFile::QSPIFile() : File(), file_(nullptr), is_open_(false), mode_(FileMode::READ),
+      size_(0), position_(0), write_behind_(nullptr) {
 }
 
-QSPIFile::QSPIFile(const String& path) : File(path), file_(nullptr), is_open_(false), mode_(FileMode::READ) {
+QSPIFile::QSPIFile(const char* path) : File(path), file_(nullptr), is_open_(false), mode_(FileMode::READ),
+      size_(0), position_(0), write_behind_(nullptr) {
+}
+
+QSPIFile::QSPIFile(const String& path) : File(path), file_(nullptr), is_open_(false), mode_(FileMode::READ),
+      size_(0), position_(0), write_behind_(nullptr) {
+}
+
+QSPIFile::QSPIFile(const char* directory, const char* name) : File(directory, name), file_(nullptr),
+      is_open_(false), mode_(FileMode::READ), size_(0), position_(0), write_behind_(nullptr) {
 }
 
 QSPIFile::~QSPIFile() {
     if (is_open_) {
         close(nullptr);
     }
+    delete write_behind_;
     freeFileHandle();
 }
 
+QSPIFile::QSPIFile(QSPIFile&& other) : File(), file_(nullptr), is_open_(false), mode_(FileMode::READ),
+      size_(0), position_(0), write_behind_(nullptr) {
+    moveFrom(other);
+}
+
+QSPIFile& QSPIFile::operator=(QSPIFile&& other) {
+    if (this != &other) {
+        if (is_open_) {
+            close(nullptr);
+        }
+        delete write_behind_;
+        freeFileHandle();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+void QSPIFile::moveFrom(QSPIFile& other) {
+    // The handle stays where it is, so a write-behind queue pointing at it
+    // can move along without being rebuilt
+    path_ = std::move(other.path_);
+    file_ = other.file_;
+    is_open_ = other.is_open_;
+    mode_ = other.mode_;
+    size_ = other.size_;
+    position_ = other.position_;
+    write_behind_ = other.write_behind_;
+
+    other.file_ = nullptr;
+    other.is_open_ = false;
+    other.size_ = 0;
+    other.position_ = 0;
+    other.write_behind_ = nullptr;
+}
+
 bool QSPIFile::ensureFileHandle() {
     if (file_ == nullptr) {
-        file_ = new struct fs_file_t;
+        file_ = allocFileHandle();
         if (file_ == nullptr) {
             return false;
         }
@@ -40,11 +117,58 @@ bool QSPIFile::ensureFileHandle() {
 
 void QSPIFile::freeFileHandle() {
     if (file_ != nullptr) {
-        delete file_;
+        releaseFileHandle(file_);
         file_ = nullptr;
     }
 }
 
+bool QSPIFile::drainWriteBehind(bool sync, StorageError* error) {
+    if (write_behind_ == nullptr) {
+        return true;
+    }
+
+    int ret = write_behind_->drain(sync);
+
+    if (ret < 0) {
+        if (error) {
+            error->setError(mapZephyrError(ret), "Queued write failed");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool QSPIFile::refreshSize(StorageError* error) {
+    if (!drainWriteBehind(false, error)) {
+        return false;
+    }
+
+    // Measure through the open handle instead of fs_stat(), which would
+    // resolve the whole path from the mount point again
+    int ret = fs_seek(file_, 0, FS_SEEK_END);
+    if (ret == 0) {
+        off_t end = fs_tell(file_);
+        if (end < 0) {
+            ret = static_cast<int>(end);
+        } else {
+            ret = fs_seek(file_, position_, FS_SEEK_SET);
+            if (ret == 0) {
+                size_ = static_cast<size_t>(end);
+            }
+        }
+    }
+
+    if (ret < 0) {
+        if (error) {
+            error->setError(mapZephyrError(ret), "Failed to get file size");
+        }
+        return false;
+    }
+
+    return true;
+}
+
 int QSPIFile::fileModeToFlags(FileMode mode) {
     switch (mode) {
         case FileMode::READ:
@@ -91,8 +215,7 @@ StorageErrorCode QSPIFile::mapZephyrError(int err) {
 bool QSPIFile::open(const char* filename, FileMode mode, StorageError* error) {
     // Update path
     if (filename != nullptr) {
-        strncpy(path_, filename, sizeof(path_) - 1);
-        path_[sizeof(path_) - 1] = '\0';
+        path_.assign(filename);
     }
     return open(mode, error);
 }
@@ -106,7 +229,7 @@ bool QSPIFile::open(FileMode mode, StorageError* error) {
         close(nullptr);
     }
 
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "No file path specified");
         }
@@ -134,6 +257,13 @@ bool QSPIFile::open(FileMode mode, StorageError* error) {
 
     is_open_ = true;
     mode_ = mode;
+    position_ = 0;
+
+    if (!refreshSize(error)) {
+        close(nullptr);
+        return false;
+    }
+
     return true;
 }
 
@@ -142,9 +272,16 @@ bool QSPIFile::close(StorageError* error) {
         return true;  // Already closed
     }
 
+    // fs_close() syncs, so only the queue itself has to be emptied
+    bool drained = drainWriteBehind(false, error);
+
     int ret = fs_close(file_);
     is_open_ = false;
 
+    if (!drained) {
+        return false;
+    }
+
     if (ret < 0) {
         if (error) {
             error->setError(mapZephyrError(ret), "Failed to close file");
@@ -163,6 +300,29 @@ bool QSPIFile::changeMode(FileMode mode, StorageError* error) {
         return false;
     }
 
+    int wanted = fileModeToFlags(mode);
+    int held = file_->flags;
+    bool covered = (wanted & (FS_O_READ | FS_O_WRITE) & ~held) == 0;
+    if (covered && (wanted & FS_O_APPEND) == (held & FS_O_APPEND)) {
+        // The handle already allows everything the new mode needs, so only
+        // rewind as a reopen would
+        if (!drainWriteBehind(false, error)) {
+            return false;
+        }
+
+        int ret = fs_seek(file_, 0, FS_SEEK_SET);
+        if (ret < 0) {
+            if (error) {
+                error->setError(mapZephyrError(ret), "Seek failed");
+            }
+            return false;
+        }
+
+        mode_ = mode;
+        position_ = 0;
+        return true;
+    }
+
     // Close and reopen with new mode
     close(nullptr);
     return open(mode, error);
@@ -180,6 +340,18 @@ size_t QSPIFile::read(uint8_t* buffer, size_t size, StorageError* error) {
         return 0;
     }
 
+    // The handle may allow more than the mode after changeMode()
+    if (mode_ == FileMode::WRITE || mode_ == FileMode::APPEND) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_MODE, "File not open for reading");
+        }
+        return 0;
+    }
+
+    if (!drainWriteBehind(false, error)) {
+        return 0;
+    }
+
     ssize_t ret = fs_read(file_, buffer, size);
 
     if (ret < 0) {
@@ -189,6 +361,12 @@ size_t QSPIFile::read(uint8_t* buffer, size_t size, StorageError* error) {
         return 0;
     }
 
+    position_ += static_cast<size_t>(ret);
+    if (position_ > size_) {
+        // Another handle extended the file since it was last measured
+        size_ = position_;
+    }
+
     return static_cast<size_t>(ret);
 }
 
@@ -209,8 +387,7 @@ String QSPIFile::readAsString(StorageError* error) {
         return String();
     }
 
-    // Get file size
-    size_t fileSize = this->size(error);
+    size_t fileSize = size_;
     if (fileSize == 0) {
         return String();
     }
@@ -241,11 +418,14 @@ uint32_t QSPIFile::available(StorageError* error) {
         return 0;
     }
 
-    size_t fileSize = this->size(error);
-    size_t currentPos = this->position(error);
+    // Only go back to the filesystem once the cached end has been reached,
+    // in case the file grew through another handle
+    if (position_ >= size_ && !refreshSize(error)) {
+        return 0;
+    }
 
-    if (fileSize > currentPos) {
-        return fileSize - currentPos;
+    if (size_ > position_) {
+        return size_ - position_;
     }
     return 0;
 }
@@ -258,6 +438,10 @@ bool QSPIFile::seek(size_t offset, StorageError* error) {
         return false;
     }
 
+    if (!drainWriteBehind(false, error)) {
+        return false;
+    }
+
     int ret = fs_seek(file_, offset, FS_SEEK_SET);
 
     if (ret < 0) {
@@ -267,6 +451,7 @@ bool QSPIFile::seek(size_t offset, StorageError* error) {
         return false;
     }
 
+    position_ = offset;
     return true;
 }
 
@@ -278,19 +463,14 @@ size_t QSPIFile::position(StorageError* error) {
         return 0;
     }
 
-    off_t pos = fs_tell(file_);
-
-    if (pos < 0) {
-        if (error) {
-            error->setError(mapZephyrError(pos), "Failed to get position");
-        }
-        return 0;
-    }
-
-    return static_cast<size_t>(pos);
+    return position_;
 }
 
 size_t QSPIFile::size(StorageError* error) {
+    if (is_open_) {
+        return size_;
+    }
+
     struct fs_dirent entry;
     int ret = fs_stat(path_, &entry);
 
@@ -312,7 +492,19 @@ size_t QSPIFile::write(const uint8_t* buffer, size_t size, StorageError* error)
         return 0;
     }
 
-    ssize_t ret = fs_write(file_, buffer, size);
+    if (mode_ == FileMode::READ) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_MODE, "File not open for writing");
+        }
+        return 0;
+    }
+
+    ssize_t ret;
+    if (write_behind_ != nullptr) {
+        ret = write_behind_->write(buffer, size);
+    } else {
+        ret = fs_write(file_, buffer, size);
+    }
 
     if (ret < 0) {
         if (error) {
@@ -321,6 +513,15 @@ size_t QSPIFile::write(const uint8_t* buffer, size_t size, StorageError* error)
         return 0;
     }
 
+    if (mode_ == FileMode::APPEND) {
+        // Appending writes always land at the end regardless of position
+        position_ = size_;
+    }
+    position_ += static_cast<size_t>(ret);
+    if (position_ > size_) {
+        size_ = position_;
+    }
+
     return static_cast<size_t>(ret);
 }
 
@@ -332,6 +533,36 @@ size_t QSPIFile::write(uint8_t value, StorageError* error) {
     return write(&value, 1, error);
 }
 
+bool QSPIFile::truncate(size_t length, StorageError* error) {
+    if (!is_open_ || file_ == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "File not open");
+        }
+        return false;
+    }
+
+    if (!drainWriteBehind(false, error)) {
+        return false;
+    }
+
+    int ret = fs_truncate(file_, length);
+
+    if (ret < 0) {
+        if (error) {
+            error->setError(mapZephyrError(ret), "Truncate failed");
+        }
+        return false;
+    }
+
+    size_ = length;
+    if (position_ > length) {
+        position_ = length;
+        fs_seek(file_, position_, FS_SEEK_SET);
+    }
+
+    return true;
+}
+
 bool QSPIFile::flush(StorageError* error) {
     if (!is_open_ || file_ == nullptr) {
         if (error) {
@@ -340,6 +571,10 @@ bool QSPIFile::flush(StorageError* error) {
         return false;
     }
 
+    if (write_behind_ != nullptr) {
+        return drainWriteBehind(true, error);
+    }
+
     int ret = fs_sync(file_);
 
     if (ret < 0) {
@@ -352,8 +587,54 @@ bool QSPIFile::flush(StorageError* error) {
     return true;
 }
 
+bool QSPIFile::enableWriteBehind(size_t bufferSize, uint8_t* buffer, StorageError* error) {
+    if (write_behind_ != nullptr) {
+        return true;
+    }
+
+    if (bufferSize == 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Invalid write-behind buffer size");
+        }
+        return false;
+    }
+
+    if (!ensureFileHandle()) {
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate file handle");
+        }
+        return false;
+    }
+
+    write_behind_ = QSPIWriteBehind::create(file_, bufferSize, buffer);
+    if (write_behind_ == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate write-behind queue");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool QSPIFile::disableWriteBehind(StorageError* error) {
+    if (write_behind_ == nullptr) {
+        return true;
+    }
+
+    bool drained = drainWriteBehind(false, error);
+    delete write_behind_;
+    write_behind_ = nullptr;
+
+    return drained;
+}
+
+size_t QSPIFile::pendingWrites() const {
+    return write_behind_ != nullptr ? write_behind_->pending() : 0;
+}
+
 bool QSPIFile::exists(StorageError* error) const {
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         return false;
     }
 
@@ -368,7 +649,7 @@ bool QSPIFile::remove(StorageError* error) {
         close(nullptr);
     }
 
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "No file path specified");
         }
@@ -392,7 +673,7 @@ bool QSPIFile::rename(const char* newFilename, StorageError* error) {
         close(nullptr);
     }
 
-    if (path_[0] == '\0' || newFilename == nullptr) {
+    if (path_.empty() || newFilename == nullptr) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "Invalid path");
         }
@@ -409,8 +690,7 @@ bool QSPIFile::rename(const char* newFilename, StorageError* error) {
     }
 
     // Update internal path
-    strncpy(path_, newFilename, sizeof(path_) - 1);
-    path_[sizeof(path_) - 1] = '\0';
+    path_.assign(newFilename);
 
     return true;
 }
@@ -419,8 +699,161 @@ bool QSPIFile::rename(const String& newFilename, StorageError* error) {
     return rename(newFilename.c_str(), error);
 }
 
+bool QSPIFile::copyTo(const char* destination, bool overwrite, StorageError* error) {
+    QSPICopyOptions options;
+    options.overwrite = overwrite;
+    return copyTo(destination, options, error);
+}
+
+bool QSPIFile::copyTo(const char* destination, const QSPICopyOptions& options, StorageError* error) {
+    if (path_.empty() || destination == nullptr || destination[0] == '\0') {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Invalid path");
+        }
+        return false;
+    }
+
+    if (strcmp(path_, destination) == 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Source and destination are the same");
+        }
+        return false;
+    }
+
+    if (options.bufferSize == 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Invalid transfer buffer size");
+        }
+        return false;
+    }
+
+    // Data written through this object must be visible to the reading handle
+    if (is_open_ && !flush(error)) {
+        return false;
+    }
+
+    QSPIFile target(destination);
+    if (target.exists(nullptr)) {
+        if (!options.overwrite) {
+            if (error) {
+                error->setError(StorageErrorCode::ALREADY_EXISTS, "Destination already exists");
+            }
+            return false;
+        }
+        // Start from an empty file rather than rewriting the old one in place
+        if (!target.remove(error)) {
+            return false;
+        }
+    }
+
+    QSPIFile source(path_);
+    if (!source.open(FileMode::READ, error)) {
+        return false;
+    }
+
+    uint8_t* allocated = nullptr;
+    uint8_t* buffer = options.buffer;
+    if (buffer == nullptr) {
+        allocated = new uint8_t[options.bufferSize + TRANSFER_ALIGNMENT - 1];
+        if (allocated == nullptr) {
+            if (error) {
+                error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate transfer buffer");
+            }
+            return false;
+        }
+        uintptr_t address = reinterpret_cast<uintptr_t>(allocated);
+        buffer = reinterpret_cast<uint8_t*>((address + TRANSFER_ALIGNMENT - 1) &
+                                            ~(TRANSFER_ALIGNMENT - 1));
+    }
+
+    bool ok = target.open(FileMode::WRITE, error);
+    size_t total = source.size();
+    size_t copied = 0;
+
+    // Every transfer starts on a multiple of bufferSize, so with a
+    // block-sized buffer both filesystems bypass their caches
+    while (ok && copied < total) {
+        size_t bytesRead = source.read(buffer, options.bufferSize, error);
+        if (bytesRead == 0) {
+            break;
+        }
+
+        if (target.write(buffer, bytesRead, error) != bytesRead) {
+            if (error && !error->hasError()) {
+                error->setError(StorageErrorCode::WRITE_ERROR, "Short write during copy");
+            }
+            ok = false;
+            break;
+        }
+
+        copied += bytesRead;
+        if (options.progress) {
+            options.progress(copied, total);
+        }
+    }
+
+    source.close(nullptr);
+    if (ok && copied < total) {
+        if (error && !error->hasError()) {
+            error->setError(StorageErrorCode::READ_ERROR, "Short read during copy");
+        }
+        ok = false;
+    }
+    // Closing commits the destination; a failure here loses the copy
+    if (!target.close(ok ? error : nullptr)) {
+        ok = false;
+    }
+
+    delete[] allocated;
+
+    if (!ok) {
+        target.remove(nullptr);
+    }
+
+    return ok;
+}
+
+bool QSPIFile::moveTo(const char* destination, bool overwrite, StorageError* error) {
+    QSPICopyOptions options;
+    options.overwrite = overwrite;
+    return moveTo(destination, options, error);
+}
+
+bool QSPIFile::moveTo(const char* destination, const QSPICopyOptions& options, StorageError* error) {
+    if (path_.empty() || destination == nullptr || destination[0] == '\0') {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Invalid path");
+        }
+        return false;
+    }
+
+    if (!options.overwrite && QSPIFile(destination).exists(nullptr)) {
+        if (error) {
+            error->setError(StorageErrorCode::ALREADY_EXISTS, "Destination already exists");
+        }
+        return false;
+    }
+
+    // Within one filesystem only the directory entry has to change
+    if (QSPIStorage::isSameMount(path_, destination)) {
+        return rename(destination, error);
+    }
+
+    if (!copyTo(destination, options, error)) {
+        return false;
+    }
+
+    if (!remove(error)) {
+        return false;
+    }
+
+    path_.assign(destination);
+
+    return true;
+}
+
 QSPIFolder QSPIFile::getParentFolder(StorageError* error) const {
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "No file path");
         }
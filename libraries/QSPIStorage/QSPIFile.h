@@ -14,6 +14,18 @@
 // to prevent static initialization issues
 struct fs_file_t;
 class QSPIFolder;
+class QSPIWriteBehind;
+
+/**
+ * @struct QSPICopyOptions
+ * @brief Options for QSPIFile::copyTo() and QSPIFolder::copyTo().
+ */
+struct QSPICopyOptions {
+    bool overwrite = false;       ///< Replace files that already exist at the destination
+    size_t bufferSize = 16 * 1024; ///< Bytes per transfer, ideally a multiple of 4096
+    uint8_t* buffer = nullptr;    ///< Optional caller-owned bufferSize bytes buffer (e.g. SDRAM)
+    void (*progress)(size_t copied, size_t total) = nullptr; ///< Called after every transfer
+};
 
 /**
  * @class QSPIFile
@@ -57,11 +69,33 @@ public:
      */
     QSPIFile(const String& path);
 
+    /**
+     * @brief Construct a file object for a file inside a directory.
+     * @param directory Path of the containing directory
+     * @param name Name of the file inside directory
+     */
+    QSPIFile(const char* directory, const char* name);
+
     /**
      * @brief Destructor. Closes the file if open.
      */
     ~QSPIFile() override;
 
+    /**
+     * @brief Take over another file object, including its open handle and
+     * write-behind queue. The source is left closed and without a path.
+     */
+    QSPIFile(QSPIFile&& other);
+
+    /**
+     * @brief Close this file and take over another one.
+     */
+    QSPIFile& operator=(QSPIFile&& other);
+
+    // An open handle can only have one owner
+    QSPIFile(const QSPIFile&) = delete;
+    QSPIFile& operator=(const QSPIFile&) = delete;
+
     // ==================== Opening and Closing ====================
 
     /**
@@ -99,6 +133,11 @@ public:
 
     /**
      * @brief Change the file mode without closing.
+     *
+     * Like a reopen, the position goes back to the start of the file. When
+     * the open handle already grants the access the new mode needs (e.g.
+     * READ_WRITE to READ), it is kept and no close/reopen happens.
+     *
      * @param mode New file mode
      * @param error Optional pointer to receive error details
      * @return true if successful, false otherwise
@@ -138,6 +177,11 @@ public:
 
     /**
      * @brief Get the number of bytes available to read.
+     *
+     * Computed from the cached size and position while the file is open.
+     * The size is only re-read from the filesystem once the cached end of
+     * file has been reached, to pick up data appended by another handle.
+     *
      * @param error Optional pointer to receive error details
      * @return Number of bytes from current position to end of file
      */
@@ -160,6 +204,10 @@ public:
 
     /**
      * @brief Get the file size in bytes.
+     *
+     * Returns the cached size while the file is open, otherwise queries
+     * the filesystem by path.
+     *
      * @param error Optional pointer to receive error details
      * @return File size in bytes
      */
@@ -192,13 +240,69 @@ public:
      */
     size_t write(uint8_t value, StorageError* error = nullptr) override;
 
+    /**
+     * @brief Truncate or extend the file to the given length.
+     *
+     * The current position is clamped to the new length.
+     *
+     * @param length New file size in bytes
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool truncate(size_t length, StorageError* error = nullptr);
+
     /**
      * @brief Flush any buffered data to storage.
+     *
+     * In write-behind mode this waits until every queued byte has been
+     * written and synced, and reports errors from earlier queued writes.
+     *
      * @param error Optional pointer to receive error details
      * @return true if successful, false otherwise
      */
     bool flush(StorageError* error = nullptr) override;
 
+    // ==================== Write-Behind ====================
+
+    /**
+     * @brief Hand writes to a background storage thread.
+     *
+     * write() then only copies into a ring buffer of bufferSize bytes and
+     * returns; a low-priority thread performs the flash writes, so erase
+     * and program time never blocks the caller. When the buffer is full,
+     * write() waits for free space. flush() waits until the data is durable.
+     *
+     * Reading, seeking, truncating and closing first wait for the queue to
+     * drain. A failed background write is reported by the next write(),
+     * flush() or close().
+     *
+     * @param bufferSize Queue size in bytes, ideally a multiple of 4096
+     * @param buffer Optional caller-owned buffer of bufferSize bytes (e.g. SDRAM)
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool enableWriteBehind(size_t bufferSize = 8192, uint8_t* buffer = nullptr,
+                           StorageError* error = nullptr);
+
+    /**
+     * @brief Write out queued data and go back to synchronous writes.
+     * @param error Optional pointer to receive error details
+     * @return true if all queued data was written
+     */
+    bool disableWriteBehind(StorageError* error = nullptr);
+
+    /**
+     * @brief Check if write-behind mode is enabled.
+     * @return true if writes are queued to the storage thread
+     */
+    bool isWriteBehind() const { return write_behind_ != nullptr; }
+
+    /**
+     * @brief Get the number of queued bytes not yet written to flash.
+     * @return Pending bytes, 0 in synchronous mode
+     */
+    size_t pendingWrites() const;
+
     // ==================== File Management ====================
 
     /**
@@ -231,6 +335,52 @@ public:
      */
     bool rename(const String& newFilename, StorageError* error = nullptr) override;
 
+    /**
+     * @brief Copy the file to another path, possibly on another mount.
+     *
+     * Data is moved in large block-aligned transfers, which LittleFS and
+     * FAT pass straight to the flash instead of through their caches.
+     * A partially written destination is removed on failure.
+     *
+     * @param destination Path of the copy
+     * @param overwrite Replace the destination if it already exists
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool copyTo(const char* destination, bool overwrite = false, StorageError* error = nullptr);
+
+    /**
+     * @brief Copy the file to another path with custom transfer options.
+     * @param destination Path of the copy
+     * @param options Buffer, overwrite and progress options
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool copyTo(const char* destination, const QSPICopyOptions& options, StorageError* error = nullptr);
+
+    /**
+     * @brief Move the file to another path, possibly on another mount.
+     *
+     * Within one filesystem this is a rename and no data is copied. Across
+     * mounts the file is copied and the source removed afterwards. On
+     * success this object refers to the destination.
+     *
+     * @param destination New path for the file
+     * @param overwrite Replace the destination if it already exists
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool moveTo(const char* destination, bool overwrite = false, StorageError* error = nullptr);
+
+    /**
+     * @brief Move the file to another path with custom transfer options.
+     * @param destination New path for the file
+     * @param options Buffer, overwrite and progress options used when copying
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool moveTo(const char* destination, const QSPICopyOptions& options, StorageError* error = nullptr);
+
     // ==================== Path Information ====================
 
     /**
@@ -244,11 +394,17 @@ private:
     struct fs_file_t* file_;
     bool is_open_;
     FileMode mode_;
+    size_t size_;      // Cached file size, valid while open
+    size_t position_;  // Cached read/write offset, valid while open
+    QSPIWriteBehind* write_behind_;
 
     bool resolvePath(const char* path, char* resolved, StorageError* error);
     int fileModeToFlags(FileMode mode);
+    void moveFrom(QSPIFile& other);
     bool ensureFileHandle();
     void freeFileHandle();
+    bool refreshSize(StorageError* error);
+    bool drainWriteBehind(bool sync, StorageError* error);
     static StorageErrorCode mapZephyrError(int err);
 };
 
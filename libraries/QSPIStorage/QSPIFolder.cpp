@@ -5,11 +5,15 @@
  */
 
 #include "QSPIFolder.h"
+#include "QSPIStorage.h"
 
 #include <zephyr/fs/fs.h>
 #include <errno.h>
 #include <cstring>
 
+// Matches the transfer buffer alignment used by QSPIFile::copyTo()
+static constexpr size_t TRANSFER_ALIGNMENT = 32;
+
 QSPIFolder::QSPIFolder() : Folder() {
 }
 
@@ -19,6 +23,9 @@ QSPIFolder::QSPIFolder(const char* path) : Folder(path) {
 QSPIFolder::QSPIFolder(const String& path) : Folder(path) {
 }
 
+QSPIFolder::QSPIFolder(const char* directory, const char* name) : Folder(directory, name) {
+}
+
 QSPIFolder::~QSPIFolder() {
 }
 
@@ -51,7 +58,7 @@ StorageErrorCode QSPIFolder::mapZephyrError(int err) {
 }
 
 bool QSPIFolder::exists(StorageError* error) const {
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         return false;
     }
 
@@ -62,7 +69,7 @@ bool QSPIFolder::exists(StorageError* error) const {
 }
 
 bool QSPIFolder::create(StorageError* error) {
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "No folder path specified");
         }
@@ -82,7 +89,7 @@ bool QSPIFolder::create(StorageError* error) {
 }
 
 bool QSPIFolder::remove(bool recursive, StorageError* error) {
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "No folder path specified");
         }
@@ -163,7 +170,7 @@ bool QSPIFolder::removeRecursive(const char* path, StorageError* error) {
 }
 
 bool QSPIFolder::rename(const char* newName, StorageError* error) {
-    if (path_[0] == '\0' || newName == nullptr) {
+    if (path_.empty() || newName == nullptr) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "Invalid path");
         }
@@ -180,8 +187,7 @@ bool QSPIFolder::rename(const char* newName, StorageError* error) {
     }
 
     // Update internal path
-    strncpy(path_, newName, sizeof(path_) - 1);
-    path_[sizeof(path_) - 1] = '\0';
+    path_.assign(newName);
 
     return true;
 }
@@ -190,11 +196,150 @@ bool QSPIFolder::rename(const String& newName, StorageError* error) {
     return rename(newName.c_str(), error);
 }
 
-QSPIFile QSPIFolder::createFile(const char* filename, FileMode mode, StorageError* error) {
-    char fullPath[STORAGE_MAX_PATH_LENGTH];
-    snprintf(fullPath, sizeof(fullPath), "%s/%s", path_, filename);
+bool QSPIFolder::copyTo(const char* destination, bool overwrite, StorageError* error) {
+    QSPICopyOptions options;
+    options.overwrite = overwrite;
+    return copyTo(destination, options, error);
+}
+
+bool QSPIFolder::copyTo(const char* destination, const QSPICopyOptions& options, StorageError* error) {
+    if (path_.empty() || destination == nullptr || destination[0] == '\0') {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Invalid path");
+        }
+        return false;
+    }
+
+    // Copying a folder into itself would never terminate
+    size_t length = strlen(path_);
+    if (strncmp(destination, path_, length) == 0 &&
+        (destination[length] == '\0' || destination[length] == '/')) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Destination is inside the source folder");
+        }
+        return false;
+    }
+
+    if (options.bufferSize == 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Invalid transfer buffer size");
+        }
+        return false;
+    }
+
+    // Allocate the transfer buffer once for the whole tree
+    QSPICopyOptions shared = options;
+    uint8_t* allocated = nullptr;
+    if (shared.buffer == nullptr) {
+        allocated = new uint8_t[shared.bufferSize + TRANSFER_ALIGNMENT - 1];
+        if (allocated == nullptr) {
+            if (error) {
+                error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate transfer buffer");
+            }
+            return false;
+        }
+        uintptr_t address = reinterpret_cast<uintptr_t>(allocated);
+        shared.buffer = reinterpret_cast<uint8_t*>((address + TRANSFER_ALIGNMENT - 1) &
+                                                   ~(TRANSFER_ALIGNMENT - 1));
+    }
+
+    bool ok = copyRecursive(path_, destination, shared, error);
+
+    delete[] allocated;
+    return ok;
+}
+
+// Build parent/name, failing instead of truncating a path that is too long
+static bool childPath(StoragePath& path, const char* parent, const char* name, StorageError* error) {
+    if (strlen(parent) + 1 + strlen(name) > STORAGE_MAX_PATH_LENGTH - 1) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Path too long");
+        }
+        return false;
+    }
+
+    if (!path.assign(parent, name)) {
+        if (error) {
+            error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate path");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool QSPIFolder::copyRecursive(const char* source, const char* destination,
+                               const QSPICopyOptions& options, StorageError* error) {
+    QSPIFolder target(destination);
+    if (!target.exists(nullptr) && !target.create(error)) {
+        return false;
+    }
 
-    QSPIFile file(fullPath);
+    // Compact paths keep the stack use per nesting level small
+    StoragePath sourcePath;
+    StoragePath targetPath;
+
+    // Every nesting level holds a directory handle open while it recurses.
+    // A level that could not open or finish its listing must fail the copy:
+    // moveTo() removes the source once the copy reports success.
+    QSPIFolderEntries listing = QSPIFolder(source).entries(QSPIEntryType::ANY, nullptr, error);
+    for (auto& entry : listing) {
+        if (!childPath(sourcePath, source, entry.name(), error) ||
+            !childPath(targetPath, destination, entry.name(), error)) {
+            return false;
+        }
+
+        bool ok;
+        if (entry.isFolder()) {
+            ok = copyRecursive(sourcePath, targetPath, options, error);
+        } else {
+            ok = QSPIFile(sourcePath).copyTo(targetPath, options, error);
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return !listing.failed();
+}
+
+bool QSPIFolder::moveTo(const char* destination, bool overwrite, StorageError* error) {
+    QSPICopyOptions options;
+    options.overwrite = overwrite;
+    return moveTo(destination, options, error);
+}
+
+bool QSPIFolder::moveTo(const char* destination, const QSPICopyOptions& options, StorageError* error) {
+    if (path_.empty() || destination == nullptr || destination[0] == '\0') {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "Invalid path");
+        }
+        return false;
+    }
+
+    // Within one filesystem the whole tree moves with one directory entry,
+    // as long as nothing has to be merged into an existing folder
+    if (QSPIStorage::isSameMount(path_, destination) && !QSPIFolder(destination).exists(nullptr)) {
+        return rename(destination, error);
+    }
+
+    // The source is only removed once every file of it was copied
+    if (!copyTo(destination, options, error)) {
+        return false;
+    }
+
+    if (!remove(true, error)) {
+        return false;
+    }
+
+    path_.assign(destination);
+
+    return true;
+}
+
+QSPIFile QSPIFolder::createFile(const char* filename, FileMode mode, StorageError* error) {
+    QSPIFile file(path_, filename);
     if (!file.open(mode, error)) {
         return QSPIFile();
     }
@@ -207,10 +352,7 @@ QSPIFile QSPIFolder::createFile(const String& filename, FileMode mode, StorageEr
 }
 
 QSPIFile QSPIFolder::getFile(const char* filename, StorageError* error) {
-    char fullPath[STORAGE_MAX_PATH_LENGTH];
-    snprintf(fullPath, sizeof(fullPath), "%s/%s", path_, filename);
-
-    QSPIFile file(fullPath);
+    QSPIFile file(path_, filename);
 
     if (!file.exists(error)) {
         if (error) {
@@ -227,10 +369,7 @@ QSPIFile QSPIFolder::getFile(const String& filename, StorageError* error) {
 }
 
 QSPIFolder QSPIFolder::createSubfolder(const char* name, bool overwrite, StorageError* error) {
-    char fullPath[STORAGE_MAX_PATH_LENGTH];
-    snprintf(fullPath, sizeof(fullPath), "%s/%s", path_, name);
-
-    QSPIFolder folder(fullPath);
+    QSPIFolder folder(path_, name);
 
     if (folder.exists(nullptr)) {
         if (overwrite) {
@@ -257,10 +396,7 @@ QSPIFolder QSPIFolder::createSubfolder(const String& name, bool overwrite, Stora
 }
 
 QSPIFolder QSPIFolder::getSubfolder(const char* name, StorageError* error) {
-    char fullPath[STORAGE_MAX_PATH_LENGTH];
-    snprintf(fullPath, sizeof(fullPath), "%s/%s", path_, name);
-
-    QSPIFolder folder(fullPath);
+    QSPIFolder folder(path_, name);
 
     if (!folder.exists(error)) {
         if (error) {
@@ -276,158 +412,49 @@ QSPIFolder QSPIFolder::getSubfolder(const String& name, StorageError* error) {
     return getSubfolder(name.c_str(), error);
 }
 
+QSPIFolderEntries QSPIFolder::entries(QSPIEntryType type, const char* pattern,
+                                      StorageError* error) const {
+    return QSPIFolderEntries(path_, type, pattern, error);
+}
+
 std::vector<QSPIFile> QSPIFolder::getFiles(StorageError* error) {
     std::vector<QSPIFile> files;
 
-    if (path_[0] == '\0') {
-        if (error) {
-            error->setError(StorageErrorCode::INVALID_PATH, "No folder path");
-        }
-        return files;
-    }
-
-    struct fs_dir_t dir;
-    fs_dir_t_init(&dir);
-
-    int ret = fs_opendir(&dir, path_);
-    if (ret < 0) {
-        if (error) {
-            error->setError(mapZephyrError(ret), "Failed to open directory");
-        }
-        return files;
+    for (auto& entry : entries(QSPIEntryType::FILES, nullptr, error)) {
+        files.emplace_back(path_, entry.name());
     }
 
-    struct fs_dirent entry;
-    char fullPath[STORAGE_MAX_PATH_LENGTH];
-
-    while (true) {
-        ret = fs_readdir(&dir, &entry);
-        if (ret < 0 || entry.name[0] == '\0') {
-            break;
-        }
-
-        if (entry.type == FS_DIR_ENTRY_FILE) {
-            snprintf(fullPath, sizeof(fullPath), "%s/%s", path_, entry.name);
-            files.push_back(QSPIFile(fullPath));
-        }
-    }
-
-    fs_closedir(&dir);
     return files;
 }
 
 std::vector<QSPIFolder> QSPIFolder::getFolders(StorageError* error) {
     std::vector<QSPIFolder> folders;
 
-    if (path_[0] == '\0') {
-        if (error) {
-            error->setError(StorageErrorCode::INVALID_PATH, "No folder path");
-        }
-        return folders;
+    for (auto& entry : entries(QSPIEntryType::FOLDERS, nullptr, error)) {
+        folders.emplace_back(path_, entry.name());
     }
 
-    struct fs_dir_t dir;
-    fs_dir_t_init(&dir);
-
-    int ret = fs_opendir(&dir, path_);
-    if (ret < 0) {
-        if (error) {
-            error->setError(mapZephyrError(ret), "Failed to open directory");
-        }
-        return folders;
-    }
-
-    struct fs_dirent entry;
-    char fullPath[STORAGE_MAX_PATH_LENGTH];
-
-    while (true) {
-        ret = fs_readdir(&dir, &entry);
-        if (ret < 0 || entry.name[0] == '\0') {
-            break;
-        }
-
-        if (entry.type == FS_DIR_ENTRY_DIR) {
-            snprintf(fullPath, sizeof(fullPath), "%s/%s", path_, entry.name);
-            folders.push_back(QSPIFolder(fullPath));
-        }
-    }
-
-    fs_closedir(&dir);
     return folders;
 }
 
 size_t QSPIFolder::getFileCount(StorageError* error) {
-    size_t count = 0;
-
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         return 0;
     }
 
-    struct fs_dir_t dir;
-    fs_dir_t_init(&dir);
-
-    int ret = fs_opendir(&dir, path_);
-    if (ret < 0) {
-        if (error) {
-            error->setError(mapZephyrError(ret), "Failed to open directory");
-        }
-        return 0;
-    }
-
-    struct fs_dirent entry;
-
-    while (true) {
-        ret = fs_readdir(&dir, &entry);
-        if (ret < 0 || entry.name[0] == '\0') {
-            break;
-        }
-
-        if (entry.type == FS_DIR_ENTRY_FILE) {
-            count++;
-        }
-    }
-
-    fs_closedir(&dir);
-    return count;
+    return entries(QSPIEntryType::FILES, nullptr, error).count();
 }
 
 size_t QSPIFolder::getFolderCount(StorageError* error) {
-    size_t count = 0;
-
-    if (path_[0] == '\0') {
-        return 0;
-    }
-
-    struct fs_dir_t dir;
-    fs_dir_t_init(&dir);
-
-    int ret = fs_opendir(&dir, path_);
-    if (ret < 0) {
-        if (error) {
-            error->setError(mapZephyrError(ret), "Failed to open directory");
-        }
+    if (path_.empty()) {
         return 0;
     }
 
-    struct fs_dirent entry;
-
-    while (true) {
-        ret = fs_readdir(&dir, &entry);
-        if (ret < 0 || entry.name[0] == '\0') {
-            break;
-        }
-
-        if (entry.type == FS_DIR_ENTRY_DIR) {
-            count++;
-        }
-    }
-
-    fs_closedir(&dir);
-    return count;
+    return entries(QSPIEntryType::FOLDERS, nullptr, error).count();
 }
 
 QSPIFolder QSPIFolder::getParentFolder(StorageError* error) const {
-    if (path_[0] == '\0') {
+    if (path_.empty()) {
         if (error) {
             error->setError(StorageErrorCode::INVALID_PATH, "No folder path");
         }
@@ -15,6 +15,7 @@
 // to avoid static initialization issues
 
 #include "QSPIFile.h"
+#include "QSPIFolderEntries.h"
 
 /**
  * @class QSPIFolder
@@ -59,6 +60,13 @@ public:
      */
     QSPIFolder(const String& path);
 
+    /**
+     * @brief Construct a folder object for a child of a directory.
+     * @param directory Path of the parent directory
+     * @param name Name of the folder inside directory
+     */
+    QSPIFolder(const char* directory, const char* name);
+
     /**
      * @brief Destructor.
      */
@@ -140,6 +148,52 @@ public:
      */
     bool rename(const String& newName, StorageError* error = nullptr) override;
 
+    /**
+     * @brief Copy the folder and everything below it to another path.
+     *
+     * The destination folder is created if needed; existing contents are
+     * kept and only replaced file by file when overwrite is set. One
+     * transfer buffer is shared by all files.
+     *
+     * @param destination Path of the copy, possibly on another mount
+     * @param overwrite Replace files that already exist at the destination
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool copyTo(const char* destination, bool overwrite = false, StorageError* error = nullptr);
+
+    /**
+     * @brief Copy the folder recursively with custom transfer options.
+     * @param destination Path of the copy, possibly on another mount
+     * @param options Buffer, overwrite and progress options (progress is per file)
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool copyTo(const char* destination, const QSPICopyOptions& options, StorageError* error = nullptr);
+
+    /**
+     * @brief Move the folder to another path.
+     *
+     * Within one filesystem this is a single rename. Across mounts the tree
+     * is copied and the source removed afterwards. On success this object
+     * refers to the destination.
+     *
+     * @param destination New path for the folder
+     * @param overwrite Replace files that already exist at the destination
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool moveTo(const char* destination, bool overwrite = false, StorageError* error = nullptr);
+
+    /**
+     * @brief Move the folder with custom transfer options.
+     * @param destination New path for the folder
+     * @param options Buffer, overwrite and progress options used when copying
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool moveTo(const char* destination, const QSPICopyOptions& options, StorageError* error = nullptr);
+
     // ==================== Subfolder Operations ====================
 
     /**
@@ -178,6 +232,26 @@ public:
 
     // ==================== Content Enumeration ====================
 
+    /**
+     * @brief Iterate over the contents of this folder without allocating.
+     *
+     * Entries are read from the filesystem lazily as the loop advances.
+     * Prefer this over getFiles()/getFolders() for large folders.
+     *
+     * @param type Restrict the listing to files or folders (default: both)
+     * @param pattern Optional glob pattern ('*' and '?') matched against entry names
+     * @param error Optional pointer to receive error details
+     * @return Single-pass range of QSPIFolderEntry
+     *
+     * @code
+     * for (auto& entry : folder.entries(QSPIEntryType::FILES, "log_*.csv")) {
+     *     Serial.println(entry.name());
+     * }
+     * @endcode
+     */
+    QSPIFolderEntries entries(QSPIEntryType type = QSPIEntryType::ANY, const char* pattern = nullptr,
+                              StorageError* error = nullptr) const;
+
     /**
      * @brief Get a list of all files in this folder.
      * @param error Optional pointer to receive error details
@@ -218,6 +292,8 @@ public:
 private:
     bool resolvePath(const char* path, char* resolved, StorageError* error);
     bool removeRecursive(const char* path, StorageError* error);
+    bool copyRecursive(const char* source, const char* destination, const QSPICopyOptions& options,
+                       StorageError* error);
     static StorageErrorCode mapZephyrError(int err);
 };
 
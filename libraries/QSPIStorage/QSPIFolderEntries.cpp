@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "QSPIFolderEntries.h"
+
+#include <zephyr/fs/fs.h>
+#include <errno.h>
+#include <cstring>
+
+static_assert(sizeof(struct fs_dir_t) <= 4 * sizeof(void*),
+              "QSPIFolderEntries::dir_ is too small for struct fs_dir_t");
+
+static inline struct fs_dir_t* dirHandle(uint8_t* storage) {
+    return reinterpret_cast<struct fs_dir_t*>(storage);
+}
+
+QSPIFolderEntries::QSPIFolderEntries(const char* path, QSPIEntryType type, const char* pattern,
+                                     StorageError* error)
+    : open_(false), failed_(false), type_(type), pattern_(pattern), error_(error) {
+    if (path == nullptr || path[0] == '\0') {
+        failed_ = true;
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_PATH, "No folder path");
+        }
+        return;
+    }
+
+    struct fs_dir_t* dir = dirHandle(dir_);
+    fs_dir_t_init(dir);
+
+    // Open right away: the caller's path may be a temporary
+    int ret = fs_opendir(dir, path);
+    if (ret < 0) {
+        failed_ = true;
+        if (error) {
+            error->setError(ret == -ENOENT ? StorageErrorCode::FOLDER_NOT_FOUND
+                                           : StorageErrorCode::READ_ERROR,
+                            "Failed to open directory");
+        }
+        return;
+    }
+
+    open_ = true;
+}
+
+QSPIFolderEntries::QSPIFolderEntries(QSPIFolderEntries&& other)
+    : open_(other.open_), failed_(other.failed_), type_(other.type_), pattern_(other.pattern_), error_(other.error_),
+      entry_(other.entry_) {
+    memcpy(dir_, other.dir_, sizeof(dir_));
+    other.open_ = false;
+}
+
+QSPIFolderEntries::~QSPIFolderEntries() {
+    close();
+}
+
+void QSPIFolderEntries::close() {
+    if (open_) {
+        fs_closedir(dirHandle(dir_));
+        open_ = false;
+    }
+}
+
+QSPIFolderEntries::Iterator QSPIFolderEntries::begin() {
+    if (next()) {
+        return Iterator(this);
+    }
+    return end();
+}
+
+size_t QSPIFolderEntries::count() {
+    size_t count = 0;
+
+    while (next()) {
+        count++;
+    }
+
+    return count;
+}
+
+bool QSPIFolderEntries::next() {
+    if (!open_) {
+        return false;
+    }
+
+    struct fs_dirent entry;
+
+    while (true) {
+        int ret = fs_readdir(dirHandle(dir_), &entry);
+        if (ret < 0) {
+            failed_ = true;
+            if (error_) {
+                error_->setError(StorageErrorCode::READ_ERROR, "Failed to read directory");
+            }
+            break;
+        }
+        if (entry.name[0] == '\0') {
+            break;
+        }
+
+        bool isFolder = (entry.type == FS_DIR_ENTRY_DIR);
+        if (!matches(entry.name, isFolder)) {
+            continue;
+        }
+
+        strncpy(entry_.name_, entry.name, sizeof(entry_.name_) - 1);
+        entry_.name_[sizeof(entry_.name_) - 1] = '\0';
+        entry_.isFolder_ = isFolder;
+        entry_.size_ = isFolder ? 0 : entry.size;
+        return true;
+    }
+
+    // End of listing (or error) - release the handle as early as possible
+    close();
+    return false;
+}
+
+bool QSPIFolderEntries::matches(const char* name, bool isFolder) const {
+    if (type_ == QSPIEntryType::FILES && isFolder) {
+        return false;
+    }
+    if (type_ == QSPIEntryType::FOLDERS && !isFolder) {
+        return false;
+    }
+    return pattern_ == nullptr || globMatch(pattern_, name);
+}
+
+bool QSPIFolderEntries::globMatch(const char* pattern, const char* name) {
+    // Iterative '*' / '?' matcher, backtracking only to the last '*'
+    const char* starPattern = nullptr;
+    const char* starName = nullptr;
+
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            starPattern = ++pattern;
+            starName = name;
+        } else if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (starPattern != nullptr) {
+            pattern = starPattern;
+            name = ++starName;
+        } else {
+            return false;
+        }
+    }
+
+    while (*pattern == '*') {
+        pattern++;
+    }
+
+    return *pattern == '\0';
+}
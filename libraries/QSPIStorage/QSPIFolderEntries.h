@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_FOLDER_ENTRIES_H
+#define QSPI_FOLDER_ENTRIES_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+
+// Note: zephyr/fs/fs.h is only included in the .cpp file
+// to avoid static initialization issues. The directory handle is
+// kept in an opaque buffer whose size is checked there.
+
+/**
+ * @enum QSPIEntryType
+ * @brief Entry type filter for QSPIFolder::entries().
+ */
+enum class QSPIEntryType {
+    ANY,      // Files and folders
+    FILES,    // Regular files only
+    FOLDERS   // Subfolders only
+};
+
+/**
+ * @class QSPIFolderEntry
+ * @brief Lightweight view of a single directory entry.
+ *
+ * Holds the name, type and size reported by the filesystem while listing a
+ * folder. It does not open the file or allocate any memory; build a QSPIFile
+ * or QSPIFolder from the parent path when the entry needs to be accessed.
+ */
+class QSPIFolderEntry {
+public:
+    QSPIFolderEntry() : isFolder_(false), size_(0) {
+        name_[0] = '\0';
+    }
+
+    /**
+     * @brief Get the entry name (without the parent path).
+     * @return Null-terminated entry name
+     */
+    const char* name() const { return name_; }
+
+    /**
+     * @brief Check if the entry is a regular file.
+     * @return true if the entry is a file
+     */
+    bool isFile() const { return !isFolder_; }
+
+    /**
+     * @brief Check if the entry is a folder.
+     * @return true if the entry is a folder
+     */
+    bool isFolder() const { return isFolder_; }
+
+    /**
+     * @brief Get the file size in bytes.
+     * @return File size, or 0 for folders
+     */
+    size_t size() const { return size_; }
+
+private:
+    char name_[STORAGE_MAX_PATH_LENGTH];
+    bool isFolder_;
+    size_t size_;
+
+    friend class QSPIFolderEntries;
+};
+
+/**
+ * @class QSPIFolderEntries
+ * @brief Single-pass range over the contents of a folder.
+ *
+ * Returned by QSPIFolder::entries(). The directory is opened when the range
+ * is created and read one entry at a time as the loop advances, so listing
+ * a folder costs a single directory handle and one entry buffer no matter
+ * how many entries it contains. The directory is closed when the range goes
+ * out of scope.
+ *
+ * @note The range can only be iterated once. The glob pattern, if any, must
+ * remain valid for the lifetime of the range.
+ *
+ * @code
+ * for (auto& entry : folder.entries(QSPIEntryType::FILES, "*.log")) {
+ *     Serial.print(entry.name());
+ *     Serial.print(" ");
+ *     Serial.println(entry.size());
+ * }
+ * @endcode
+ */
+class QSPIFolderEntries {
+public:
+    class Iterator {
+    public:
+        const QSPIFolderEntry& operator*() const { return range_->entry_; }
+        const QSPIFolderEntry* operator->() const { return &range_->entry_; }
+
+        Iterator& operator++() {
+            if (!range_->next()) {
+                range_ = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return range_ == other.range_; }
+        bool operator!=(const Iterator& other) const { return range_ != other.range_; }
+
+    private:
+        explicit Iterator(QSPIFolderEntries* range) : range_(range) {}
+
+        QSPIFolderEntries* range_;
+
+        friend class QSPIFolderEntries;
+    };
+
+    QSPIFolderEntries(const char* path, QSPIEntryType type, const char* pattern,
+                      StorageError* error);
+    QSPIFolderEntries(QSPIFolderEntries&& other);
+    ~QSPIFolderEntries();
+
+    QSPIFolderEntries(const QSPIFolderEntries&) = delete;
+    QSPIFolderEntries& operator=(const QSPIFolderEntries&) = delete;
+    QSPIFolderEntries& operator=(QSPIFolderEntries&&) = delete;
+
+    /**
+     * @brief Read the first matching entry and return an iterator to it.
+     * @return Iterator to the first entry, or end() if there is none
+     */
+    Iterator begin();
+
+    /**
+     * @brief Get the end sentinel.
+     * @return Iterator marking the end of the listing
+     */
+    Iterator end() { return Iterator(nullptr); }
+
+    /**
+     * @brief Count the remaining matching entries.
+     *
+     * Consumes the range.
+     *
+     * @return Number of matching entries
+     */
+    size_t count();
+
+    /**
+     * @brief Check whether the listing stopped on an error.
+     *
+     * Set when the folder could not be opened or read, whether or not a
+     * StorageError was passed in. A range that ended early this way looks
+     * like a shorter listing to the loop, so check this after it to tell
+     * the two apart.
+     *
+     * @return true if entries may have been missed
+     */
+    bool failed() const { return failed_; }
+
+private:
+    alignas(void*) uint8_t dir_[4 * sizeof(void*)];
+    bool open_;
+    bool failed_;
+    QSPIEntryType type_;
+    const char* pattern_;
+    StorageError* error_;
+    QSPIFolderEntry entry_;
+
+    bool next();
+    void close();
+    bool matches(const char* name, bool isFolder) const;
+    static bool globMatch(const char* pattern, const char* name);
+};
+
+#endif // QSPI_FOLDER_ENTRIES_H
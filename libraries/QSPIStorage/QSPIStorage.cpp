@@ -7,9 +7,22 @@
 #include "QSPIStorage.h"
 
 #include <zephyr/fs/fs.h>
+#include <zephyr/fs/littlefs.h>
 #include <errno.h>
 #include <cstring>
 
+#if DT_NODE_EXISTS(DT_NODELABEL(storage_fs))
+// Mount created by the devicetree fstab entry for /storage, exported to
+// sketches by the loader
+FS_FSTAB_DECLARE_ENTRY(DT_NODELABEL(storage_fs));
+#define QSPI_STORAGE_FSTAB_MOUNT (&FS_FSTAB_ENTRY(DT_NODELABEL(storage_fs)))
+#endif
+
+// LittleFS erase block size on the QSPI flash partitions
+static constexpr size_t QSPI_BLOCK_SIZE = 4096;
+// Cache memory allocated by begin(config); kept for the lifetime of the mount
+static uint32_t* custom_buffers = nullptr;
+
 bool QSPIStorage::begin(StorageError* error) {
     if (mounted_) {
         return true;
@@ -36,6 +49,98 @@ bool QSPIStorage::begin(StorageError* error) {
     return false;
 }
 
+bool QSPIStorage::begin(const QSPIStorageConfig& config, StorageError* error) {
+#ifdef QSPI_STORAGE_FSTAB_MOUNT
+    if (config.readSize == 0 || config.progSize == 0 || config.cacheSize == 0 ||
+        config.cacheSize % config.readSize != 0 || config.cacheSize % config.progSize != 0 ||
+        QSPI_BLOCK_SIZE % config.cacheSize != 0 || config.lookaheadSize == 0 ||
+        config.lookaheadSize % 8 != 0 || config.blockCycles == 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Invalid LittleFS configuration");
+        }
+        return false;
+    }
+
+    struct fs_mount_t* mount = QSPI_STORAGE_FSTAB_MOUNT;
+    struct fs_littlefs* littlefs = static_cast<struct fs_littlefs*>(mount->fs_data);
+
+    // The lookahead bitmap is accessed as 32 bit words
+    if (reinterpret_cast<uintptr_t>(config.buffer) % sizeof(uint32_t) != 0 ||
+        config.cacheSize % sizeof(uint32_t) != 0) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "LittleFS buffer must be 4 byte aligned");
+        }
+        return false;
+    }
+
+    uint8_t* buffers = config.buffer;
+    if (buffers == nullptr) {
+        buffers = reinterpret_cast<uint8_t*>(
+            new uint32_t[(config.bufferSize() + sizeof(uint32_t) - 1) / sizeof(uint32_t)]);
+        if (buffers == nullptr) {
+            if (error) {
+                error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate LittleFS caches");
+            }
+            return false;
+        }
+    }
+
+    struct fs_statvfs stat;
+    if (fs_statvfs(mount->mnt_point, &stat) == 0) {
+        int ret = fs_unmount(mount);
+        if (ret < 0) {
+            if (buffers != config.buffer) {
+                delete[] reinterpret_cast<uint32_t*>(buffers);
+            }
+            if (error) {
+                error->setError(StorageErrorCode::HARDWARE_ERROR, "Failed to unmount filesystem");
+            }
+            return false;
+        }
+    }
+    mounted_ = false;
+
+    struct lfs_config previous = littlefs->cfg;
+    struct lfs_config& cfg = littlefs->cfg;
+
+    cfg.read_size = config.readSize;
+    cfg.prog_size = config.progSize;
+    cfg.cache_size = config.cacheSize;
+    cfg.lookahead_size = config.lookaheadSize;
+    cfg.block_cycles = config.blockCycles;
+    cfg.read_buffer = buffers;
+    cfg.prog_buffer = buffers + config.cacheSize;
+    cfg.lookahead_buffer = buffers + 2 * config.cacheSize;
+
+    int ret = fs_mount(mount);
+    if (ret < 0) {
+        // Put the fstab configuration back so /storage stays usable
+        cfg = previous;
+        fs_mount(mount);
+        if (buffers != config.buffer) {
+            delete[] reinterpret_cast<uint32_t*>(buffers);
+        }
+        if (error) {
+            error->setError(StorageErrorCode::STORAGE_NOT_MOUNTED, "Failed to mount with new configuration");
+        }
+        return false;
+    }
+
+    // Buffers from an earlier begin(config) are no longer referenced
+    delete[] custom_buffers;
+    custom_buffers = (buffers != config.buffer) ? reinterpret_cast<uint32_t*>(buffers) : nullptr;
+
+    mounted_ = true;
+    return true;
+#else
+    if (error) {
+        error->setError(StorageErrorCode::STORAGE_NOT_MOUNTED,
+            "No LittleFS fstab entry for /storage in devicetree");
+    }
+    return false;
+#endif
+}
+
 bool QSPIStorage::getStorageInfo(size_t& total, size_t& used, size_t& available, StorageError* error) {
     if (!mounted_) {
         if (error) {
@@ -103,6 +208,19 @@ bool QSPIStorage::getMountInfo(int index, QSPIMountInfo& info) {
     return false;
 }
 
+bool QSPIStorage::isSameMount(const char* pathA, const char* pathB) {
+    if (pathA == nullptr || pathB == nullptr || pathA[0] != '/' || pathB[0] != '/') {
+        return false;
+    }
+
+    const char* endA = strchr(pathA + 1, '/');
+    const char* endB = strchr(pathB + 1, '/');
+    size_t lenA = endA ? static_cast<size_t>(endA - pathA) : strlen(pathA);
+    size_t lenB = endB ? static_cast<size_t>(endB - pathB) : strlen(pathB);
+
+    return lenA == lenB && strncmp(pathA, pathB, lenA) == 0;
+}
+
 void QSPIStorage::listMounts() {
     int idx = 0;
     const char *mnt_point;
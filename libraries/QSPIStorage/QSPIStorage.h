@@ -20,6 +20,31 @@ struct QSPIMountInfo {
     bool isFAT;              ///< true if FAT filesystem, false if LittleFS
 };
 
+/**
+ * @struct QSPIStorageConfig
+ * @brief LittleFS mount parameters for QSPIStorage::begin(const QSPIStorageConfig&).
+ *
+ * The defaults match the devicetree fstab entry in arduino_flash_fs.dtsi.
+ * cacheSize must be a multiple of readSize and progSize and divide the
+ * 4096 byte erase block. Each byte of lookahead tracks 8 blocks, so 224
+ * bytes cover the whole 7 MB partition and block allocation never has
+ * to rescan the disk.
+ */
+struct QSPIStorageConfig {
+    size_t readSize = 16;         ///< Minimum read size in bytes
+    size_t progSize = 4096;       ///< Minimum program size in bytes
+    size_t cacheSize = 4096;      ///< Filesystem read and program cache size
+    size_t lookaheadSize = 32;    ///< Block allocation bitmap size, a multiple of 8
+    int32_t blockCycles = 512;    ///< Erase cycles before metadata is moved, -1 disables wear leveling
+    uint8_t* buffer = nullptr;    ///< Optional caller-owned memory of bufferSize() bytes (e.g. SDRAM)
+
+    /**
+     * @brief Bytes of cache memory needed for this configuration.
+     * @return Size of the read cache, program cache and lookahead buffer
+     */
+    size_t bufferSize() const { return 2 * cacheSize + lookaheadSize; }
+};
+
 /**
  * @class QSPIStorage
  * @brief Main interface for QSPI flash storage access.
@@ -77,6 +102,33 @@ public:
      */
     bool begin(StorageError* error = nullptr);
 
+    /**
+     * @brief Remount /storage with custom LittleFS parameters.
+     *
+     * Unmounts the filesystem mounted by the devicetree fstab and mounts it
+     * again with the given cache, lookahead and wear leveling settings, so
+     * throughput-heavy sketches can trade RAM for speed. If the new
+     * parameters are rejected the original configuration is restored.
+     *
+     * Call this before any file is opened. The settings stay in effect
+     * until the next reset, also after end().
+     *
+     * @note Every open file allocates its own cache of cacheSize bytes from
+     * the LittleFS file cache heap (CONFIG_FS_LITTLEFS_FC_HEAP_SIZE).
+     *
+     * @param config Mount parameters
+     * @param error Optional pointer to receive error details
+     * @return true if storage is ready, false otherwise
+     *
+     * @code
+     * QSPIStorageConfig config;
+     * config.lookaheadSize = 224;  // Track all 1792 blocks at once
+     * config.buffer = (uint8_t*)SDRAM.malloc(config.bufferSize());
+     * storage.begin(config);
+     * @endcode
+     */
+    bool begin(const QSPIStorageConfig& config, StorageError* error = nullptr);
+
     /**
      * @brief Mark storage as not in use.
      *
@@ -155,6 +207,18 @@ public:
      */
     static bool getMountInfo(int index, QSPIMountInfo& info);
 
+    /**
+     * @brief Check whether two paths are on the same mounted filesystem.
+     *
+     * Compares the first path component, e.g. "/storage" or "/ota:".
+     * Paths on the same mount can be moved with a rename instead of a copy.
+     *
+     * @param pathA First absolute path
+     * @param pathB Second absolute path
+     * @return true if both paths share a mount point
+     */
+    static bool isSameMount(const char* pathA, const char* pathB);
+
     /**
      * @brief Print all mounted filesystems to Serial.
      *
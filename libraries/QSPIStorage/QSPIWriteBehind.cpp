@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "QSPIWriteBehind.h"
+
+#include <zephyr/fs/fs.h>
+#include <errno.h>
+#include <cstring>
+
+#ifndef QSPI_WRITE_BEHIND_STACK_SIZE
+#define QSPI_WRITE_BEHIND_STACK_SIZE 4096
+#endif
+
+#ifndef QSPI_WRITE_BEHIND_PRIORITY
+#define QSPI_WRITE_BEHIND_PRIORITY K_LOWEST_APPLICATION_THREAD_PRIO
+#endif
+
+// One storage thread serves every queue, so flash operations from different
+// files never compete with each other for the bus
+K_THREAD_STACK_DEFINE(write_behind_stack, QSPI_WRITE_BEHIND_STACK_SIZE);
+static struct k_thread write_behind_thread;
+static struct k_mutex registry_lock;
+static struct k_sem work_available;
+static QSPIWriteBehind* registry = nullptr;
+static bool worker_started = false;
+
+void QSPIWriteBehind::startWorker() {
+    k_sched_lock();
+    if (!worker_started) {
+        k_mutex_init(&registry_lock);
+        k_sem_init(&work_available, 0, 1);
+        k_thread_create(&write_behind_thread, write_behind_stack,
+                        K_THREAD_STACK_SIZEOF(write_behind_stack), workerEntry, nullptr, nullptr,
+                        nullptr, QSPI_WRITE_BEHIND_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&write_behind_thread, "qspi_write_behind");
+        worker_started = true;
+    }
+    k_sched_unlock();
+}
+
+void QSPIWriteBehind::workerEntry(void* p1, void* p2, void* p3) {
+    for (;;) {
+        k_sem_take(&work_available, K_FOREVER);
+
+        // Holding the registry lock for the whole pass keeps a queue from
+        // being destroyed while it is being served
+        k_mutex_lock(&registry_lock, K_FOREVER);
+        for (QSPIWriteBehind* queue = registry; queue != nullptr; queue = queue->next_) {
+            queue->service();
+        }
+        k_mutex_unlock(&registry_lock);
+    }
+}
+
+QSPIWriteBehind* QSPIWriteBehind::create(struct fs_file_t* file, size_t capacity, uint8_t* buffer) {
+    if (file == nullptr || capacity == 0) {
+        return nullptr;
+    }
+
+    bool ownsBuffer = (buffer == nullptr);
+    if (ownsBuffer) {
+        buffer = new uint8_t[capacity];
+        if (buffer == nullptr) {
+            return nullptr;
+        }
+    }
+
+    QSPIWriteBehind* queue = new QSPIWriteBehind(file, buffer, capacity, ownsBuffer);
+    if (queue == nullptr) {
+        if (ownsBuffer) {
+            delete[] buffer;
+        }
+        return nullptr;
+    }
+
+    startWorker();
+
+    k_mutex_lock(&registry_lock, K_FOREVER);
+    queue->next_ = registry;
+    registry = queue;
+    k_mutex_unlock(&registry_lock);
+
+    return queue;
+}
+
+QSPIWriteBehind::QSPIWriteBehind(struct fs_file_t* file, uint8_t* buffer, size_t capacity,
+                                 bool ownsBuffer)
+    : file_(file), buffer_(buffer), capacity_(capacity), ownsBuffer_(ownsBuffer), head_(0),
+      count_(0), syncRequested_(false), error_(0), stalls_(0), next_(nullptr) {
+    k_mutex_init(&lock_);
+    k_condvar_init(&changed_);
+}
+
+QSPIWriteBehind::~QSPIWriteBehind() {
+    k_mutex_lock(&registry_lock, K_FOREVER);
+    for (QSPIWriteBehind** link = &registry; *link != nullptr; link = &(*link)->next_) {
+        if (*link == this) {
+            *link = next_;
+            break;
+        }
+    }
+    k_mutex_unlock(&registry_lock);
+
+    if (ownsBuffer_) {
+        delete[] buffer_;
+    }
+}
+
+void QSPIWriteBehind::service() {
+    k_mutex_lock(&lock_, K_FOREVER);
+
+    while (count_ > 0) {
+        // Write the oldest contiguous run; the ring only wraps once per lap,
+        // so with a block-multiple capacity most writes are whole blocks
+        size_t tail = (head_ + capacity_ - count_) % capacity_;
+        size_t chunk = capacity_ - tail < count_ ? capacity_ - tail : count_;
+        const uint8_t* data = buffer_ + tail;
+        bool failed = (error_ != 0);
+
+        k_mutex_unlock(&lock_);
+        ssize_t ret = failed ? static_cast<ssize_t>(chunk) : fs_write(file_, data, chunk);
+        k_mutex_lock(&lock_, K_FOREVER);
+
+        if (ret >= 0 && static_cast<size_t>(ret) < chunk) {
+            ret = -ENOSPC;
+        }
+        if (ret < 0 && error_ == 0) {
+            error_ = static_cast<int>(ret);
+        }
+
+        // Data that failed to write is dropped; the error reports the loss
+        count_ -= chunk;
+        k_condvar_broadcast(&changed_);
+    }
+
+    if (syncRequested_) {
+        k_mutex_unlock(&lock_);
+        int ret = fs_sync(file_);
+        k_mutex_lock(&lock_, K_FOREVER);
+
+        if (ret < 0 && error_ == 0) {
+            error_ = ret;
+        }
+        syncRequested_ = false;
+        k_condvar_broadcast(&changed_);
+    }
+
+    k_mutex_unlock(&lock_);
+}
+
+ssize_t QSPIWriteBehind::write(const uint8_t* data, size_t size) {
+    k_mutex_lock(&lock_, K_FOREVER);
+
+    if (error_ != 0) {
+        int ret = error_;
+        error_ = 0;
+        k_mutex_unlock(&lock_);
+        return ret;
+    }
+
+    size_t remaining = size;
+    while (remaining > 0) {
+        if (count_ == capacity_) {
+            // Back-pressure: let the storage thread catch up
+            stalls_++;
+            k_sem_give(&work_available);
+            k_condvar_wait(&changed_, &lock_, K_FOREVER);
+            continue;
+        }
+
+        size_t space = capacity_ - count_;
+        size_t contiguous = capacity_ - head_;
+        size_t chunk = remaining;
+        if (chunk > space) {
+            chunk = space;
+        }
+        if (chunk > contiguous) {
+            chunk = contiguous;
+        }
+
+        memcpy(buffer_ + head_, data, chunk);
+        head_ = (head_ + chunk) % capacity_;
+        count_ += chunk;
+        data += chunk;
+        remaining -= chunk;
+    }
+
+    k_mutex_unlock(&lock_);
+    k_sem_give(&work_available);
+
+    return static_cast<ssize_t>(size);
+}
+
+int QSPIWriteBehind::drain(bool sync) {
+    k_mutex_lock(&lock_, K_FOREVER);
+
+    if (sync) {
+        syncRequested_ = true;
+    }
+
+    if (count_ > 0 || syncRequested_) {
+        k_sem_give(&work_available);
+        while (count_ > 0 || syncRequested_) {
+            k_condvar_wait(&changed_, &lock_, K_FOREVER);
+        }
+    }
+
+    int ret = error_;
+    error_ = 0;
+    k_mutex_unlock(&lock_);
+
+    return ret;
+}
+
+size_t QSPIWriteBehind::pending() {
+    k_mutex_lock(&lock_, K_FOREVER);
+    size_t count = count_;
+    k_mutex_unlock(&lock_);
+    return count;
+}
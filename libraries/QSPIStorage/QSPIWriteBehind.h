@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_WRITE_BEHIND_H
+#define QSPI_WRITE_BEHIND_H
+
+#include <Arduino.h>
+
+struct fs_file_t;
+
+/**
+ * @class QSPIWriteBehind
+ * @brief Bounded write queue drained by a background storage thread.
+ *
+ * Used by QSPIFile::enableWriteBehind(). Writers copy data into a ring
+ * buffer and return; a single low-priority thread shared by all queues
+ * performs the fs_write()/fs_sync() calls, so flash program and erase time
+ * is spent outside the writer's thread. When the ring is full the writer
+ * waits for the storage thread to make room.
+ *
+ * Errors from the storage thread are kept and returned by the next write()
+ * or drain(). All results are 0 or a negative errno value.
+ */
+class QSPIWriteBehind {
+public:
+    /**
+     * @brief Create a queue for an open file handle.
+     * @param file Handle the storage thread writes to
+     * @param capacity Ring buffer size in bytes
+     * @param buffer Optional caller-owned buffer of capacity bytes (e.g. SDRAM)
+     * @return New queue, or nullptr if out of memory
+     */
+    static QSPIWriteBehind* create(struct fs_file_t* file, size_t capacity, uint8_t* buffer);
+
+    /**
+     * @brief Unregister from the storage thread. Queued data is discarded,
+     * call drain() first to keep it.
+     */
+    ~QSPIWriteBehind();
+
+    QSPIWriteBehind(const QSPIWriteBehind&) = delete;
+    QSPIWriteBehind& operator=(const QSPIWriteBehind&) = delete;
+
+    /**
+     * @brief Queue data, waiting for space while the ring is full.
+     * @return Bytes queued, or a negative errno from an earlier failed write
+     */
+    ssize_t write(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Wait until all queued data has been written.
+     * @param sync Also fs_sync() the file once the queue is empty
+     * @return 0, or the first error since the last drain()
+     */
+    int drain(bool sync);
+
+    /**
+     * @brief Bytes queued but not written yet.
+     */
+    size_t pending();
+
+    /**
+     * @brief Ring buffer size in bytes.
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Number of times a writer had to wait for free space.
+     */
+    uint32_t stalls() const { return stalls_; }
+
+private:
+    QSPIWriteBehind(struct fs_file_t* file, uint8_t* buffer, size_t capacity, bool ownsBuffer);
+
+    struct fs_file_t* file_;
+    uint8_t* buffer_;
+    size_t capacity_;
+    bool ownsBuffer_;
+    size_t head_;          // Next byte written by write()
+    size_t count_;         // Bytes queued, ending at head_
+    bool syncRequested_;
+    int error_;            // First error seen by the storage thread
+    uint32_t stalls_;
+    struct k_mutex lock_;
+    struct k_condvar changed_; // Signalled when data was written or a sync finished
+    QSPIWriteBehind* next_;    // Registry of queues served by the storage thread
+
+    void service();
+    static void startWorker();
+    static void workerEntry(void* p1, void* p2, void* p3);
+};
+
+#endif // QSPI_WRITE_BEHIND_H
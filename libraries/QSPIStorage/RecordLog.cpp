@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "RecordLog.h"
+#include "QSPIFolder.h"
+
+#include <zephyr/sys/crc.h>
+#include <cstring>
+#include <cstdlib>
+
+// Record framing: 'R' 'L' | length (LE16) | CRC-32 of length + payload (LE32)
+static constexpr uint8_t RECORD_MAGIC_0 = 'R';
+static constexpr uint8_t RECORD_MAGIC_1 = 'L';
+static constexpr size_t MIN_BLOCK_SIZE = 64;
+
+RecordLog::RecordLog()
+    : staging_(nullptr), ownsStaging_(false), active_(false), staged_(0), segmentBytes_(0),
+      totalBytes_(0), firstSegment_(0), currentSegment_(0), commitsSinceSync_(0) {
+    resetStats();
+}
+
+RecordLog::~RecordLog() {
+    end(nullptr);
+}
+
+void RecordLog::resetStats() {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+size_t RecordLog::maxRecordSize() const {
+    size_t max = config_.blockSize - HEADER_SIZE;
+    return max > 0xFFFF ? 0xFFFF : max;
+}
+
+void RecordLog::segmentPath(uint32_t index, char* path, size_t size) const {
+    snprintf(path, size, "%s/seg_%08lu.log", config_.folder, static_cast<unsigned long>(index));
+}
+
+uint32_t RecordLog::recordCrc(uint16_t length, const uint8_t* data) {
+    uint8_t len[2] = {static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8)};
+    uint32_t crc = crc32_ieee_update(0, len, sizeof(len));
+    return crc32_ieee_update(crc, data, length);
+}
+
+bool RecordLog::begin(const RecordLogConfig& config, StorageError* error) {
+    if (active_) {
+        return true;
+    }
+
+    if (config.folder == nullptr || config.blockSize < MIN_BLOCK_SIZE ||
+        config.segmentSize < config.blockSize) {
+        if (error) {
+            error->setError(StorageErrorCode::INVALID_OPERATION, "Invalid record log configuration");
+        }
+        return false;
+    }
+
+    config_ = config;
+
+    if (config_.stagingBuffer != nullptr) {
+        staging_ = config_.stagingBuffer;
+        ownsStaging_ = false;
+    } else {
+        staging_ = new uint8_t[config_.blockSize];
+        if (staging_ == nullptr) {
+            if (error) {
+                error->setError(StorageErrorCode::OUT_OF_MEMORY, "Failed to allocate staging buffer");
+            }
+            return false;
+        }
+        ownsStaging_ = true;
+    }
+
+    QSPIFolder folder(config_.folder);
+    if (!folder.create(error)) {
+        end(nullptr);
+        return false;
+    }
+
+    // Find the oldest and newest segments; their sizes come for free with
+    // the directory listing
+    bool found = false;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    totalBytes_ = 0;
+
+    for (auto& entry : folder.entries(QSPIEntryType::FILES, "seg_*.log", error)) {
+        char* suffix = nullptr;
+        unsigned long index = strtoul(entry.name() + 4, &suffix, 10);
+        if (suffix == nullptr || strcmp(suffix, ".log") != 0) {
+            continue;
+        }
+
+        if (!found || index < first) {
+            first = index;
+        }
+        if (!found || index > last) {
+            last = index;
+        }
+        found = true;
+        totalBytes_ += entry.size();
+    }
+
+    firstSegment_ = first;
+    currentSegment_ = last;
+    staged_ = 0;
+    commitsSinceSync_ = 0;
+    resetStats();
+
+    if (!openSegment(currentSegment_, found, error)) {
+        end(nullptr);
+        return false;
+    }
+
+    active_ = true;
+    return true;
+}
+
+void RecordLog::end(StorageError* error) {
+    if (active_) {
+        commit(true, error);
+        active_ = false;
+    }
+
+    segment_.close(nullptr);
+
+    if (ownsStaging_) {
+        delete[] staging_;
+    }
+    staging_ = nullptr;
+    ownsStaging_ = false;
+}
+
+bool RecordLog::openSegment(uint32_t index, bool recover, StorageError* error) {
+    char path[STORAGE_MAX_PATH_LENGTH];
+    segmentPath(index, path, sizeof(path));
+
+    if (!segment_.open(path, FileMode::READ_WRITE_CREATE, error)) {
+        return false;
+    }
+
+    if (recover && !recoverSegment(error)) {
+        return false;
+    }
+
+    segmentBytes_ = segment_.size();
+    return segment_.seek(segmentBytes_, error);
+}
+
+// Reads exactly length bytes, reporting a short read as an I/O error
+static bool readFully(QSPIFile& file, uint8_t* buffer, size_t length, StorageError* error) {
+    if (file.read(buffer, length, error) == length) {
+        return true;
+    }
+    if (error && !error->hasError()) {
+        error->setError(StorageErrorCode::READ_ERROR, "Short read from record log");
+    }
+    return false;
+}
+
+RecordLog::RecordStatus RecordLog::readRecord(QSPIFile& file, size_t offset, size_t fileSize,
+                                              size_t& length, StorageError* error) {
+    uint8_t header[HEADER_SIZE];
+
+    // Only a record that runs past the end of the file or fails its magic
+    // or CRC is a torn tail; a failed read is an error, not the end of
+    // the log
+    if (offset + HEADER_SIZE > fileSize) {
+        return RECORD_TORN;
+    }
+    if (!readFully(file, header, sizeof(header), error)) {
+        return RECORD_ERROR;
+    }
+
+    if (header[0] != RECORD_MAGIC_0 || header[1] != RECORD_MAGIC_1) {
+        return RECORD_TORN;
+    }
+
+    uint16_t len = header[2] | (header[3] << 8);
+    uint32_t crc = header[4] | (header[5] << 8) | (header[6] << 16) |
+                   (static_cast<uint32_t>(header[7]) << 24);
+
+    if (len == 0 || offset + HEADER_SIZE + len > fileSize) {
+        return RECORD_TORN;
+    }
+
+    // A record written with a larger blockSize is checked in pieces of the
+    // staging buffer; one that fits is left whole in it
+    uint32_t actual = crc32_ieee_update(0, header + 2, 2);
+    for (size_t done = 0; done < len;) {
+        size_t chunk = len - done < config_.blockSize ? len - done : config_.blockSize;
+        if (!readFully(file, staging_, chunk, error)) {
+            return RECORD_ERROR;
+        }
+        actual = crc32_ieee_update(actual, staging_, chunk);
+        done += chunk;
+    }
+
+    if (actual != crc) {
+        return RECORD_TORN;
+    }
+
+    if (len > maxRecordSize()) {
+        if (error) {
+            error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Stored record larger than maxRecordSize");
+        }
+        return RECORD_ERROR;
+    }
+
+    length = len;
+    return RECORD_OK;
+}
+
+bool RecordLog::recoverSegment(StorageError* error) {
+    size_t fileSize = segment_.size();
+    size_t valid = 0;
+    size_t length;
+
+    if (!segment_.seek(0, error)) {
+        return false;
+    }
+
+    while (valid < fileSize) {
+        RecordStatus status = readRecord(segment_, valid, fileSize, length, error);
+        if (status == RECORD_ERROR) {
+            return false;
+        }
+        if (status == RECORD_TORN) {
+            break;
+        }
+        valid += HEADER_SIZE + length;
+    }
+
+    if (valid < fileSize) {
+        // Torn or corrupted tail from an interrupted write
+        if (!segment_.truncate(valid, error)) {
+            return false;
+        }
+        stats_.recoveredBytes += fileSize - valid;
+        totalBytes_ -= fileSize - valid;
+    }
+
+    return true;
+}
+
+size_t RecordLog::stagingTarget() const {
+    // Fill up to the next block boundary of the segment, so every commit
+    // after an early sync() realigns the file to whole blocks
+    return config_.blockSize - (segmentBytes_ % config_.blockSize);
+}
+
+bool RecordLog::stage(const uint8_t* data, size_t length, StorageError* error) {
+    while (length > 0) {
+        size_t space = stagingTarget() - staged_;
+        size_t chunk = length < space ? length : space;
+
+        memcpy(staging_ + staged_, data, chunk);
+        staged_ += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (staged_ == stagingTarget() && !commit(false, error)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RecordLog::commit(bool forceSync, StorageError* error) {
+    uint32_t start = micros();
+
+    if (staged_ > 0) {
+        size_t written = segment_.write(staging_, staged_, error);
+        if (written != staged_) {
+            if (error && !error->hasError()) {
+                error->setError(StorageErrorCode::WRITE_ERROR, "Short write to record log");
+            }
+            return false;
+        }
+
+        segmentBytes_ += written;
+        totalBytes_ += written;
+        stats_.bytes += written;
+        stats_.commits++;
+        staged_ = 0;
+        commitsSinceSync_++;
+    }
+
+    bool intervalReached = config_.syncInterval > 0 && commitsSinceSync_ >= config_.syncInterval;
+    if ((forceSync || intervalReached) && commitsSinceSync_ > 0) {
+        if (!segment_.flush(error)) {
+            return false;
+        }
+        stats_.syncs++;
+        commitsSinceSync_ = 0;
+    }
+
+    if (segmentBytes_ >= config_.segmentSize && !rotate(error)) {
+        return false;
+    }
+
+    uint32_t elapsed = micros() - start;
+    stats_.totalCommitUs += elapsed;
+    if (elapsed > stats_.maxCommitUs) {
+        stats_.maxCommitUs = elapsed;
+    }
+
+    return true;
+}
+
+bool RecordLog::rotate(StorageError* error) {
+    // Closing the segment commits its data and metadata
+    if (!segment_.close(error)) {
+        return false;
+    }
+    stats_.rotations++;
+    commitsSinceSync_ = 0;
+
+    currentSegment_++;
+    if (!openSegment(currentSegment_, false, error)) {
+        return false;
+    }
+
+    return enforceRetention(error);
+}
+
+bool RecordLog::enforceRetention(StorageError* error) {
+    char path[STORAGE_MAX_PATH_LENGTH];
+
+    // Leave room for the segment just opened to fill up completely
+    while (totalBytes_ + config_.segmentSize > config_.retentionSize &&
+           firstSegment_ < currentSegment_) {
+        segmentPath(firstSegment_, path, sizeof(path));
+
+        QSPIFile oldest(path);
+        size_t size = oldest.size(nullptr);
+        if (oldest.exists(nullptr) && !oldest.remove(error)) {
+            return false;
+        }
+
+        totalBytes_ = size < totalBytes_ ? totalBytes_ - size : 0;
+        firstSegment_++;
+    }
+
+    return true;
+}
+
+bool RecordLog::append(const void* data, size_t length, StorageError* error) {
+    if (!active_) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Record log not started");
+        }
+        return false;
+    }
+
+    if (data == nullptr || length == 0 || length > maxRecordSize()) {
+        if (error) {
+            error->setError(StorageErrorCode::BUFFER_OVERFLOW, "Invalid record size");
+        }
+        return false;
+    }
+
+    // Records never straddle segments, so dropping the oldest segment never
+    // leaves half a record behind
+    size_t pending = segmentBytes_ + staged_;
+    if (pending > 0 && pending + HEADER_SIZE + length > config_.segmentSize) {
+        if (!commit(false, error)) {
+            return false;
+        }
+        if (segmentBytes_ > 0 && !rotate(error)) {
+            return false;
+        }
+    }
+
+    const uint8_t* payload = static_cast<const uint8_t*>(data);
+    uint32_t crc = recordCrc(static_cast<uint16_t>(length), payload);
+    uint8_t header[HEADER_SIZE] = {
+        RECORD_MAGIC_0,
+        RECORD_MAGIC_1,
+        static_cast<uint8_t>(length),
+        static_cast<uint8_t>(length >> 8),
+        static_cast<uint8_t>(crc),
+        static_cast<uint8_t>(crc >> 8),
+        static_cast<uint8_t>(crc >> 16),
+        static_cast<uint8_t>(crc >> 24),
+    };
+
+    if (!stage(header, sizeof(header), error) || !stage(payload, length, error)) {
+        return false;
+    }
+
+    stats_.records++;
+    return true;
+}
+
+bool RecordLog::sync(StorageError* error) {
+    if (!active_) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Record log not started");
+        }
+        return false;
+    }
+
+    return commit(true, error);
+}
+
+bool RecordLog::replay(RecordLogCallback callback, void* context, StorageError* error) {
+    if (!active_ || callback == nullptr) {
+        if (error) {
+            error->setError(StorageErrorCode::NOT_INITIALIZED, "Record log not started");
+        }
+        return false;
+    }
+
+    // Make everything visible to a second handle; this also frees the
+    // staging buffer for use as the record buffer
+    if (!commit(true, error)) {
+        return false;
+    }
+
+    char path[STORAGE_MAX_PATH_LENGTH];
+    size_t length;
+
+    for (uint32_t index = firstSegment_; index <= currentSegment_; index++) {
+        segmentPath(index, path, sizeof(path));
+
+        QSPIFile file(path);
+        if (!file.open(FileMode::READ, nullptr)) {
+            continue;
+        }
+
+        size_t fileSize = file.size();
+        size_t offset = 0;
+        RecordStatus status;
+        while ((status = readRecord(file, offset, fileSize, length, error)) == RECORD_OK) {
+            if (!callback(staging_, length, context)) {
+                file.close(nullptr);
+                return true;
+            }
+            offset += HEADER_SIZE + length;
+        }
+
+        file.close(nullptr);
+        if (status == RECORD_ERROR) {
+            return false;
+        }
+    }
+
+    return true;
+}
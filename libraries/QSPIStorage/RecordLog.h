@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef QSPI_RECORD_LOG_H
+#define QSPI_RECORD_LOG_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+#include "QSPIFile.h"
+
+/**
+ * @struct RecordLogConfig
+ * @brief Configuration for RecordLog::begin().
+ */
+struct RecordLogConfig {
+    const char* folder = "/storage/log";    ///< Folder holding the segment files
+    size_t segmentSize = 256 * 1024;        ///< Rotate to a new segment past this size
+    size_t retentionSize = 2 * 1024 * 1024; ///< Upper bound on the total size of all segments
+    size_t blockSize = 4096;                ///< Commit granularity, match LittleFS prog-size
+    uint8_t* stagingBuffer = nullptr;       ///< Optional blockSize bytes buffer (e.g. SDRAM)
+    uint32_t syncInterval = 8;              ///< fs_sync every N commits, 0 = only on rotate/sync()
+};
+
+/**
+ * @struct RecordLogStats
+ * @brief Counters collected by a RecordLog since begin().
+ */
+struct RecordLogStats {
+    uint32_t records;         ///< Records appended
+    uint32_t bytes;           ///< Bytes committed to flash, headers included
+    uint32_t commits;         ///< Block writes issued
+    uint32_t syncs;           ///< fs_sync calls issued
+    uint32_t rotations;       ///< Segments closed
+    uint32_t maxCommitUs;     ///< Slowest commit (write + optional sync + rotation)
+    uint32_t totalCommitUs;   ///< Sum of all commit times
+    uint32_t recoveredBytes;  ///< Torn tail bytes discarded by the boot scan
+};
+
+/**
+ * @brief Callback invoked by RecordLog::replay() for every valid record.
+ * @return false to stop the replay early
+ */
+typedef bool (*RecordLogCallback)(const uint8_t* data, size_t length, void* context);
+
+/**
+ * @class RecordLog
+ * @brief Append-only record log for high-rate data logging on QSPI flash.
+ *
+ * Writing small records straight through QSPIFile::write() makes LittleFS
+ * program a partial block and update metadata for every record. RecordLog
+ * instead stages records in RAM and writes them out in whole blocks, so each
+ * flash program carries blockSize bytes of payload and the file stays block
+ * aligned.
+ *
+ * Records are stored in segment files (seg_00000000.log, seg_00000001.log,
+ * ...) inside the configured folder. When a segment reaches segmentSize the
+ * log rotates to a new one, and the oldest segments are deleted once the
+ * total exceeds retentionSize. Every record carries a CRC-32; at begin() only
+ * the newest segment is scanned and any torn tail left by a power loss is
+ * truncated away.
+ *
+ * LittleFS only makes file data durable on sync, so on power failure the log
+ * loses whatever was staged in RAM plus the commits since the last sync
+ * (at most syncInterval blocks). Call sync() where data must be durable.
+ *
+ * @note RecordLog is not thread safe. Use it from a single thread.
+ *
+ * @code
+ * RecordLog log;
+ * RecordLogConfig config;
+ * config.folder = "/storage/imu";
+ * log.begin(config);
+ *
+ * void loop() {
+ *     Sample s = readSensor();
+ *     log.append(&s, sizeof(s));
+ * }
+ * @endcode
+ */
+class RecordLog {
+public:
+    /// Bytes of framing stored in front of every record
+    static constexpr size_t HEADER_SIZE = 8;
+
+    RecordLog();
+    ~RecordLog();
+
+    RecordLog(const RecordLog&) = delete;
+    RecordLog& operator=(const RecordLog&) = delete;
+
+    /**
+     * @brief Open the log, recovering the newest segment if needed.
+     *
+     * A torn record at the end of the newest segment is truncated away. A
+     * segment holding records larger than maxRecordSize() allows, or one
+     * that cannot be read, is left untouched and begin() fails.
+     *
+     * @param config Log configuration
+     * @param error Optional pointer to receive error details
+     * @return true if the log is ready for appending
+     */
+    bool begin(const RecordLogConfig& config = RecordLogConfig(), StorageError* error = nullptr);
+
+    /**
+     * @brief Commit staged records, sync and close the log.
+     * @param error Optional pointer to receive error details
+     */
+    void end(StorageError* error = nullptr);
+
+    /**
+     * @brief Append one record.
+     *
+     * Usually only copies into the staging buffer; a block write happens
+     * when the buffer fills up.
+     *
+     * @param data Record payload
+     * @param length Payload size, at most maxRecordSize()
+     * @param error Optional pointer to receive error details
+     * @return true if the record was accepted
+     */
+    bool append(const void* data, size_t length, StorageError* error = nullptr);
+
+    /**
+     * @brief Write out staged records and make them durable.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    bool sync(StorageError* error = nullptr);
+
+    /**
+     * @brief Walk all stored records from oldest to newest.
+     *
+     * Commits staged records first. Stops at the first corrupted record of
+     * each segment.
+     *
+     * @param callback Function called for every valid record
+     * @param context User pointer passed to the callback
+     * @param error Optional pointer to receive error details
+     * @return true if all segments could be read
+     */
+    bool replay(RecordLogCallback callback, void* context = nullptr, StorageError* error = nullptr);
+
+    /**
+     * @brief Largest payload accepted by append().
+     * @return Maximum record size in bytes
+     */
+    size_t maxRecordSize() const;
+
+    /**
+     * @brief Total size of all segments, staged bytes excluded.
+     * @return Size in bytes
+     */
+    size_t storedBytes() const { return totalBytes_; }
+
+    /**
+     * @brief Index of the oldest segment still on storage.
+     */
+    uint32_t firstSegment() const { return firstSegment_; }
+
+    /**
+     * @brief Index of the segment currently being written.
+     */
+    uint32_t currentSegment() const { return currentSegment_; }
+
+    /**
+     * @brief Get the counters collected since begin().
+     * @return Statistics snapshot
+     */
+    const RecordLogStats& getStats() const { return stats_; }
+
+    /**
+     * @brief Reset the counters.
+     */
+    void resetStats();
+
+private:
+    RecordLogConfig config_;
+    QSPIFile segment_;
+    uint8_t* staging_;
+    bool ownsStaging_;
+    bool active_;
+    size_t staged_;
+    size_t segmentBytes_;
+    size_t totalBytes_;
+    uint32_t firstSegment_;
+    uint32_t currentSegment_;
+    uint32_t commitsSinceSync_;
+    RecordLogStats stats_;
+
+    size_t stagingTarget() const;
+    bool stage(const uint8_t* data, size_t length, StorageError* error);
+    bool commit(bool forceSync, StorageError* error);
+    bool rotate(StorageError* error);
+    bool openSegment(uint32_t index, bool recover, StorageError* error);
+    bool recoverSegment(StorageError* error);
+    bool enforceRetention(StorageError* error);
+    void segmentPath(uint32_t index, char* path, size_t size) const;
+    enum RecordStatus { RECORD_OK, RECORD_TORN, RECORD_ERROR };
+    RecordStatus readRecord(QSPIFile& file, size_t offset, size_t fileSize, size_t& length,
+                            StorageError* error);
+    static uint32_t recordCrc(uint16_t length, const uint8_t* data);
+};
+
+#endif // QSPI_RECORD_LOG_H
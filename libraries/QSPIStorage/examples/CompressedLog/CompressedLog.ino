@@ -0,0 +1,95 @@
+/*
+  QSPIStorage - Compressed Log Example
+
+  Writes the same text log once with QSPIFile and once with CompressedFile,
+  then compares the time taken and the space used on flash. Finally reads
+  a line back from the middle of the compressed log with seek().
+
+  This example code is in the public domain.
+*/
+
+#include <QSPIStorage.h>
+#include <CompressedFile.h>
+
+QSPIStorage storage;
+
+const uint32_t LINES = 5000;
+
+size_t formatLine(char* line, size_t size, uint32_t i) {
+    return snprintf(line, size, "%08lu sensor=%u temp=%d.%u hum=%u\n", (unsigned long)(i * 100),
+                    (unsigned)(i % 4), 20 + (int)(i % 7), (unsigned)(i % 10), 40 + (unsigned)(i % 13));
+}
+
+void writeLog(File& file, const char* name) {
+    StorageError error;
+    file.remove();
+
+    if (!file.open(FileMode::WRITE, &error)) {
+        Serial.print("Failed to open file: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    char line[64];
+    uint32_t start = millis();
+    for (uint32_t i = 0; i < LINES; i++) {
+        size_t length = formatLine(line, sizeof(line), i);
+        file.write((const uint8_t*)line, length, &error);
+    }
+    file.close(&error);
+    uint32_t elapsed = millis() - start;
+
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(elapsed);
+    Serial.print(" ms, ");
+    Serial.print(QSPIFile(file.getPath()).size());
+    Serial.println(" bytes on flash");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+
+    Serial.println("Compressed Log Example");
+    Serial.println("======================");
+
+    StorageError error;
+    if (!storage.begin(&error)) {
+        Serial.print("Storage initialization failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    QSPIFile plain("/storage/log.txt");
+    writeLog(plain, "QSPIFile      ");
+
+    CompressedFile compressed("/storage/log.lz");
+    writeLog(compressed, "CompressedFile");
+
+    // Read back one line from the middle without decompressing the rest
+    if (compressed.open(FileMode::READ, &error)) {
+        char expected[64];
+        size_t length = formatLine(expected, sizeof(expected), LINES / 2);
+
+        uint32_t start = micros();
+        compressed.seek((size_t)(LINES / 2) * length, &error);
+        char line[64] = {0};
+        compressed.read((uint8_t*)line, length, &error);
+        uint32_t elapsed = micros() - start;
+
+        Serial.print("Line ");
+        Serial.print(LINES / 2);
+        Serial.print(": ");
+        Serial.print(line);
+        Serial.print("Seek and read took ");
+        Serial.print(elapsed);
+        Serial.println(" us");
+        compressed.close();
+    }
+}
+
+void loop() {
+}
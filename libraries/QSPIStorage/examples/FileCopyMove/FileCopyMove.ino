@@ -6,11 +6,12 @@
 
   Operations demonstrated:
   - Creating files with content
-  - Copying files (read + write)
-  - Moving/renaming files
+  - Copying files with copyTo()
+  - Moving/renaming files with moveTo()
   - Creating folders
   - Copying folders recursively
   - Moving/renaming folders
+  - Copying to the FAT partition mounted at /ota: (if present)
 
   This example code is in the public domain.
 */
@@ -19,98 +20,12 @@
 
 QSPIStorage storage;
 
-// Helper function to copy a file
-bool copyFile(const char* srcPath, const char* dstPath) {
-    QSPIFile srcFile(srcPath);
-    StorageError error;
-
-    if (!srcFile.open(FileMode::READ, &error)) {
-        Serial.print("Failed to open source file: ");
-        Serial.println(error.getMessage());
-        return false;
-    }
-
-    QSPIFile dstFile(dstPath);
-    if (!dstFile.open(FileMode::WRITE, &error)) {
-        Serial.print("Failed to create destination file: ");
-        Serial.println(error.getMessage());
-        srcFile.close();
-        return false;
-    }
-
-    // Copy in chunks
-    uint8_t buffer[256];
-    size_t totalCopied = 0;
-
-    while (srcFile.available() > 0) {
-        size_t bytesRead = srcFile.read(buffer, sizeof(buffer), &error);
-        if (bytesRead == 0) break;
-
-        size_t bytesWritten = dstFile.write(buffer, bytesRead, &error);
-        if (bytesWritten != bytesRead) {
-            Serial.println("Write error during copy");
-            srcFile.close();
-            dstFile.close();
-            return false;
-        }
-        totalCopied += bytesWritten;
-    }
-
-    srcFile.close();
-    dstFile.close();
-
-    Serial.print("Copied ");
-    Serial.print(totalCopied);
+void printProgress(size_t copied, size_t total) {
+    Serial.print("  ");
+    Serial.print(copied);
+    Serial.print(" / ");
+    Serial.print(total);
     Serial.println(" bytes");
-    return true;
-}
-
-// Helper function to copy a folder recursively
-bool copyFolder(QSPIFolder& srcFolder, QSPIFolder& dstFolder) {
-    StorageError error;
-
-    // Create destination folder if it doesn't exist
-    if (!dstFolder.exists()) {
-        if (!dstFolder.create(&error)) {
-            Serial.print("Failed to create destination folder: ");
-            Serial.println(error.getMessage());
-            return false;
-        }
-    }
-
-    // Copy all files
-    std::vector<QSPIFile> files = srcFolder.getFiles(&error);
-    for (auto& file : files) {
-        String srcPath = file.getPath();
-        String filename = file.getFilename();
-        String dstPath = String(dstFolder.getPath()) + "/" + filename;
-
-        Serial.print("  Copying file: ");
-        Serial.print(filename);
-        Serial.print(" -> ");
-        Serial.println(dstPath);
-
-        if (!copyFile(srcPath.c_str(), dstPath.c_str())) {
-            return false;
-        }
-    }
-
-    // Recursively copy subfolders
-    std::vector<QSPIFolder> subfolders = srcFolder.getFolders(&error);
-    for (auto& subfolder : subfolders) {
-        String subName = subfolder.getFolderName();
-        String dstSubPath = String(dstFolder.getPath()) + "/" + subName;
-
-        Serial.print("  Copying subfolder: ");
-        Serial.println(subName);
-
-        QSPIFolder dstSubfolder(dstSubPath);
-        if (!copyFolder(subfolder, dstSubfolder)) {
-            return false;
-        }
-    }
-
-    return true;
 }
 
 void setup() {
@@ -178,8 +93,12 @@ void setup() {
     Serial.println("\n--- Copying Files ---\n");
 
     Serial.println("Copying original.txt to copy.txt...");
-    if (copyFile("/storage/test_copy/original.txt", "/storage/test_copy/copy.txt")) {
+    QSPIFile original("/storage/test_copy/original.txt");
+    if (original.copyTo("/storage/test_copy/copy.txt", true, &error)) {
         Serial.println("File copied successfully!");
+    } else {
+        Serial.print("Failed to copy file: ");
+        Serial.println(error.getMessage());
     }
 
     // ========================================
@@ -195,12 +114,12 @@ void setup() {
         Serial.println("Created /storage/test_copy/to_move.txt");
     }
 
-    // Rename/move the file
+    // Within /storage a move is a rename; no data is copied
     QSPIFile fileToMove("/storage/test_copy/to_move.txt");
-    if (fileToMove.rename("/storage/test_copy/moved.txt", &error)) {
-        Serial.println("Renamed to_move.txt -> moved.txt");
+    if (fileToMove.moveTo("/storage/test_copy/moved.txt", true, &error)) {
+        Serial.println("Moved to_move.txt -> moved.txt");
     } else {
-        Serial.print("Failed to rename file: ");
+        Serial.print("Failed to move file: ");
         Serial.println(error.getMessage());
     }
 
@@ -210,9 +129,27 @@ void setup() {
     Serial.println("\n--- Copying Folders ---\n");
 
     Serial.println("Copying test_copy/ to test_backup/...");
-    QSPIFolder backupFolder = root.createSubfolder("test_backup", true, &error);
-    if (copyFolder(testFolder, backupFolder)) {
+    if (testFolder.copyTo("/storage/test_backup", true, &error)) {
         Serial.println("Folder copied successfully!");
+    } else {
+        Serial.print("Failed to copy folder: ");
+        Serial.println(error.getMessage());
+    }
+
+    // Copying to another filesystem reads and writes in large transfers;
+    // the progress callback is called after each one
+    if (QSPIFolder("/ota:").exists()) {
+        Serial.println("\nCopying original.txt to the /ota: partition...");
+        QSPICopyOptions options;
+        options.overwrite = true;
+        options.progress = printProgress;
+        if (original.copyTo("/ota:/original.txt", options, &error)) {
+            Serial.println("Cross-filesystem copy successful!");
+            QSPIFile("/ota:/original.txt").remove();
+        } else {
+            Serial.print("Failed to copy to /ota:: ");
+            Serial.println(error.getMessage());
+        }
     }
 
     // ========================================
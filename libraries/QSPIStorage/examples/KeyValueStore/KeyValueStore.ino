@@ -0,0 +1,110 @@
+/*
+  QSPIStorage - Key-Value Store Example
+
+  Demonstrates KVStore, which keeps many small settings in a single
+  log file on QSPI flash with an in-RAM index for fast lookups.
+
+  Operations demonstrated:
+  - Reading and updating a boot counter
+  - Storing strings and structs
+  - Updating several keys atomically with a batch
+  - Listing and deleting keys
+
+  This example code is in the public domain.
+*/
+
+#include <QSPIStorage.h>
+#include <KVStore.h>
+
+QSPIStorage storage;
+KVStore kv;
+
+struct NetworkConfig {
+    uint8_t ip[4];
+    uint16_t port;
+};
+
+bool printKey(const char* key, const uint8_t* value, size_t length, void* context) {
+    Serial.print("  ");
+    Serial.print(key);
+    Serial.print(" (");
+    Serial.print(length);
+    Serial.println(" bytes)");
+    return true;
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+
+    Serial.println("QSPIStorage - Key-Value Store Example\n");
+
+    StorageError error;
+    if (!storage.begin(&error)) {
+        Serial.print("Storage initialization failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    if (!kv.begin(KVStoreConfig(), &error)) {
+        Serial.print("Key-value store initialization failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    // Boot counter survives resets
+    uint32_t boots = 0;
+    kv.get("boots", &boots, sizeof(boots));
+    boots++;
+    kv.set("boots", &boots, sizeof(boots));
+    Serial.print("Boot count: ");
+    Serial.println(boots);
+
+    // Strings are stored as raw bytes
+    const char* name = "greenhouse-3";
+    kv.set("device/name", name, strlen(name) + 1);
+
+    char buffer[32];
+    if (kv.get("device/name", buffer, sizeof(buffer)) > 0) {
+        Serial.print("Device name: ");
+        Serial.println(buffer);
+    }
+
+    // Update related keys together: after a power loss either both
+    // are stored or neither is
+    NetworkConfig net = {{192, 168, 1, 50}, 8080};
+    uint8_t dhcp = 0;
+    kv.beginBatch();
+    kv.set("net/config", &net, sizeof(net));
+    kv.set("net/dhcp", &dhcp, sizeof(dhcp));
+    if (kv.commitBatch(&error)) {
+        Serial.println("Network settings saved");
+    } else {
+        Serial.print("Batch failed: ");
+        Serial.println(error.getMessage());
+    }
+
+    Serial.println("\nStored keys:");
+    kv.forEach(printKey);
+
+    kv.remove("net/dhcp");
+    Serial.print("\nAfter removing net/dhcp: ");
+    Serial.print(kv.count());
+    Serial.println(" keys");
+
+    KVStoreStats stats;
+    kv.getStats(stats);
+    Serial.print("Log size: ");
+    Serial.print(stats.logBytes);
+    Serial.print(" bytes, live: ");
+    Serial.print(stats.liveBytes);
+    Serial.println(" bytes");
+
+    Serial.println("\nDone!");
+}
+
+void loop() {
+    delay(10000);
+}
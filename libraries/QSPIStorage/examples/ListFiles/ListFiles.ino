@@ -129,12 +129,13 @@ void listWithFolderAPI() {
     // List files with details
     if (fileCount > 0) {
         Serial.println("\n  Files:");
-        std::vector<QSPIFile> files = root.getFiles(&error);
-        for (auto& file : files) {
+        // entries() reads the directory lazily and reports sizes
+        // without opening each file
+        for (auto& entry : root.entries(QSPIEntryType::FILES, nullptr, &error)) {
             Serial.print("    ");
-            Serial.print(file.getFilename());
+            Serial.print(entry.name());
             Serial.print(" (");
-            Serial.print(file.size(&error));
+            Serial.print(entry.size());
             Serial.println(" bytes)");
         }
     }
@@ -0,0 +1,106 @@
+/*
+  QSPIStorage - OTA Stream Example
+
+  Streams a 1 MB test image into the raw "ota" partition with OTAWriter,
+  in chunks of varying size as they would arrive from a network socket,
+  and reports the sustained write rate and the SHA-256 of the image.
+
+  The storage thread erases sectors ahead of the data while the sketch
+  produces the next chunk, so erase time mostly overlaps with receiving.
+
+  Note: this replaces the FAT filesystem on /ota:.
+
+  This example code is in the public domain.
+*/
+
+#include <OTAWriter.h>
+
+const size_t IMAGE_SIZE = 1024 * 1024;
+
+// Simulates a network read: fills up to maxLength bytes of the image
+size_t receive(uint8_t* buffer, size_t maxLength, size_t offset) {
+    size_t length = 536 + (offset / 7) % 1000;
+    if (length > maxLength) {
+        length = maxLength;
+    }
+    if (length > IMAGE_SIZE - offset) {
+        length = IMAGE_SIZE - offset;
+    }
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = (uint8_t)((offset + i) * 31);
+    }
+    return length;
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+
+    Serial.println("OTA Stream Example");
+    Serial.println("==================");
+    Serial.print("OTA partition size: ");
+    Serial.print(OTAWriter::capacity() / 1024);
+    Serial.println(" KB");
+
+    StorageError error;
+    OTAWriter ota;
+
+    if (!ota.begin(IMAGE_SIZE, 32 * 1024, nullptr, &error)) {
+        Serial.print("Failed to start update: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    static uint8_t chunk[1536];
+    size_t offset = 0;
+    while (offset < IMAGE_SIZE) {
+        size_t length = receive(chunk, sizeof(chunk), offset);
+        if (ota.write(chunk, length, &error) != length) {
+            Serial.print("Write failed: ");
+            Serial.println(error.getMessage());
+            ota.abort();
+            return;
+        }
+        offset += length;
+    }
+
+    if (!ota.finish(&error)) {
+        Serial.print("Finish failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    OTAWriterStats stats = ota.getStats();
+    Serial.print("Written: ");
+    Serial.print(stats.bytesWritten);
+    Serial.print(" bytes in ");
+    Serial.print(stats.elapsedMs);
+    Serial.println(" ms");
+    Serial.print("Throughput: ");
+    Serial.print(stats.bytesPerSecond / 1024);
+    Serial.println(" KB/s");
+    Serial.print("Erase time: ");
+    Serial.print(stats.eraseMs);
+    Serial.print(" ms, program time: ");
+    Serial.print(stats.programMs);
+    Serial.println(" ms");
+    Serial.print("Writer stalls: ");
+    Serial.println(stats.stalls);
+
+    uint8_t digest[OTAWriter::SHA256_SIZE];
+    if (ota.getSha256(digest)) {
+        Serial.print("SHA-256: ");
+        for (size_t i = 0; i < sizeof(digest); i++) {
+            if (digest[i] < 0x10) {
+                Serial.print('0');
+            }
+            Serial.print(digest[i], HEX);
+        }
+        Serial.println();
+    }
+}
+
+void loop() {
+}
@@ -0,0 +1,204 @@
+/*
+  QSPIStorage - Record Log Benchmark
+
+  Compares writing small fixed-size records one by one through
+  QSPIFile::write() with appending them to a RecordLog, which stages
+  records in RAM and commits them to flash in whole blocks.
+
+  For each method it reports:
+  - Sustained throughput (records/s and KB/s)
+  - Average and worst-case latency of a single append
+  - How many appends took longer than 1 ms (a missed slot at 1 kHz)
+
+  After the run the RecordLog is replayed to verify every record.
+
+  This example code is in the public domain.
+*/
+
+#include <QSPIStorage.h>
+#include <RecordLog.h>
+
+QSPIStorage storage;
+
+const size_t RECORD_SIZE = 64;
+const uint32_t RECORD_COUNT = 5000;
+
+struct LatencyStats {
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t over1ms;
+};
+
+void resetLatency(LatencyStats& stats) {
+    stats.maxUs = 0;
+    stats.totalUs = 0;
+    stats.over1ms = 0;
+}
+
+void recordLatency(LatencyStats& stats, uint32_t us) {
+    stats.totalUs += us;
+    if (us > stats.maxUs) {
+        stats.maxUs = us;
+    }
+    if (us > 1000) {
+        stats.over1ms++;
+    }
+}
+
+void fillRecord(uint8_t* record, uint32_t sequence) {
+    memcpy(record, &sequence, sizeof(sequence));
+    for (size_t i = sizeof(sequence); i < RECORD_SIZE; i++) {
+        record[i] = (uint8_t)(sequence + i);
+    }
+}
+
+void printResult(const char* name, uint32_t elapsedUs, const LatencyStats& stats) {
+    float seconds = elapsedUs / 1000000.0f;
+
+    Serial.print(name);
+    Serial.println(":");
+    Serial.print("  Records/s:   ");
+    Serial.println((uint32_t)(RECORD_COUNT / seconds));
+    Serial.print("  KB/s:        ");
+    Serial.println((uint32_t)(RECORD_COUNT * RECORD_SIZE / 1024 / seconds));
+    Serial.print("  Avg append:  ");
+    Serial.print((uint32_t)(stats.totalUs / RECORD_COUNT));
+    Serial.println(" us");
+    Serial.print("  Max append:  ");
+    Serial.print(stats.maxUs);
+    Serial.println(" us");
+    Serial.print("  > 1 ms:      ");
+    Serial.println(stats.over1ms);
+}
+
+void benchmarkPlainFile() {
+    StorageError error;
+    LatencyStats stats;
+    uint8_t record[RECORD_SIZE];
+
+    QSPIFile file("/storage/bench_plain.bin");
+    file.remove();
+    if (!file.open(FileMode::WRITE, &error)) {
+        Serial.print("Failed to open file: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    resetLatency(stats);
+    uint32_t start = micros();
+
+    for (uint32_t i = 0; i < RECORD_COUNT; i++) {
+        fillRecord(record, i);
+        uint32_t t0 = micros();
+        file.write(record, sizeof(record));
+        file.flush();
+        recordLatency(stats, micros() - t0);
+    }
+
+    uint32_t elapsed = micros() - start;
+    file.close();
+    file.remove();
+
+    printResult("QSPIFile::write + flush per record", elapsed, stats);
+}
+
+uint32_t replayCount = 0;
+bool replayOk = true;
+
+bool checkRecord(const uint8_t* data, size_t length, void* context) {
+    uint32_t sequence;
+    memcpy(&sequence, data, sizeof(sequence));
+    if (length != RECORD_SIZE || sequence != replayCount) {
+        replayOk = false;
+        return false;
+    }
+    replayCount++;
+    return true;
+}
+
+void benchmarkRecordLog() {
+    StorageError error;
+    LatencyStats stats;
+    uint8_t record[RECORD_SIZE];
+
+    // Start from an empty log so the replay check is exact
+    QSPIFolder("/storage/bench_log").remove(true);
+
+    RecordLog log;
+    RecordLogConfig config;
+    config.folder = "/storage/bench_log";
+    config.segmentSize = 128 * 1024;
+    config.retentionSize = 1024 * 1024;
+
+    if (!log.begin(config, &error)) {
+        Serial.print("Failed to start record log: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    resetLatency(stats);
+    uint32_t start = micros();
+
+    for (uint32_t i = 0; i < RECORD_COUNT; i++) {
+        fillRecord(record, i);
+        uint32_t t0 = micros();
+        log.append(record, sizeof(record));
+        recordLatency(stats, micros() - t0);
+    }
+    log.sync();
+
+    uint32_t elapsed = micros() - start;
+    printResult("RecordLog::append", elapsed, stats);
+
+    const RecordLogStats& logStats = log.getStats();
+    Serial.print("  Commits:     ");
+    Serial.println(logStats.commits);
+    Serial.print("  Syncs:       ");
+    Serial.println(logStats.syncs);
+    Serial.print("  Rotations:   ");
+    Serial.println(logStats.rotations);
+    Serial.print("  Max commit:  ");
+    Serial.print(logStats.maxCommitUs);
+    Serial.println(" us");
+
+    replayCount = 0;
+    replayOk = true;
+    log.replay(checkRecord);
+    Serial.print("  Replay:      ");
+    Serial.print(replayCount);
+    Serial.println(replayOk && replayCount == RECORD_COUNT ? " records OK" : " records MISMATCH");
+
+    log.end();
+    QSPIFolder("/storage/bench_log").remove(true);
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+
+    Serial.println("QSPIStorage - Record Log Benchmark\n");
+
+    StorageError error;
+    if (!storage.begin(&error)) {
+        Serial.print("Storage initialization failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    Serial.print(RECORD_COUNT);
+    Serial.print(" records of ");
+    Serial.print(RECORD_SIZE);
+    Serial.println(" bytes\n");
+
+    benchmarkPlainFile();
+    Serial.println();
+    benchmarkRecordLog();
+
+    Serial.println("\nDone!");
+}
+
+void loop() {
+    delay(10000);
+}
@@ -0,0 +1,271 @@
+/*
+  QSPIStorage - Storage Benchmark
+
+  Measures the LittleFS partition mounted at /storage so changes to the
+  filesystem parameters (read-size, prog-size, cache-size, lookahead-size,
+  block-cycles in arduino_flash_fs.dtsi) can be compared on real numbers.
+
+  Tests:
+  - Sequential write and read throughput at several chunk sizes
+  - Random 4 KB read and write operations per second
+  - Small file create and delete rate
+  - Directory listing time
+  - Latency of QSPIFile::flush() (fs_sync) after a small write
+
+  Every test cleans up after itself. Run it on an empty or mostly empty
+  partition for repeatable results.
+
+  This example code is in the public domain.
+*/
+
+#include <QSPIStorage.h>
+
+QSPIStorage storage;
+
+const char* BENCH_FOLDER = "/storage/bench";
+const char* BENCH_FILE = "/storage/bench/seq.bin";
+
+const size_t SEQ_FILE_SIZE = 1024 * 1024;
+const size_t CHUNK_SIZES[] = {256, 1024, 4096, 16384};
+const size_t RANDOM_BLOCK = 4096;
+const uint32_t RANDOM_OPS = 200;
+const uint32_t SMALL_FILES = 100;
+const uint32_t SYNC_ROUNDS = 100;
+
+static uint8_t buffer[16384];
+
+// Small deterministic generator so runs are comparable
+uint32_t lcgState = 1;
+uint32_t nextRandom() {
+    lcgState = lcgState * 1664525UL + 1013904223UL;
+    return lcgState >> 8;
+}
+
+void printRate(const char* label, float value, const char* unit) {
+    Serial.print(label);
+    Serial.print(value, 2);
+    Serial.print(" ");
+    Serial.println(unit);
+}
+
+float megabytesPerSecond(size_t bytes, uint32_t us) {
+    return us > 0 ? (bytes / 1048576.0f) / (us / 1000000.0f) : 0.0f;
+}
+
+bool writeSequential(size_t chunk, uint32_t& elapsed) {
+    QSPIFile file(BENCH_FILE);
+    file.remove();
+    if (!file.open(FileMode::WRITE)) {
+        return false;
+    }
+
+    uint32_t start = micros();
+    for (size_t done = 0; done < SEQ_FILE_SIZE; done += chunk) {
+        if (file.write(buffer, chunk) != chunk) {
+            file.close();
+            return false;
+        }
+    }
+    // Include the final commit, otherwise small chunks look faster than they are
+    bool ok = file.close();
+    elapsed = micros() - start;
+    return ok;
+}
+
+bool readSequential(size_t chunk, uint32_t& elapsed) {
+    QSPIFile file(BENCH_FILE);
+    if (!file.open(FileMode::READ)) {
+        return false;
+    }
+
+    uint32_t start = micros();
+    for (size_t done = 0; done < SEQ_FILE_SIZE; done += chunk) {
+        if (file.read(buffer, chunk) != chunk) {
+            file.close();
+            return false;
+        }
+    }
+    elapsed = micros() - start;
+    file.close();
+    return true;
+}
+
+void benchmarkSequential() {
+    Serial.println("Sequential (1 MB file)");
+    Serial.println("  Chunk     Write MB/s   Read MB/s");
+
+    for (size_t i = 0; i < sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]); i++) {
+        size_t chunk = CHUNK_SIZES[i];
+        uint32_t writeUs = 0;
+        uint32_t readUs = 0;
+
+        bool ok = writeSequential(chunk, writeUs) && readSequential(chunk, readUs);
+
+        Serial.print("  ");
+        Serial.print(chunk);
+        Serial.print(chunk < 1000 ? "\t\t" : "\t");
+        if (!ok) {
+            Serial.println("failed");
+            continue;
+        }
+        Serial.print(megabytesPerSecond(SEQ_FILE_SIZE, writeUs), 3);
+        Serial.print("\t     ");
+        Serial.println(megabytesPerSecond(SEQ_FILE_SIZE, readUs), 3);
+    }
+}
+
+void benchmarkRandom() {
+    // Reuses the file left by the sequential test
+    QSPIFile file(BENCH_FILE);
+    if (!file.open(FileMode::READ_WRITE)) {
+        Serial.println("Random 4 KB: failed to open file");
+        return;
+    }
+
+    size_t blocks = SEQ_FILE_SIZE / RANDOM_BLOCK;
+
+    lcgState = 1;
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < RANDOM_OPS; i++) {
+        file.seek((nextRandom() % blocks) * RANDOM_BLOCK);
+        file.read(buffer, RANDOM_BLOCK);
+    }
+    uint32_t readUs = micros() - start;
+
+    lcgState = 1;
+    start = micros();
+    for (uint32_t i = 0; i < RANDOM_OPS; i++) {
+        file.seek((nextRandom() % blocks) * RANDOM_BLOCK);
+        file.write(buffer, RANDOM_BLOCK);
+    }
+    file.flush();
+    uint32_t writeUs = micros() - start;
+
+    file.close();
+    file.remove();
+
+    Serial.println("Random 4 KB");
+    printRate("  Read IOPS:       ", RANDOM_OPS / (readUs / 1000000.0f), "");
+    printRate("  Write IOPS:      ", RANDOM_OPS / (writeUs / 1000000.0f), "");
+}
+
+void benchmarkSmallFiles() {
+    char path[64];
+    const char* content = "benchmark small file payload\n";
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < SMALL_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/f%03lu.txt", BENCH_FOLDER, (unsigned long)i);
+        QSPIFile file(path);
+        file.open(FileMode::WRITE);
+        file.write(content);
+        file.close();
+    }
+    uint32_t createUs = micros() - start;
+
+    start = micros();
+    size_t listed = 0;
+    for (auto& entry : QSPIFolder(BENCH_FOLDER).entries(QSPIEntryType::FILES)) {
+        (void)entry;
+        listed++;
+    }
+    uint32_t listUs = micros() - start;
+
+    start = micros();
+    for (uint32_t i = 0; i < SMALL_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/f%03lu.txt", BENCH_FOLDER, (unsigned long)i);
+        QSPIFile(path).remove();
+    }
+    uint32_t deleteUs = micros() - start;
+
+    Serial.println("Small files");
+    printRate("  Create files/s:  ", SMALL_FILES / (createUs / 1000000.0f), "");
+    printRate("  Delete files/s:  ", SMALL_FILES / (deleteUs / 1000000.0f), "");
+    Serial.print("  List ");
+    Serial.print(listed);
+    Serial.print(" entries: ");
+    Serial.print(listUs / 1000.0f, 2);
+    Serial.println(" ms");
+}
+
+void benchmarkSync() {
+    QSPIFile file("/storage/bench/sync.bin");
+    file.remove();
+    if (!file.open(FileMode::WRITE)) {
+        Serial.println("Sync latency: failed to open file");
+        return;
+    }
+
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+
+    for (uint32_t i = 0; i < SYNC_ROUNDS; i++) {
+        file.write(buffer, 64);
+        uint32_t t0 = micros();
+        file.flush();
+        uint32_t elapsed = micros() - t0;
+        totalUs += elapsed;
+        if (elapsed > maxUs) {
+            maxUs = elapsed;
+        }
+    }
+
+    file.close();
+    file.remove();
+
+    Serial.println("Sync after 64 byte write");
+    printRate("  Average:         ", (totalUs / SYNC_ROUNDS) / 1000.0f, "ms");
+    printRate("  Worst:           ", maxUs / 1000.0f, "ms");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+
+    Serial.println("QSPIStorage - Storage Benchmark\n");
+
+    StorageError error;
+    if (!storage.begin(&error)) {
+        Serial.print("Storage initialization failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    size_t total, used, available;
+    if (storage.getStorageInfo(total, used, available)) {
+        Serial.print("Partition: ");
+        Serial.print(total / 1024);
+        Serial.print(" KB, used ");
+        Serial.print(used / 1024);
+        Serial.println(" KB\n");
+    }
+
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)i;
+    }
+
+    QSPIFolder folder(BENCH_FOLDER);
+    folder.remove(true);
+    if (!folder.create(&error)) {
+        Serial.print("Failed to create benchmark folder: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    benchmarkSequential();
+    Serial.println();
+    benchmarkRandom();
+    Serial.println();
+    benchmarkSmallFiles();
+    Serial.println();
+    benchmarkSync();
+
+    folder.remove(true);
+    Serial.println("\nDone!");
+}
+
+void loop() {
+    delay(10000);
+}
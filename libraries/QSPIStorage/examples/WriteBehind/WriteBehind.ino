@@ -0,0 +1,126 @@
+/*
+  QSPIStorage - Write-Behind Example
+
+  Shows how write-behind mode keeps flash erase and program time out of a
+  time-critical loop. A 1 kHz loop logs a sample every iteration, first
+  with normal synchronous writes and then with enableWriteBehind(), and
+  reports the slowest iteration of each run.
+
+  With synchronous writes an occasional iteration stalls for the duration
+  of a sector erase. With write-behind the loop only copies into a RAM
+  queue, and a low-priority storage thread writes to flash whenever the
+  loop sleeps.
+
+  This example code is in the public domain.
+*/
+
+#include <QSPIStorage.h>
+
+QSPIStorage storage;
+
+const uint32_t ITERATIONS = 5000;
+const uint32_t PERIOD_US = 1000;
+
+struct Sample {
+    uint32_t timestamp;
+    int16_t values[6];
+};
+
+void runLoop(const char* name, bool writeBehind) {
+    StorageError error;
+    QSPIFile file("/storage/samples.bin");
+    file.remove();
+
+    if (writeBehind && !file.enableWriteBehind(16 * 1024, nullptr, &error)) {
+        Serial.print("Failed to enable write-behind: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    if (!file.open(FileMode::WRITE, &error)) {
+        Serial.print("Failed to open file: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    uint32_t maxUs = 0;
+    uint32_t missed = 0;
+    uint32_t next = micros();
+
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        uint32_t t0 = micros();
+
+        Sample sample;
+        sample.timestamp = t0;
+        for (int k = 0; k < 6; k++) {
+            sample.values[k] = (int16_t)(i * (k + 1));
+        }
+        file.write((const uint8_t*)&sample, sizeof(sample));
+
+        uint32_t elapsed = micros() - t0;
+        if (elapsed > maxUs) {
+            maxUs = elapsed;
+        }
+        if (elapsed > PERIOD_US) {
+            missed++;
+        }
+
+        // Sleep until the next period so lower priority threads can run
+        next += PERIOD_US;
+        int32_t wait = (int32_t)(next - micros());
+        if (wait > 0) {
+            delayMicroseconds(wait);
+        }
+    }
+
+    // Wait until everything is on flash before reporting
+    uint32_t t0 = micros();
+    if (!file.flush(&error)) {
+        Serial.print("Flush failed: ");
+        Serial.println(error.getMessage());
+    }
+    uint32_t flushUs = micros() - t0;
+
+    Serial.print(name);
+    Serial.println(":");
+    Serial.print("  Slowest iteration: ");
+    Serial.print(maxUs);
+    Serial.println(" us");
+    Serial.print("  Missed periods:    ");
+    Serial.println(missed);
+    Serial.print("  Final flush:       ");
+    Serial.print(flushUs);
+    Serial.println(" us");
+    Serial.print("  File size:         ");
+    Serial.print(file.size());
+    Serial.println(" bytes");
+
+    file.close();
+    file.remove();
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+
+    Serial.println("QSPIStorage - Write-Behind Example\n");
+
+    StorageError error;
+    if (!storage.begin(&error)) {
+        Serial.print("Storage initialization failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    runLoop("Synchronous writes", false);
+    Serial.println();
+    runLoop("Write-behind", true);
+
+    Serial.println("\nDone!");
+}
+
+void loop() {
+    delay(10000);
+}
@@ -21,6 +21,29 @@ public:
 	ZephyrSocketWrapper(int sock_fd) : sock_fd(sock_fd) {
 	}
 
+	ZephyrSocketWrapper(const ZephyrSocketWrapper &) = default;
+	ZephyrSocketWrapper &operator=(const ZephyrSocketWrapper &) = default;
+
+	// Moving hands the socket over, so it is closed only once
+	ZephyrSocketWrapper(ZephyrSocketWrapper &&other)
+		: sock_fd(other.sock_fd), is_ssl(other.is_ssl),
+		  ssl_sock_temp_char(other.ssl_sock_temp_char) {
+		other.sock_fd = -1;
+		other.ssl_sock_temp_char = -1;
+	}
+
+	ZephyrSocketWrapper &operator=(ZephyrSocketWrapper &&other) {
+		if (this != &other) {
+			close();
+			sock_fd = other.sock_fd;
+			is_ssl = other.is_ssl;
+			ssl_sock_temp_char = other.ssl_sock_temp_char;
+			other.sock_fd = -1;
+			other.ssl_sock_temp_char = -1;
+		}
+		return *this;
+	}
+
 	~ZephyrSocketWrapper() {
 		if (sock_fd != -1) {
 			::close(sock_fd);
@@ -0,0 +1,522 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "StaticStorage.h"
+
+#include <zephyr/fs/fs.h>
+#include <zephyr/storage/flash_map.h>
+#include <errno.h>
+#include <cstring>
+
+// Mounts created by the devicetree fstab, all exported to sketches by the
+// loader
+#define STATIC_STORAGE_DECLARE_MOUNT(node) FS_FSTAB_DECLARE_ENTRY(node);
+DT_FOREACH_STATUS_OKAY(zephyr_fstab_littlefs, STATIC_STORAGE_DECLARE_MOUNT)
+DT_FOREACH_STATUS_OKAY(zephyr_fstab_fatfs, STATIC_STORAGE_DECLARE_MOUNT)
+
+struct MountEntry {
+    struct fs_mount_t* mount;
+    int type;           // FS_LITTLEFS or FS_FATFS
+    int partitionId;    // Flash partition, -1 if it comes from a flash disk
+};
+
+#define STATIC_STORAGE_LITTLEFS_MOUNT(node) \
+    { &FS_FSTAB_ENTRY(node), FS_LITTLEFS, DT_FIXED_PARTITION_ID(DT_PROP(node, partition)) },
+#define STATIC_STORAGE_FAT_MOUNT(node) \
+    { &FS_FSTAB_ENTRY(node), FS_FATFS, -1 },
+
+static const MountEntry mounts[] = {
+    DT_FOREACH_STATUS_OKAY(zephyr_fstab_littlefs, STATIC_STORAGE_LITTLEFS_MOUNT)
+    DT_FOREACH_STATUS_OKAY(zephyr_fstab_fatfs, STATIC_STORAGE_FAT_MOUNT)
+    { nullptr, 0, -1 }
+};
+
+// FAT volumes sit on flash disks, which name the partition they use
+struct DiskEntry {
+    const char* name;
+    int partitionId;
+};
+
+#define STATIC_STORAGE_DISK(node) \
+    { DT_PROP(node, disk_name), DT_FIXED_PARTITION_ID(DT_PHANDLE(node, partition)) },
+
+static const DiskEntry disks[] = {
+    DT_FOREACH_STATUS_OKAY(zephyr_flash_disk, STATIC_STORAGE_DISK)
+    { nullptr, -1 }
+};
+
+#if DT_NODE_EXISTS(DT_NODELABEL(mbr_partition))
+#define STATIC_STORAGE_HAS_MBR 1
+
+// Partitions next to the MBR, to give table entries their labels
+struct LabelEntry {
+    const char* label;
+    size_t offset;
+};
+
+#define STATIC_STORAGE_LABEL(node) { DT_PROP_OR(node, label, nullptr), DT_REG_ADDR(node) },
+
+static const LabelEntry labels[] = {
+    DT_FOREACH_CHILD_STATUS_OKAY(DT_PARENT(DT_NODELABEL(mbr_partition)), STATIC_STORAGE_LABEL)
+    { nullptr, 0 }
+};
+#endif
+
+// The MBR uses 4 KB blocks instead of 512 byte sectors, like the layout
+// written by the original Arduino flash format sketches
+struct __attribute__((packed)) MbrEntry {
+    uint8_t status;
+    uint8_t chsStart[3];
+    uint8_t type;
+    uint8_t chsStop[3];
+    uint32_t lbaOffset;
+    uint32_t lbaSize;
+};
+
+static constexpr size_t MBR_SIZE = 512;
+static constexpr size_t MBR_TABLE_OFFSET = 446;
+static constexpr uint8_t MBR_TYPE_FAT32 = 0x0B;
+
+// quickFormat() erases one 64 KB block, enough to drop the LittleFS
+// superblocks and the FAT boot sector
+static constexpr size_t QUICK_ERASE_SIZE = 64 * 1024;
+
+static void setError(StorageError* error, StorageErrorCode code, const char* message) {
+    if (error) {
+        error->setError(code, message);
+    }
+}
+
+static StorageErrorCode mapZephyrError(int err) {
+    switch (-err) {
+        case ENOENT:
+            return StorageErrorCode::FILE_NOT_FOUND;
+        case ENOSPC:
+            return StorageErrorCode::STORAGE_FULL;
+        case EINVAL:
+            return StorageErrorCode::INVALID_OPERATION;
+        case ENOMEM:
+            return StorageErrorCode::OUT_OF_MEMORY;
+        default:
+            return StorageErrorCode::HARDWARE_ERROR;
+    }
+}
+
+static const MountEntry* findMount(const char* mountPoint, StorageError* error) {
+    if (mountPoint != nullptr) {
+        size_t length = strlen(mountPoint);
+        // Accept "/storage/" for "/storage"
+        if (length > 1 && mountPoint[length - 1] == '/') {
+            length--;
+        }
+
+        for (const MountEntry* entry = mounts; entry->mount != nullptr; entry++) {
+            const char* mnt = entry->mount->mnt_point;
+            if (strlen(mnt) == length && strncmp(mnt, mountPoint, length) == 0) {
+                return entry;
+            }
+        }
+    }
+
+    setError(error, StorageErrorCode::INVALID_PATH, "Unknown mount point");
+    return nullptr;
+}
+
+static int partitionOf(const MountEntry* entry) {
+    if (entry->partitionId >= 0) {
+        return entry->partitionId;
+    }
+
+    // "/wlan:" is the FAT volume on disk "wlan"
+    const char* name = entry->mount->mnt_point + 1;
+    size_t length = strcspn(name, ":");
+    for (const DiskEntry* disk = disks; disk->name != nullptr; disk++) {
+        if (strlen(disk->name) == length && strncmp(disk->name, name, length) == 0) {
+            return disk->partitionId;
+        }
+    }
+    return -1;
+}
+
+static bool isMounted(const MountEntry* entry) {
+    struct fs_statvfs stat;
+    return fs_statvfs(entry->mount->mnt_point, &stat) == 0;
+}
+
+static bool eraseArea(int partitionId, size_t length, StorageError* error) {
+    const struct flash_area* area;
+    if (flash_area_open(partitionId, &area) != 0) {
+        setError(error, StorageErrorCode::HARDWARE_ERROR, "Failed to open partition");
+        return false;
+    }
+
+    if (length == 0 || length > area->fa_size) {
+        length = area->fa_size;
+    }
+
+    // flatten() erases with the largest erase unit the driver supports and
+    // also works on devices that need no erase
+    int ret = flash_area_flatten(area, 0, length);
+    flash_area_close(area);
+
+    if (ret < 0) {
+        setError(error, mapZephyrError(ret), "Failed to erase partition");
+        return false;
+    }
+    return true;
+}
+
+static bool formatMount(const MountEntry* entry, FilesystemType fsType, bool full, StorageError* error) {
+    if (fsType == FilesystemType::EXT2 ||
+        (fsType == FilesystemType::LITTLEFS && entry->type != FS_LITTLEFS) ||
+        (fsType == FilesystemType::FAT && entry->type != FS_FATFS)) {
+        setError(error, StorageErrorCode::INVALID_OPERATION,
+                 "Mount point is configured for another filesystem");
+        return false;
+    }
+
+    int partitionId = partitionOf(entry);
+    if (partitionId < 0) {
+        setError(error, StorageErrorCode::INVALID_OPERATION, "Mount point has no flash partition");
+        return false;
+    }
+
+    struct fs_mount_t* mount = entry->mount;
+    if (isMounted(entry)) {
+        int ret = fs_unmount(mount);
+        if (ret < 0) {
+            setError(error, mapZephyrError(ret), "Failed to unmount");
+            return false;
+        }
+    }
+
+    if (!eraseArea(partitionId, full ? 0 : QUICK_ERASE_SIZE, error)) {
+        return false;
+    }
+
+    int ret;
+    if (entry->type == FS_LITTLEFS) {
+        // Format with the geometry the fstab entry mounts with
+        ret = fs_mkfs(FS_LITTLEFS, partitionId, mount->fs_data, 0);
+    } else {
+        // FAT volumes are addressed by drive name, "wlan:" for "/wlan:"
+        ret = fs_mkfs(FS_FATFS, reinterpret_cast<uintptr_t>(mount->mnt_point + 1), nullptr, 0);
+    }
+    if (ret < 0) {
+        setError(error, mapZephyrError(ret), "Failed to create filesystem");
+        return false;
+    }
+
+    ret = fs_mount(mount);
+    if (ret < 0) {
+        setError(error, mapZephyrError(ret), "Failed to mount");
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef STATIC_STORAGE_HAS_MBR
+static const char* labelAt(size_t offset) {
+    for (const LabelEntry* entry = labels; entry->label != nullptr; entry++) {
+        if (entry->offset == offset) {
+            return entry->label;
+        }
+    }
+    return nullptr;
+}
+
+static size_t offsetOf(const char* label) {
+    for (const LabelEntry* entry = labels; entry->label != nullptr; entry++) {
+        if (strcmp(entry->label, label) == 0) {
+            return entry->offset;
+        }
+    }
+    return SIZE_MAX;
+}
+
+// CHS fields as the original MBR writer filled them, so unchanged tables
+// compare equal byte for byte
+static void toChs(uint32_t lba, uint8_t chs[3]) {
+    uint32_t sector = (lba < 0xFFFFFD ? lba : 0xFFFFFD) + 1;
+    chs[0] = (sector >> 6) & 0xFF;
+    chs[1] = (sector & 0x3F) | ((sector >> 16) & 0xC0);
+    chs[2] = (sector >> 14) & 0xFF;
+}
+
+static bool buildMbr(const PartitionInfo* partitions, size_t count, size_t firstOffset,
+                     uint8_t* sector, StorageError* error) {
+    if (count > StaticStorage::MAX_PARTITIONS || (count > 0 && partitions == nullptr)) {
+        setError(error, StorageErrorCode::INVALID_OPERATION, "Too many partitions");
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const PartitionInfo& p = partitions[i];
+        if (p.size == 0 || p.offset % StaticStorage::PARTITION_ALIGNMENT != 0 ||
+            p.size % StaticStorage::PARTITION_ALIGNMENT != 0 || p.offset < firstOffset) {
+            setError(error, StorageErrorCode::INVALID_OPERATION, "Invalid partition offset or size");
+            return false;
+        }
+        for (size_t j = 0; j < i; j++) {
+            const PartitionInfo& q = partitions[j];
+            if (p.offset < q.offset + q.size && q.offset < p.offset + p.size) {
+                setError(error, StorageErrorCode::INVALID_OPERATION, "Partitions overlap");
+                return false;
+            }
+        }
+    }
+
+    memset(sector, 0, MBR_SIZE);
+    MbrEntry* table = reinterpret_cast<MbrEntry*>(sector + MBR_TABLE_OFFSET);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t lbaOffset = partitions[i].offset / StaticStorage::PARTITION_ALIGNMENT;
+        uint32_t lbaSize = partitions[i].size / StaticStorage::PARTITION_ALIGNMENT;
+        table[i].type = MBR_TYPE_FAT32;
+        table[i].lbaOffset = lbaOffset;
+        table[i].lbaSize = lbaSize;
+        toChs(lbaOffset, table[i].chsStart);
+        toChs(lbaOffset + lbaSize - 1, table[i].chsStop);
+    }
+    sector[MBR_SIZE - 2] = 0x55;
+    sector[MBR_SIZE - 1] = 0xAA;
+    return true;
+}
+
+// Writes the MBR unless it is already on flash; changed[i] tells whether
+// entry i differs from the previous table
+static bool writeMbr(const PartitionInfo* partitions, size_t count, bool* changed,
+                     StorageError* error) {
+    const struct flash_area* area;
+    if (flash_area_open(FIXED_PARTITION_ID(mbr_partition), &area) != 0) {
+        setError(error, StorageErrorCode::HARDWARE_ERROR, "Failed to open MBR partition");
+        return false;
+    }
+
+    uint8_t sector[MBR_SIZE];
+    uint8_t current[MBR_SIZE];
+    bool ok = buildMbr(partitions, count, area->fa_off + area->fa_size, sector, error);
+
+    if (ok) {
+        int ret = flash_area_read(area, 0, current, sizeof(current));
+        if (ret < 0) {
+            setError(error, mapZephyrError(ret), "Failed to read MBR");
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        bool valid = current[MBR_SIZE - 2] == 0x55 && current[MBR_SIZE - 1] == 0xAA;
+        for (size_t i = 0; i < StaticStorage::MAX_PARTITIONS && changed != nullptr; i++) {
+            size_t at = MBR_TABLE_OFFSET + i * sizeof(MbrEntry);
+            changed[i] = !valid || memcmp(sector + at, current + at, sizeof(MbrEntry)) != 0;
+        }
+
+        // A NOR sector can only be rewritten after an erase, so leave an
+        // identical table alone
+        if (memcmp(sector, current, sizeof(sector)) != 0) {
+            int ret = flash_area_flatten(area, 0, area->fa_size);
+            if (ret == 0) {
+                ret = flash_area_write(area, 0, sector, sizeof(sector));
+            }
+            if (ret < 0) {
+                setError(error, mapZephyrError(ret), "Failed to write MBR");
+                ok = false;
+            }
+        }
+    }
+
+    flash_area_close(area);
+    return ok;
+}
+#endif
+
+bool StaticStorage::format(const char* mountPoint, FilesystemType fsType, StorageError* error) {
+    const MountEntry* entry = findMount(mountPoint, error);
+    return entry != nullptr && formatMount(entry, fsType, true, error);
+}
+
+bool StaticStorage::format(const String& mountPoint, FilesystemType fsType, StorageError* error) {
+    return format(mountPoint.c_str(), fsType, error);
+}
+
+bool StaticStorage::quickFormat(const char* mountPoint, FilesystemType fsType, StorageError* error) {
+    const MountEntry* entry = findMount(mountPoint, error);
+    return entry != nullptr && formatMount(entry, fsType, false, error);
+}
+
+bool StaticStorage::needsFormatting(const char* mountPoint, StorageError* error) {
+    const MountEntry* entry = findMount(mountPoint, error);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    if (isMounted(entry)) {
+        return false;
+    }
+
+    // Probe without letting the filesystem format an empty partition itself
+    struct fs_mount_t* mount = entry->mount;
+    unsigned int flags = mount->flags;
+    mount->flags |= FS_MOUNT_FLAG_NO_FORMAT;
+    int ret = fs_mount(mount);
+    mount->flags = flags;
+
+    return ret < 0;
+}
+
+bool StaticStorage::createPartitions(const PartitionInfo* partitions, size_t count, StorageError* error) {
+#ifdef STATIC_STORAGE_HAS_MBR
+    return writeMbr(partitions, count, nullptr, error);
+#else
+    setError(error, StorageErrorCode::INVALID_OPERATION, "No MBR partition on this board");
+    return false;
+#endif
+}
+
+bool StaticStorage::listPartitions(std::vector<PartitionInfo>& partitions, StorageError* error) {
+    partitions.clear();
+
+#ifdef STATIC_STORAGE_HAS_MBR
+    const struct flash_area* area;
+    if (flash_area_open(FIXED_PARTITION_ID(mbr_partition), &area) != 0) {
+        setError(error, StorageErrorCode::HARDWARE_ERROR, "Failed to open MBR partition");
+        return false;
+    }
+
+    uint8_t sector[MBR_SIZE];
+    int ret = flash_area_read(area, 0, sector, sizeof(sector));
+    flash_area_close(area);
+
+    if (ret < 0) {
+        setError(error, mapZephyrError(ret), "Failed to read MBR");
+        return false;
+    }
+
+    if (sector[MBR_SIZE - 2] != 0x55 || sector[MBR_SIZE - 1] != 0xAA) {
+        setError(error, StorageErrorCode::STORAGE_NOT_FORMATTED, "No partition table");
+        return false;
+    }
+
+    MbrEntry table[MAX_PARTITIONS];
+    memcpy(table, sector + MBR_TABLE_OFFSET, sizeof(table));
+    for (size_t i = 0; i < MAX_PARTITIONS; i++) {
+        if (table[i].type == 0 || table[i].lbaSize == 0) {
+            continue;
+        }
+
+        PartitionInfo info;
+        info.offset = static_cast<size_t>(table[i].lbaOffset) * PARTITION_ALIGNMENT;
+        info.size = static_cast<size_t>(table[i].lbaSize) * PARTITION_ALIGNMENT;
+        info.label = labelAt(info.offset);
+        info.fsType = FilesystemType::AUTO;
+
+        // Report the filesystem of the mount point on this partition
+        for (const MountEntry* entry = mounts; entry->mount != nullptr; entry++) {
+            const struct flash_area* part;
+            int id = partitionOf(entry);
+            if (id >= 0 && flash_area_open(id, &part) == 0) {
+                if (static_cast<size_t>(part->fa_off) == info.offset) {
+                    info.fsType = entry->type == FS_LITTLEFS ? FilesystemType::LITTLEFS
+                                                             : FilesystemType::FAT;
+                }
+                flash_area_close(part);
+            }
+        }
+
+        partitions.push_back(info);
+    }
+
+    return true;
+#else
+    setError(error, StorageErrorCode::INVALID_OPERATION, "No MBR partition on this board");
+    return false;
+#endif
+}
+
+bool StaticStorage::getPartition(const char* label, PartitionInfo& info, StorageError* error) {
+#ifdef STATIC_STORAGE_HAS_MBR
+    size_t offset = label != nullptr ? offsetOf(label) : SIZE_MAX;
+
+    std::vector<PartitionInfo> partitions;
+    if (!listPartitions(partitions, error)) {
+        return false;
+    }
+
+    for (const PartitionInfo& p : partitions) {
+        if (p.offset == offset) {
+            info = p;
+            return true;
+        }
+    }
+
+    setError(error, StorageErrorCode::FILE_NOT_FOUND, "Partition not found");
+    return false;
+#else
+    setError(error, StorageErrorCode::INVALID_OPERATION, "No MBR partition on this board");
+    return false;
+#endif
+}
+
+bool StaticStorage::removePartitions(StorageError* error) {
+#ifdef STATIC_STORAGE_HAS_MBR
+    const struct flash_area* area;
+    if (flash_area_open(FIXED_PARTITION_ID(mbr_partition), &area) != 0) {
+        setError(error, StorageErrorCode::HARDWARE_ERROR, "Failed to open MBR partition");
+        return false;
+    }
+
+    int ret = flash_area_flatten(area, 0, area->fa_size);
+    flash_area_close(area);
+
+    if (ret < 0) {
+        setError(error, mapZephyrError(ret), "Failed to erase MBR");
+        return false;
+    }
+    return true;
+#else
+    setError(error, StorageErrorCode::INVALID_OPERATION, "No MBR partition on this board");
+    return false;
+#endif
+}
+
+bool StaticStorage::provision(const PartitionInfo* partitions, size_t count, StorageError* error) {
+#ifdef STATIC_STORAGE_HAS_MBR
+    bool changed[MAX_PARTITIONS];
+    if (!writeMbr(partitions, count, changed, error)) {
+        return false;
+    }
+
+    for (const MountEntry* entry = mounts; entry->mount != nullptr; entry++) {
+        int id = partitionOf(entry);
+        const struct flash_area* area;
+        if (id < 0 || flash_area_open(id, &area) != 0) {
+            continue;
+        }
+        size_t offset = static_cast<size_t>(area->fa_off);
+        flash_area_close(area);
+
+        for (size_t i = 0; i < count; i++) {
+            if (partitions[i].offset != offset) {
+                continue;
+            }
+
+            // Unchanged partitions that still mount keep their files
+            if (changed[i] || needsFormatting(entry->mount->mnt_point, nullptr)) {
+                if (!formatMount(entry, partitions[i].fsType, true, error)) {
+                    return false;
+                }
+            }
+            break;
+        }
+    }
+
+    return true;
+#else
+    setError(error, StorageErrorCode::INVALID_OPERATION, "No MBR partition on this board");
+    return false;
+#endif
+}
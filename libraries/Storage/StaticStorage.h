@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024 Arduino SA
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STATIC_STORAGE_H
+#define STATIC_STORAGE_H
+
+#include <Arduino.h>
+#include <ArduinoStorage.h>
+#include <vector>
+
+/**
+ * @class StaticStorage
+ * @brief Format and partition utilities that work on any mount point.
+ *
+ * All methods are static. Mount points are the ones created by the
+ * devicetree fstab, e.g. "/storage", "/wlan:" or "/ota:". Partition offsets
+ * and sizes in PartitionInfo are bytes from the start of the flash and must
+ * be multiples of PARTITION_ALIGNMENT; labels are the devicetree partition
+ * labels.
+ *
+ * Formatting erases flash in whole blocks through the flash map before the
+ * new filesystem is created, instead of writing the old filesystem empty.
+ * The partition table is an MBR in the "mbr" partition, compatible with the
+ * layout written by earlier sketches. It is only rewritten when an entry
+ * changes, so provisioning an already provisioned board does no flash
+ * writes at all.
+ *
+ * @code
+ * PartitionInfo layout[] = {
+ *     {"wlan",    0x001000, 0x0FF000, FilesystemType::FAT},
+ *     {"ota",     0x100000, 0x500000, FilesystemType::FAT},
+ *     {"kvs",     0x600000, 0x100000, FilesystemType::AUTO},
+ *     {"storage", 0x700000, 0x700000, FilesystemType::LITTLEFS},
+ * };
+ * StaticStorage::provision(layout, 4);
+ * @endcode
+ */
+class StaticStorage {
+public:
+    /// Granularity of partition offsets and sizes (the MBR block size)
+    static constexpr size_t PARTITION_ALIGNMENT = 4096;
+    /// Entries in the partition table
+    static constexpr size_t MAX_PARTITIONS = 4;
+
+    StaticStorage() = delete;
+
+    // ==================== Formatting ====================
+
+    /**
+     * @brief Erase a mount point and create an empty filesystem on it.
+     *
+     * The whole partition is erased with block erases, so no old data is
+     * left behind. The mount point is unmounted first and mounted again
+     * when done.
+     *
+     * @param mountPoint Mount point path (e.g. "/storage")
+     * @param fsType Filesystem to create, AUTO for the configured one
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    static bool format(const char* mountPoint, FilesystemType fsType = FilesystemType::AUTO,
+                       StorageError* error = nullptr);
+
+    /**
+     * @brief Erase a mount point and create an empty filesystem on it.
+     * @param mountPoint Mount point path as a String
+     * @param fsType Filesystem to create, AUTO for the configured one
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    static bool format(const String& mountPoint, FilesystemType fsType = FilesystemType::AUTO,
+                       StorageError* error = nullptr);
+
+    /**
+     * @brief Create an empty filesystem, erasing only the start of the partition.
+     *
+     * Old file contents stay on flash until they are overwritten.
+     *
+     * @param mountPoint Mount point path
+     * @param fsType Filesystem to create, AUTO for the configured one
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    static bool quickFormat(const char* mountPoint, FilesystemType fsType = FilesystemType::AUTO,
+                            StorageError* error = nullptr);
+
+    /**
+     * @brief Check whether a mount point holds no valid filesystem.
+     *
+     * A mount point that is not mounted yet is mounted if it can be.
+     *
+     * @param mountPoint Mount point path
+     * @param error Optional pointer to receive error details
+     * @return true if the mount point has to be formatted
+     */
+    static bool needsFormatting(const char* mountPoint, StorageError* error = nullptr);
+
+    // ==================== Partitioning ====================
+
+    /**
+     * @brief Write the partition table.
+     *
+     * Nothing is written when the table on flash already matches.
+     * Partition contents are not touched; use provision() to also format.
+     *
+     * @param partitions Partition definitions, at most MAX_PARTITIONS
+     * @param count Number of partitions
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    static bool createPartitions(const PartitionInfo* partitions, size_t count,
+                                 StorageError* error = nullptr);
+
+    /**
+     * @brief Read the partition table.
+     * @param partitions Receives one entry per used table slot
+     * @param error Optional pointer to receive error details
+     * @return true if a valid table was found
+     */
+    static bool listPartitions(std::vector<PartitionInfo>& partitions, StorageError* error = nullptr);
+
+    /**
+     * @brief Find a partition of the table by its devicetree label.
+     * @param label Partition label (e.g. "ota")
+     * @param info Receives the partition
+     * @param error Optional pointer to receive error details
+     * @return true if found
+     */
+    static bool getPartition(const char* label, PartitionInfo& info, StorageError* error = nullptr);
+
+    /**
+     * @brief Erase the partition table.
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    static bool removePartitions(StorageError* error = nullptr);
+
+    /**
+     * @brief Write the partition table and format what needs it.
+     *
+     * A partition with a mount point is formatted when its table entry
+     * changed or when it holds no valid filesystem; all others are left
+     * as they are. Partitions without a mount point are never formatted.
+     *
+     * @param partitions Partition definitions, at most MAX_PARTITIONS
+     * @param count Number of partitions
+     * @param error Optional pointer to receive error details
+     * @return true if successful, false otherwise
+     */
+    static bool provision(const PartitionInfo* partitions, size_t count, StorageError* error = nullptr);
+};
+
+#endif // STATIC_STORAGE_H
@@ -0,0 +1,61 @@
+/*
+   Provision
+
+   The sketch brings the board flash storage to the standard layout
+   without asking questions, e.g. on a production line:
+
+ * Partition 1  1MB: used for network certificates (FAT)
+ * Partition 2  5MB: OTA (FAT)
+ * Partition 3  1MB: Provisioning KVStore
+ * Partition 4  7MB: User data (LittleFS)
+
+ Only partitions whose table entry changed, or which hold no valid
+ filesystem, are formatted. On a board that is already provisioned
+ nothing is written and user data is kept.
+
+ This example code is in the public domain.
+ */
+
+#include <Arduino.h>
+#include <StaticStorage.h>
+
+PartitionInfo layout[] = {
+    {"wlan",    0x001000, 0x0FF000, FilesystemType::FAT},
+    {"ota",     0x100000, 0x500000, FilesystemType::FAT},
+    {"kvs",     0x600000, 0x100000, FilesystemType::AUTO},
+    {"storage", 0x700000, 0x700000, FilesystemType::LITTLEFS},
+};
+
+void setup() {
+    Serial.begin(115200);
+    for (unsigned long timeout = millis() + 2500; !Serial && millis() < timeout; delay(250));
+
+    Serial.println("Provisioning flash storage...");
+
+    StorageError error;
+    unsigned long start = millis();
+    if (!StaticStorage::provision(layout, 4, &error)) {
+        Serial.print("Provisioning failed: ");
+        Serial.println(error.getMessage());
+        return;
+    }
+
+    Serial.print("Done in ");
+    Serial.print(millis() - start);
+    Serial.println(" ms");
+
+    std::vector<PartitionInfo> partitions;
+    if (StaticStorage::listPartitions(partitions, &error)) {
+        for (auto& p : partitions) {
+            Serial.print("  ");
+            Serial.print(p.label ? p.label : "?");
+            Serial.print(": ");
+            Serial.print(p.size / 1024);
+            Serial.println(" KB");
+        }
+    }
+}
+
+void loop() {
+    delay(1000);
+}
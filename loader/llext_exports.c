@@ -7,6 +7,9 @@
 #include <stdlib.h>
 #include <math.h>
 #include <zephyr/kernel.h>
+#if defined(CONFIG_FILE_SYSTEM)
+#include <zephyr/fs/fs.h>
+#endif
 
 #define FORCE_EXPORT_SYM(name) \
        extern void name(void); \
@@ -126,6 +129,11 @@ FORCE_EXPORT_SYM(net_mgmt_event_wait_on_iface);
 #if defined(CONFIG_MBEDTLS)
 FORCE_EXPORT_SYM(tls_credential_add);
 FORCE_EXPORT_SYM(tls_credential_get);
+FORCE_EXPORT_SYM(mbedtls_sha256_init);
+FORCE_EXPORT_SYM(mbedtls_sha256_free);
+FORCE_EXPORT_SYM(mbedtls_sha256_starts);
+FORCE_EXPORT_SYM(mbedtls_sha256_update);
+FORCE_EXPORT_SYM(mbedtls_sha256_finish);
 #endif
 
 #if defined(CONFIG_WIFI)
@@ -284,6 +292,11 @@ FORCE_EXPORT_SYM(matrixPlay);
 FORCE_EXPORT_SYM(matrixGrayscaleWrite);
 FORCE_EXPORT_SYM(matrixSetGrayscaleBits);
 FORCE_EXPORT_SYM(matrixEnd);
+FORCE_EXPORT_SYM(matrixPlayAsync);
+FORCE_EXPORT_SYM(matrixPlaySequenceAsync);
+FORCE_EXPORT_SYM(matrixStop);
+FORCE_EXPORT_SYM(matrixIsPlaying);
+FORCE_EXPORT_SYM(matrixSetFrameCallback);
 #endif
 
 #if defined(CONFIG_FLASH)
@@ -291,9 +304,14 @@ FORCE_EXPORT_SYM(flash_area_open);
 FORCE_EXPORT_SYM(flash_area_read);
 FORCE_EXPORT_SYM(flash_area_write);
 FORCE_EXPORT_SYM(flash_area_erase);
+FORCE_EXPORT_SYM(flash_area_flatten);
 FORCE_EXPORT_SYM(flash_area_close);
 #endif
 
+#if defined(CONFIG_CRC)
+FORCE_EXPORT_SYM(crc32_ieee_update);
+#endif
+
 #if defined(CONFIG_FILE_SYSTEM)
 FORCE_EXPORT_SYM(fs_open);
 FORCE_EXPORT_SYM(fs_close);
@@ -319,4 +337,20 @@ FORCE_EXPORT_SYM(fs_mkfs);
 #endif
 FORCE_EXPORT_SYM(fs_register);
 FORCE_EXPORT_SYM(fs_unregister);
+
+/*
+ * Devicetree fstab mounts are data with generated names; the name has to
+ * be expanded before EXPORT_SYMBOL pastes it.
+ */
+#define EXPORT_FSTAB_SYMBOL(name) EXPORT_SYMBOL(name)
+#define EXPORT_FSTAB_ENTRY(node) \
+       FS_FSTAB_DECLARE_ENTRY(node); \
+       EXPORT_FSTAB_SYMBOL(FS_FSTAB_ENTRY(node));
+
+#if defined(CONFIG_FILE_SYSTEM_LITTLEFS)
+DT_FOREACH_STATUS_OKAY(zephyr_fstab_littlefs, EXPORT_FSTAB_ENTRY)
+#endif
+#if defined(CONFIG_FAT_FILESYSTEM_ELM)
+DT_FOREACH_STATUS_OKAY(zephyr_fstab_fatfs, EXPORT_FSTAB_ENTRY)
+#endif
 #endif